@@ -0,0 +1,74 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+
+// external headers -------------------------------------
+#include <fmt/format.h>
+
+namespace mbase::benchmark {
+
+using Clock = std::chrono::steady_clock;
+
+/// Keeps the compiler from discarding `value` or the computation producing it.
+template<class T>
+inline void DoNotOptimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static_cast<void>(*static_cast<char const volatile*>(static_cast<void const*>(&value)));
+#endif
+}
+
+/// Seconds elapsed since `start`.
+[[nodiscard]] inline double SecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// Nanoseconds per iteration of `function(iteration_count)`, which must run `iteration_count` iterations; the best of
+/// `repeat_count` runs, to filter out preemption and frequency ramp-up.
+template<class TFunction>
+[[nodiscard]] double NanosecondsPerIteration(size_t iteration_count, TFunction&& function, int repeat_count = 5) {
+  double best = 1e300;
+  for (int i = 0; i < repeat_count; ++i) {
+    auto const start = Clock::now();
+    function(iteration_count);
+    best = std::min(best, SecondsSince(start));
+  }
+  return best * 1e9 / static_cast<double>(iteration_count);
+}
+
+/// `xorshift64*`: cheap enough not to dominate the loops it feeds.
+class Random final {
+public:
+  explicit Random(uint64_t seed = 0x9E3779B97F4A7C15ull) noexcept : state_(seed | 1) {}
+
+  uint64_t operator()() noexcept {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return state_ * 0x2545F4914F6CDD1Dull;
+  }
+
+private:
+  uint64_t state_;
+};
+
+/// Value of the environment variable `name`, parsed as an unsigned integer; `fallback` if unset. Lets a run scale
+/// the problem sizes down (e.g. in CI) or up without rebuilding.
+[[nodiscard]] inline size_t EnvironmentOr(char const* name, size_t fallback) {
+  char const* value = std::getenv(name);
+  return value != nullptr ? static_cast<size_t>(std::strtoull(value, nullptr, 10)) : fallback;
+}
+
+inline void PrintHeader(std::string_view title) {
+  fmt::print("\n== {} ==\n", title);
+}
+
+} // namespace mbase::benchmark
@@ -0,0 +1,131 @@
+// Throughput of `ConcurrentHashMap` against a `FlatHashMap` behind one `std::shared_mutex`, at 1 to 64 threads, for a
+// read-mostly and a write-heavy mix of operations over a shared key range.
+//
+// MBASE_BENCHMARK_OPS: operations per thread (default 1000000).
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+// public project headers -------------------------------
+#include "mbase/public/container/concurrent_hash_map.h"
+#include "mbase/public/container/flat_hash_map.h"
+
+#include "benchmark.h"
+
+namespace {
+
+using namespace mbase::benchmark;
+
+constexpr uint64_t kKeyCount = 1 << 16;
+
+/// The baseline: every operation takes the one lock.
+class SingleLockMap final {
+public:
+  bool find(uint64_t key, uint64_t& value) const {
+    std::shared_lock lock(mutex_);
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+  void insert_or_assign(uint64_t key, uint64_t value) {
+    std::lock_guard lock(mutex_);
+    map_.insert_or_assign(key, value);
+  }
+
+private:
+  mutable std::shared_mutex mutex_;
+  mbase::FlatHashMap<uint64_t, uint64_t> map_;
+};
+
+class ShardedMap final {
+public:
+  bool find(uint64_t key, uint64_t& value) const {
+    auto found = map_.find(key);
+    if (!found) {
+      return false;
+    }
+    value = *found;
+    return true;
+  }
+  void insert_or_assign(uint64_t key, uint64_t value) {
+    map_.insert_or_assign(key, value);
+  }
+
+private:
+  mbase::ConcurrentHashMap<uint64_t, uint64_t> map_;
+};
+
+/// Millions of operations per second over all threads, `write_percent` of them writes.
+template<class TMap>
+double Run(size_t thread_count, size_t ops_per_thread, uint64_t write_percent) {
+  TMap map;
+  for (uint64_t key = 0; key < kKeyCount; key += 2) {
+    map.insert_or_assign(key, key);
+  }
+
+  std::atomic<size_t> ready = 0;
+  std::atomic<bool> go = false;
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (size_t t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&, t] {
+      Random random(t + 1);
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+
+      uint64_t hits = 0;
+      for (size_t i = 0; i < ops_per_thread; ++i) {
+        uint64_t const r = random();
+        uint64_t const key = r % kKeyCount;
+        if ((r >> 32) % 100 < write_percent) {
+          map.insert_or_assign(key, r);
+        }
+        else {
+          uint64_t value = 0;
+          hits += map.find(key, value) ? 1 : 0;
+        }
+      }
+      DoNotOptimize(hits);
+    });
+  }
+
+  while (ready.load() != thread_count) {
+    std::this_thread::yield();
+  }
+  auto const start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return static_cast<double>(thread_count * ops_per_thread) / SecondsSince(start) / 1e6;
+}
+
+} // namespace
+
+int main() {
+  size_t const ops_per_thread = EnvironmentOr("MBASE_BENCHMARK_OPS", 1000000);
+  fmt::print("hardware threads: {}, keys: {}, operations per thread: {}\n", std::thread::hardware_concurrency(), kKeyCount, ops_per_thread);
+
+  for (uint64_t write_percent : { 5, 50 }) {
+    PrintHeader(fmt::format("{}% writes, Mops/s", write_percent));
+    fmt::print("{:>8} {:>14} {:>18} {:>8}\n", "threads", "single lock", "ConcurrentHashMap", "ratio");
+    for (size_t thread_count = 1; thread_count <= 64; thread_count *= 2) {
+      double const single = Run<SingleLockMap>(thread_count, ops_per_thread, write_percent);
+      double const sharded = Run<ShardedMap>(thread_count, ops_per_thread, write_percent);
+      fmt::print("{:>8} {:>14.2f} {:>18.2f} {:>8.2f}\n", thread_count, single, sharded, sharded / single);
+    }
+  }
+  return 0;
+}
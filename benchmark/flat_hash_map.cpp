@@ -0,0 +1,100 @@
+// `FlatHashMap` against `std::unordered_map`, both hashing with `Hash64` so that only the table layout differs:
+// nanoseconds per insert into an empty map, per lookup of a present key, and per lookup of an absent key, for
+// 1K to 100M random 64-bit keys.
+//
+// MBASE_BENCHMARK_MAX_KEYS: largest key count (default 100000000; at that size each map takes several GiB).
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+// public project headers -------------------------------
+#include "mbase/public/hash.h"
+#include "mbase/public/container/flat_hash_map.h"
+
+#include "benchmark.h"
+
+namespace {
+
+using namespace mbase::benchmark;
+
+struct Result final {
+  double insert_ns;
+  double hit_ns;
+  double miss_ns;
+};
+
+template<class TMap>
+Result Run(std::vector<uint64_t> const& keys, std::vector<uint64_t> const& hit_keys, std::vector<uint64_t> const& miss_keys) {
+  Result result {};
+
+  // Every insert run needs a map of its own, destroyed outside the timed region; large sizes run once.
+  std::vector<TMap> maps(keys.size() <= 1000000 ? 3 : 1);
+  result.insert_ns = 1e300;
+  for (TMap& fresh : maps) {
+    auto const start = Clock::now();
+    for (uint64_t key : keys) {
+      fresh.emplace(key, key);
+    }
+    result.insert_ns = std::min(result.insert_ns, SecondsSince(start) * 1e9 / static_cast<double>(keys.size()));
+  }
+  TMap const& map = maps.back();
+
+  auto const lookup = [&map](std::vector<uint64_t> const& lookup_keys) {
+    return [&map, &lookup_keys](size_t count) {
+      uint64_t sum = 0;
+      for (size_t i = 0; i < count; ++i) {
+        auto it = map.find(lookup_keys[i]);
+        sum += it != map.end() ? it->second : 1;
+      }
+      DoNotOptimize(sum);
+    };
+  };
+  result.hit_ns = NanosecondsPerIteration(hit_keys.size(), lookup(hit_keys), 3);
+  result.miss_ns = NanosecondsPerIteration(miss_keys.size(), lookup(miss_keys), 3);
+  return result;
+}
+
+} // namespace
+
+int main() {
+  size_t const max_key_count = EnvironmentOr("MBASE_BENCHMARK_MAX_KEYS", 100000000);
+  // Enough lookups per run to time small maps reliably; every key once for large ones.
+  constexpr size_t kMinLookupCount = 1 << 20;
+
+  using FlatMap = mbase::FlatHashMap<uint64_t, uint64_t>;
+  using StdMap = std::unordered_map<uint64_t, uint64_t, mbase::Hash64>;
+
+  PrintHeader("ns per operation");
+  fmt::print("{:>10} | {:^26} | {:^26}\n", "", "FlatHashMap", "std::unordered_map");
+  fmt::print("{:>10} | {:>8} {:>8} {:>8} | {:>8} {:>8} {:>8}\n", "keys", "insert", "hit", "miss", "insert", "hit", "miss");
+
+  for (size_t key_count = 1000; key_count <= max_key_count; key_count *= 10) {
+    Random random(key_count);
+    std::vector<uint64_t> keys(key_count);
+    for (uint64_t& key : keys) {
+      key = random();
+    }
+
+    size_t const lookup_count = std::max(key_count, kMinLookupCount);
+    std::vector<uint64_t> hit_keys(lookup_count);
+    std::vector<uint64_t> miss_keys(lookup_count);
+    for (size_t i = 0; i < lookup_count; ++i) {
+      hit_keys[i] = keys[random() % key_count];
+      // Fresh random keys: one colliding with `keys` is vanishingly unlikely.
+      miss_keys[i] = random();
+    }
+
+    Result const flat = Run<FlatMap>(keys, hit_keys, miss_keys);
+    Result const std_map = Run<StdMap>(keys, hit_keys, miss_keys);
+    fmt::print(
+      "{:>10} | {:>8.1f} {:>8.1f} {:>8.1f} | {:>8.1f} {:>8.1f} {:>8.1f}\n",
+      key_count, flat.insert_ns, flat.hit_ns, flat.miss_ns, std_map.insert_ns, std_map.hit_ns, std_map.miss_ns
+    );
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+// `InplaceFunction` and `FunctionRef` against `std::function` and a plain function pointer: ns per call through each,
+// ns to construct and destroy one holding a callable too large for `std::function`'s inline buffer, heap allocations
+// made doing so, and object sizes.
+//
+// MBASE_BENCHMARK_CALLS: calls per run (default 100000000).
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <atomic>
+#include <functional>
+#include <new>
+
+// public project headers -------------------------------
+#include "mbase/public/function.h"
+
+#include "benchmark.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+# define MBASE_BENCHMARK_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+# define MBASE_BENCHMARK_NOINLINE __declspec(noinline)
+#else
+# define MBASE_BENCHMARK_NOINLINE
+#endif
+
+namespace {
+
+std::atomic<size_t> g_allocation_count = 0;
+
+} // namespace
+
+// Counts heap allocations, to show which wrappers allocate.
+void* operator new(size_t size) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* block = std::malloc(size == 0 ? 1 : size)) {
+    return block;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* block) noexcept {
+  std::free(block);
+}
+void operator delete(void* block, size_t) noexcept {
+  std::free(block);
+}
+
+namespace {
+
+using namespace mbase::benchmark;
+
+using Signature = uint64_t(uint64_t, uint64_t);
+
+MBASE_BENCHMARK_NOINLINE uint64_t Combine(uint64_t accumulator, uint64_t value) {
+  return accumulator * 31 + value;
+}
+
+// Each loop lives in a non-inlined function taking the callable by reference, so that the call goes through the
+// wrapper instead of being resolved at compile time.
+
+MBASE_BENCHMARK_NOINLINE uint64_t CallPointer(Signature* function, size_t count) {
+  uint64_t accumulator = 0;
+  for (size_t i = 0; i < count; ++i) {
+    accumulator = function(accumulator, i);
+  }
+  return accumulator;
+}
+template<class TFunction>
+MBASE_BENCHMARK_NOINLINE uint64_t CallWrapper(TFunction const& function, size_t count) {
+  uint64_t accumulator = 0;
+  for (size_t i = 0; i < count; ++i) {
+    accumulator = function(accumulator, i);
+  }
+  return accumulator;
+}
+
+/// A callable capturing 32 bytes: more than `std::function` stores inline in the common implementations.
+struct LargeCallable final {
+  uint64_t state[4] = { 1, 2, 3, 4 };
+
+  uint64_t operator()(uint64_t accumulator, uint64_t value) const {
+    return Combine(accumulator, value + state[value & 3]);
+  }
+};
+
+/// ns to construct and destroy a `TFunction` from a `LargeCallable`, and the heap allocations that made.
+template<class TFunction>
+std::pair<double, size_t> ConstructLarge(size_t count) {
+  size_t const allocations_before = g_allocation_count.load();
+  double const ns = NanosecondsPerIteration(count, [](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      LargeCallable callable;
+      callable.state[0] = i;
+      TFunction function(callable);
+      DoNotOptimize(function);
+    }
+  }, 1);
+  return { ns, (g_allocation_count.load() - allocations_before) / count };
+}
+
+} // namespace
+
+int main() {
+  size_t const call_count = EnvironmentOr("MBASE_BENCHMARK_CALLS", 100000000);
+
+  using StdFunction = std::function<Signature>;
+  using InplaceFunction = mbase::InplaceFunction<Signature, sizeof(LargeCallable)>;
+  using FunctionRef = mbase::FunctionRef<Signature>;
+
+  PrintHeader("ns per call");
+  auto const report_call = [&](char const* name, auto run) {
+    fmt::print("{:<24} {:>8.3f}\n", name, NanosecondsPerIteration(call_count, [&](size_t n) { DoNotOptimize(run(n)); }, 3));
+  };
+  report_call("function pointer", [](size_t n) { return CallPointer(&Combine, n); });
+  StdFunction const std_function = &Combine;
+  report_call("std::function", [&](size_t n) { return CallWrapper(std_function, n); });
+  InplaceFunction const inplace_function = &Combine;
+  report_call("InplaceFunction", [&](size_t n) { return CallWrapper(inplace_function, n); });
+  FunctionRef const function_ref = Combine;
+  report_call("FunctionRef", [&](size_t n) { return CallWrapper(function_ref, n); });
+
+  PrintHeader(fmt::format("{}-byte capture", sizeof(LargeCallable)));
+  fmt::print("{:<24} {:>8} {:>14} {:>8}\n", "", "sizeof", "construct ns", "allocs");
+  size_t const construct_count = call_count / 10;
+  auto const [std_ns, std_allocations] = ConstructLarge<StdFunction>(construct_count);
+  fmt::print("{:<24} {:>8} {:>14.2f} {:>8}\n", "std::function", sizeof(StdFunction), std_ns, std_allocations);
+  auto const [inplace_ns, inplace_allocations] = ConstructLarge<InplaceFunction>(construct_count);
+  fmt::print("{:<24} {:>8} {:>14.2f} {:>8}\n", "InplaceFunction", sizeof(InplaceFunction), inplace_ns, inplace_allocations);
+  fmt::print("{:<24} {:>8} {:>14} {:>8}\n", "FunctionRef", sizeof(FunctionRef), "-", 0);
+  return 0;
+}
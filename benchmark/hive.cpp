@@ -0,0 +1,159 @@
+// `Hive` against the two usual alternatives for a pool of objects with churn: a `SmallVector` erasing by swapping the
+// last element into the hole (fast, but moves elements, so pointers to them do not stay valid), and `std::list`
+// (stable, but one allocation per element). Each simulates particles: every round updates all of them, erases the ones
+// whose life ran out during the pass, then inserts as many new ones. Reports ns per element to fill the pool, per
+// element and round of churn, and to iterate the pool once churn has left holes.
+//
+// MBASE_BENCHMARK_ELEMENTS: particles in the pool (default 100000).
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <list>
+
+// public project headers -------------------------------
+#include "mbase/public/container.h"
+#include "mbase/public/container/hive.h"
+
+#include "benchmark.h"
+
+namespace {
+
+using namespace mbase::benchmark;
+
+struct Particle final {
+  float position[3];
+  float velocity[3];
+  uint32_t life;
+};
+
+constexpr int kRoundCount = 50;
+constexpr uint32_t kMaxLife = 20;
+
+[[nodiscard]] Particle MakeParticle(Random& random) {
+  float const speed = static_cast<float>(random() % 100) * 0.01f;
+  return { { 0.0f, 0.0f, 0.0f }, { speed, -speed, speed * 0.5f }, 1 + static_cast<uint32_t>(random() % kMaxLife) };
+}
+
+/// Advances `particle`; returns `false` once its life ran out.
+[[nodiscard]] bool Update(Particle& particle) {
+  for (int i = 0; i < 3; ++i) {
+    particle.position[i] += particle.velocity[i];
+  }
+  return --particle.life != 0;
+}
+
+struct HiveAdapter final {
+  mbase::Hive<Particle> pool;
+
+  void insert(Particle const& particle) { pool.insert(particle); }
+  size_t update_and_erase_dead() {
+    size_t erased = 0;
+    for (auto it = pool.begin(); it != pool.end();) {
+      if (Update(*it)) {
+        ++it;
+      }
+      else {
+        it = pool.erase(it);
+        ++erased;
+      }
+    }
+    return erased;
+  }
+};
+
+struct SwapAndPopAdapter final {
+  mbase::SmallVector<Particle, 1> pool;
+
+  void insert(Particle const& particle) { pool.push_back(particle); }
+  size_t update_and_erase_dead() {
+    size_t erased = 0;
+    for (size_t i = 0; i < pool.size();) {
+      if (Update(pool[i])) {
+        ++i;
+      }
+      else {
+        // The last element, not yet updated this round, moves into the hole and is visited next.
+        pool[i] = pool.back();
+        pool.pop_back();
+        ++erased;
+      }
+    }
+    return erased;
+  }
+};
+
+struct ListAdapter final {
+  std::list<Particle> pool;
+
+  void insert(Particle const& particle) { pool.push_back(particle); }
+  size_t update_and_erase_dead() {
+    size_t erased = 0;
+    for (auto it = pool.begin(); it != pool.end();) {
+      if (Update(*it)) {
+        ++it;
+      }
+      else {
+        it = pool.erase(it);
+        ++erased;
+      }
+    }
+    return erased;
+  }
+};
+
+struct Result final {
+  double fill_ns;
+  double churn_ns;
+  double iterate_ns;
+};
+
+template<class TAdapter>
+Result Run(size_t element_count) {
+  Result result {};
+  Random random;
+  TAdapter adapter;
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < element_count; ++i) {
+    adapter.insert(MakeParticle(random));
+  }
+  result.fill_ns = SecondsSince(start) * 1e9 / static_cast<double>(element_count);
+
+  start = Clock::now();
+  for (int round = 0; round < kRoundCount; ++round) {
+    size_t const erased = adapter.update_and_erase_dead();
+    for (size_t i = 0; i < erased; ++i) {
+      adapter.insert(MakeParticle(random));
+    }
+  }
+  result.churn_ns = SecondsSince(start) * 1e9 / static_cast<double>(element_count * kRoundCount);
+
+  result.iterate_ns = NanosecondsPerIteration(element_count, [&adapter](size_t) {
+    float sum = 0.0f;
+    for (Particle const& particle : adapter.pool) {
+      sum += particle.position[0];
+    }
+    DoNotOptimize(sum);
+  });
+  return result;
+}
+
+void Print(char const* name, Result const& result) {
+  fmt::print("{:<22} {:>8.2f} {:>8.2f} {:>8.2f}\n", name, result.fill_ns, result.churn_ns, result.iterate_ns);
+}
+
+} // namespace
+
+int main() {
+  size_t const element_count = EnvironmentOr("MBASE_BENCHMARK_ELEMENTS", 100000);
+  fmt::print("particles: {}, rounds: {}, particle size: {} bytes\n", element_count, kRoundCount, sizeof(Particle));
+
+  PrintHeader("ns per element");
+  fmt::print("{:<22} {:>8} {:>8} {:>8}\n", "", "fill", "churn", "iterate");
+  Print("Hive", Run<HiveAdapter>(element_count));
+  Print("SmallVector swap+pop", Run<SwapAndPopAdapter>(element_count));
+  Print("std::list", Run<ListAdapter>(element_count));
+  return 0;
+}
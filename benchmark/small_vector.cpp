@@ -0,0 +1,226 @@
+// `SmallVector` and `StaticVector` with their statically dispatched (CRTP) `VectorBase`, against a reduced copy of the
+// previous design, in which `VectorBase` reached the storage through pure-virtual hooks: ns per element to push,
+// iterate and index. The previous design is measured both through the concrete `final` class, where the compiler can
+// devirtualize, and through a `VectorBase&`, as code accepting either vector had to use it.
+//
+// MBASE_BENCHMARK_ELEMENTS: elements per vector (default 4096, at most 65536).
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+// public project headers -------------------------------
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+
+#include "benchmark.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+# define MBASE_BENCHMARK_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+# define MBASE_BENCHMARK_NOINLINE __declspec(noinline)
+#else
+# define MBASE_BENCHMARK_NOINLINE
+#endif
+
+// Outside the anonymous namespace, as the previous classes were in a header: the compiler cannot assume it sees every
+// class deriving from `VectorBase`.
+namespace mbase::benchmark::virtual_dispatch {
+
+/// The previous `VectorBase`, reduced to what the benchmark uses.
+template<class TValue>
+class VectorBase {
+public:
+  using value_type = TValue;
+  using size_type = size_t;
+
+  value_type* begin() noexcept { return get_storage_pointer_impl(); }
+  value_type* end() noexcept { return get_storage_pointer_impl() + size_; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  value_type& operator[](size_type i) noexcept { return *(get_storage_pointer_impl() + i); }
+
+  void clear() noexcept { size_ = 0; }
+  void push_back(value_type const& value) {
+    ensure_size_impl(size_ + 1);
+    ::new(static_cast<void*>(end() - 1)) value_type(value);
+  }
+
+protected:
+  virtual ~VectorBase() = default;
+  [[nodiscard]] virtual value_type* get_storage_pointer_impl() = 0;
+  virtual void ensure_size_impl(size_type new_size) = 0;
+
+  size_type size_ = 0;
+};
+
+/// The previous `SmallVector`, for trivial element types only.
+template<class TValue, size_t InitialCapacity>
+class SmallVector final : public VectorBase<TValue> {
+  using base_type = VectorBase<TValue>;
+
+public:
+  SmallVector() = default;
+  ~SmallVector() override {
+    if (InitialCapacity < capacity_) {
+      mbase::AlignedFree(storage_);
+    }
+  }
+  SmallVector(SmallVector const&) = delete;
+  SmallVector& operator=(SmallVector const&) = delete;
+
+protected:
+  [[nodiscard]] TValue* get_storage_pointer_impl() override {
+    return storage_pointer_;
+  }
+  void ensure_size_impl(size_t new_size) override {
+    if (capacity_ < new_size) {
+      size_t const new_capacity = mbase::detail::RoundtoNextPowerOf2(new_size);
+      auto new_storage = static_cast<TValue*>(mbase::AlignedAlloc(sizeof(TValue) * new_capacity, alignof(TValue)));
+      std::copy(storage_pointer_, storage_pointer_ + base_type::size_, new_storage);
+      if (InitialCapacity < capacity_) {
+        mbase::AlignedFree(storage_);
+      }
+      storage_ = new_storage;
+      storage_pointer_ = new_storage;
+      capacity_ = new_capacity;
+    }
+    base_type::size_ = new_size;
+  }
+
+private:
+  void* storage_ = nullptr;
+  TValue* storage_pointer_ = reinterpret_cast<TValue*>(initial_storage_);
+  size_t capacity_ = InitialCapacity;
+  alignas(TValue) std::byte initial_storage_[sizeof(TValue) * InitialCapacity];
+};
+
+/// The previous `StaticVector`, for trivial element types only.
+template<class TValue, size_t Capacity>
+class StaticVector final : public VectorBase<TValue> {
+  using base_type = VectorBase<TValue>;
+
+public:
+  StaticVector() = default;
+  ~StaticVector() override = default;
+  StaticVector(StaticVector const&) = delete;
+  StaticVector& operator=(StaticVector const&) = delete;
+
+protected:
+  [[nodiscard]] TValue* get_storage_pointer_impl() override {
+    return reinterpret_cast<TValue*>(storage_);
+  }
+  void ensure_size_impl(size_t new_size) override {
+    if (Capacity < new_size) {
+      throw std::bad_alloc();
+    }
+    base_type::size_ = std::max(base_type::size_, new_size);
+  }
+
+private:
+  alignas(TValue) std::byte storage_[sizeof(TValue) * Capacity];
+};
+
+} // namespace mbase::benchmark::virtual_dispatch
+
+namespace {
+
+using namespace mbase::benchmark;
+
+using Element = uint32_t;
+constexpr size_t kInlineCapacity = 16;
+constexpr size_t kStaticCapacity = 1 << 16;
+
+// The loops live in non-inlined functions taking the vector by reference, as in code that is handed a vector, so that
+// the compiler cannot see the dynamic type of a `VectorBase&`.
+
+template<class TVector>
+MBASE_BENCHMARK_NOINLINE void Push(TVector& vector, size_t count) {
+  vector.clear();
+  for (size_t i = 0; i < count; ++i) {
+    vector.push_back(static_cast<Element>(i));
+  }
+}
+template<class TVector>
+MBASE_BENCHMARK_NOINLINE uint64_t Iterate(TVector& vector) {
+  uint64_t sum = 0;
+  for (Element value : vector) {
+    sum += value;
+  }
+  return sum;
+}
+template<class TVector>
+MBASE_BENCHMARK_NOINLINE uint64_t Index(TVector& vector) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < vector.size(); ++i) {
+    sum += vector[i];
+  }
+  return sum;
+}
+
+struct Result final {
+  double push_ns;
+  double iterate_ns;
+  double index_ns;
+};
+
+/// Runs the loops on `vector` through `TView&`, repeated over about `total` elements.
+template<class TView, class TVector>
+Result Run(TVector& vector, size_t element_count, size_t total) {
+  TView& view = vector;
+  size_t const rounds = std::max<size_t>(1, total / element_count);
+  auto const repeat = [&](auto function) {
+    return [&, function](size_t) {
+      for (size_t round = 0; round < rounds; ++round) {
+        function();
+      }
+    };
+  };
+
+  Result result {};
+  // Pushing into a cleared vector reuses its capacity, as in a per-frame scratch vector; the first run grows it.
+  result.push_ns = NanosecondsPerIteration(rounds * element_count, repeat([&] { Push(view, element_count); }));
+  result.iterate_ns = NanosecondsPerIteration(rounds * element_count, repeat([&] { DoNotOptimize(Iterate(view)); }));
+  result.index_ns = NanosecondsPerIteration(rounds * element_count, repeat([&] { DoNotOptimize(Index(view)); }));
+  return result;
+}
+
+void Print(char const* name, Result const& result) {
+  fmt::print("{:<44} {:>8.3f} {:>8.3f} {:>8.3f}\n", name, result.push_ns, result.iterate_ns, result.index_ns);
+}
+
+} // namespace
+
+int main() {
+  size_t const element_count = std::clamp<size_t>(EnvironmentOr("MBASE_BENCHMARK_ELEMENTS", 4096), 1, kStaticCapacity);
+  constexpr size_t kTotal = size_t(1) << 26;
+
+  using Small = mbase::SmallVector<Element, kInlineCapacity>;
+  using Static = mbase::StaticVector<Element, kStaticCapacity>;
+  using PreviousBase = virtual_dispatch::VectorBase<Element>;
+  using PreviousSmall = virtual_dispatch::SmallVector<Element, kInlineCapacity>;
+  using PreviousStatic = virtual_dispatch::StaticVector<Element, kStaticCapacity>;
+
+  fmt::print("elements per vector: {}\n", element_count);
+  fmt::print("sizeof SmallVector: {} bytes, previously {} bytes\n", sizeof(Small), sizeof(PreviousSmall));
+
+  PrintHeader("ns per element");
+  fmt::print("{:<44} {:>8} {:>8} {:>8}\n", "", "push", "iterate", "index");
+
+  Small small;
+  Print("SmallVector (CRTP)", Run<Small>(small, element_count, kTotal));
+  PreviousSmall previous_small;
+  Print("previous SmallVector, through SmallVector&", Run<PreviousSmall>(previous_small, element_count, kTotal));
+  Print("previous SmallVector, through VectorBase&", Run<PreviousBase>(previous_small, element_count, kTotal));
+
+  auto static_vector = std::make_unique<Static>();
+  Print("StaticVector (CRTP)", Run<Static>(*static_vector, element_count, kTotal));
+  auto previous_static = std::make_unique<PreviousStatic>();
+  Print("previous StaticVector, through StaticVector&", Run<PreviousStatic>(*previous_static, element_count, kTotal));
+  Print("previous StaticVector, through VectorBase&", Run<PreviousBase>(*previous_static, element_count, kTotal));
+  return 0;
+}
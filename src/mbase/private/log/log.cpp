@@ -16,7 +16,6 @@
 #include <sstream>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
 
 // platform deteection headers --------------------------
@@ -34,6 +33,8 @@
 
 // project headers --------------------------------------
 #include "mbase/public/tsa.h"
+#include "mbase/public/container/flat_hash_map.h"
+#include "mbase/public/container/small_string.h"
 
 namespace mbase {
 
@@ -66,6 +67,9 @@ protected:
 //
 // Builds a line in the same shape as the previous spdlog pattern:
 //   [YYYY-MM-DD HH:MM][file:line][LEVEL] payload
+// into a stack buffer, so that logging a line of up to 256 characters does not allocate.
+
+using LogLine = SmallString<256>;
 
 char const* LevelLabel(Logger::Level level) {
   switch (level) {
@@ -79,7 +83,8 @@ char const* LevelLabel(Logger::Level level) {
   return "?";
 }
 
-std::string FormatLogLine(
+void FormatLogLine(
+  LogLine& out,
   Logger::Level level,
   std::chrono::system_clock::time_point time,
   char const* file,
@@ -102,12 +107,11 @@ std::string FormatLogLine(
   ::localtime_r(&t, &tm);
 #endif
 
-  std::ostringstream oss;
-  oss << '[' << std::put_time(&tm, "%Y-%m-%d %H:%M") << ']'
-      << '[' << file_view << ':' << line << ']'
-      << '[' << LevelLabel(level) << "] "
-      << payload;
-  return oss.str();
+  char date[32];
+  size_t const date_size = std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M", &tm);
+
+  out.append_format("[{}][{}:{}][{}] ", std::string_view(date, date_size), file_view, line, LevelLabel(level));
+  out.append(payload);
 }
 
 #if MBASE_PLATFORM_WINDOWS
@@ -292,9 +296,9 @@ public:
   DistSink() = default;
   ~DistSink() override = default;
 
-  void AddCallback(std::string const& name, Logger::LogCallback const& value) override {
+  void AddCallback(std::string const& name, Logger::LogCallback value) override {
     LockGuard lock(mutex_);
-    callbacks_[name] = value;
+    callbacks_[name] = std::move(value);
   }
   void RemoveCallback(std::string const& name) override {
     LockGuard lock(mutex_);
@@ -328,7 +332,7 @@ public:
 private:
   Lockable<std::mutex> mutex_;
   std::vector<std::shared_ptr<IPlatformSink>> sinks_ MBASE_GUARDED_BY(mutex_);
-  std::unordered_map<std::string, Logger::LogCallback> callbacks_ MBASE_GUARDED_BY(mutex_);
+  FlatHashMap<SmallString<32>, Logger::LogCallback> callbacks_ MBASE_GUARDED_BY(mutex_);
 };
 
 // ----------------------------------------------------------------------------------------------------
@@ -417,8 +421,9 @@ void Logger::LogImpl(MBASE_LOG_TAG_ARGUMENT, Level level, std::string_view paylo
     func = tag->location.function_name();
   }
 
-  std::string const formatted = FormatLogLine(level, time, file, line, func, payload);
-  dist_sink->Dispatch(level, time, formatted, payload);
+  LogLine formatted;
+  FormatLogLine(formatted, level, time, file, line, func, payload);
+  dist_sink->Dispatch(level, time, formatted.view(), payload);
 }
 
 } // namespace mbase
@@ -0,0 +1,238 @@
+// my header --------------------------------------------
+#include "mbase/public/string_intern.h"
+
+// c++ headers ------------------------------------------
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+// project headers --------------------------------------
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/tsa.h"
+
+namespace mbase {
+
+namespace {
+
+// IDs index a table of entries split into segments of doubling size: segment `i` holds `kFirstSegmentSize << i`
+// entries. Segments are never moved or freed while the pool lives, so readers can index them without locking.
+constexpr uint32_t kFirstSegmentBits = 10;
+constexpr uint32_t kFirstSegmentSize = 1u << kFirstSegmentBits;
+constexpr uint32_t kSegmentCount = 32 - kFirstSegmentBits;
+constexpr uint32_t kMaxSize = ~uint32_t(0) - kFirstSegmentSize;
+
+// Characters are bump-allocated from chunks of this size; longer strings get a chunk of their own.
+constexpr size_t kChunkSize = 64 * 1024;
+
+constexpr size_t kInitialTableCapacity = 1024;
+
+struct Entry final {
+  char const* data;
+  uint64_t hash;
+  uint32_t size;
+};
+
+/// Open-addressing table with linear probing. A slot holds `(hash >> 32) << 32 | (id + 1)`, or 0 when empty.
+/// Slots are written once, with release semantics, after their entry is complete.
+struct Table final {
+  explicit Table(size_t capacity) :
+    mask(capacity - 1),
+    slots(new std::atomic<uint64_t>[capacity])
+  {
+    for (size_t i = 0; i != capacity; ++i) {
+      slots[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] size_t Capacity() const { return mask + 1; }
+
+  void Insert(uint64_t hash, uint32_t id) {
+    size_t i = hash & mask;
+    while (slots[i].load(std::memory_order_relaxed) != 0) {
+      i = (i + 1) & mask;
+    }
+    slots[i].store((hash & 0xFFFFFFFF00000000ULL) | (uint64_t(id) + 1), std::memory_order_release);
+  }
+
+  size_t mask;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots;
+};
+
+struct SegmentIndex final {
+  uint32_t segment;
+  uint32_t offset;
+};
+
+[[nodiscard]] SegmentIndex ToSegmentIndex(uint32_t id) {
+  uint64_t const biased = uint64_t(id) + kFirstSegmentSize;
+  uint32_t const msb = 63 - uint32_t(std::countl_zero(biased));
+  return { msb - kFirstSegmentBits, uint32_t(biased - (uint64_t(1) << msb)) };
+}
+
+[[nodiscard]] size_t SegmentSize(uint32_t segment) {
+  return size_t(kFirstSegmentSize) << segment;
+}
+
+[[nodiscard]] void* AllocateOrThrow(size_t size, size_t alignment) {
+  void* block = AlignedAlloc(size, alignment);
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  return block;
+}
+
+} // namespace
+
+struct StringInternPool::State final {
+  State() = default;
+  ~State() {
+    for (auto& segment : segments) {
+      AlignedFree(segment.load(std::memory_order_relaxed));
+    }
+    LockGuard lock(mutex);
+    for (void* chunk : chunks) {
+      AlignedFree(chunk);
+    }
+  }
+  MBASE_DISALLOW_COPY_MOVE(State);
+
+  [[nodiscard]] Entry const& EntryAt(uint32_t id) const {
+    auto const [segment, offset] = ToSegmentIndex(id);
+    return segments[segment].load(std::memory_order_acquire)[offset];
+  }
+
+  [[nodiscard]] std::optional<uint32_t> FindIn(Table const& table, std::string_view s, uint64_t hash) const {
+    uint64_t const tag = hash >> 32;
+    for (size_t i = hash & table.mask; ; i = (i + 1) & table.mask) {
+      uint64_t const slot = table.slots[i].load(std::memory_order_acquire);
+      if (slot == 0) {
+        return std::nullopt;
+      }
+      if ((slot >> 32) == tag) {
+        uint32_t const id = uint32_t(slot) - 1;
+        Entry const& entry = EntryAt(id);
+        if (entry.size == s.size() && memcmp(entry.data, s.data(), s.size()) == 0) {
+          return id;
+        }
+      }
+    }
+  }
+
+  char* AllocateChars(size_t count) MBASE_REQUIRES(mutex) {
+    if (count > kChunkSize / 4) {
+      chunks.push_back(nullptr);
+      chunks.back() = AllocateOrThrow(count, alignof(char));
+      return static_cast<char*>(chunks.back());
+    }
+    if (count > chunk_left) {
+      chunks.push_back(nullptr);
+      chunks.back() = AllocateOrThrow(kChunkSize, alignof(std::max_align_t));
+      chunk_cursor = static_cast<char*>(chunks.back());
+      chunk_left = kChunkSize;
+    }
+    char* chars = chunk_cursor;
+    chunk_cursor += count;
+    chunk_left -= count;
+    return chars;
+  }
+
+  uint32_t Insert(std::string_view s, uint64_t hash) MBASE_REQUIRES(mutex) {
+    uint32_t const id = size.load(std::memory_order_relaxed);
+    if (id == kMaxSize) {
+      throw std::length_error("StringInternPool: out of IDs");
+    }
+
+    char* chars = AllocateChars(s.size() + 1);
+    if (!s.empty()) {
+      memcpy(chars, s.data(), s.size());
+    }
+    chars[s.size()] = '\0';
+
+    auto const [segment_index, offset] = ToSegmentIndex(id);
+    Entry* segment = segments[segment_index].load(std::memory_order_relaxed);
+    if (segment == nullptr) {
+      segment = static_cast<Entry*>(AllocateOrThrow(sizeof(Entry) * SegmentSize(segment_index), alignof(Entry)));
+      segments[segment_index].store(segment, std::memory_order_release);
+    }
+    segment[offset] = Entry { chars, hash, uint32_t(s.size()) };
+
+    // Keep the load factor at or below 1/2. Readers may still be probing the old table; it is retired, not freed.
+    Table* table = tables.back().get();
+    if ((size_t(id) + 1) * 2 > table->Capacity()) {
+      tables.push_back(std::make_unique<Table>(table->Capacity() * 2));
+      table = tables.back().get();
+      for (uint32_t i = 0; i != id; ++i) {
+        table->Insert(EntryAt(i).hash, i);
+      }
+      current_table.store(table, std::memory_order_release);
+    }
+    table->Insert(hash, id);
+
+    size.store(id + 1, std::memory_order_release);
+    return id;
+  }
+
+  std::array<std::atomic<Entry*>, kSegmentCount> segments {};
+  std::atomic<Table*> current_table { nullptr };
+  std::atomic<uint32_t> size { 0 };
+
+  Lockable<std::mutex> mutex;
+  std::vector<std::unique_ptr<Table>> tables MBASE_GUARDED_BY(mutex);
+  std::vector<void*> chunks MBASE_GUARDED_BY(mutex);
+  char* chunk_cursor MBASE_GUARDED_BY(mutex) = nullptr;
+  size_t chunk_left MBASE_GUARDED_BY(mutex) = 0;
+};
+
+StringInternPool::StringInternPool() :
+  state_(std::make_unique<State>())
+{
+  LockGuard lock(state_->mutex);
+  state_->tables.push_back(std::make_unique<Table>(kInitialTableCapacity));
+  state_->current_table.store(state_->tables.back().get(), std::memory_order_release);
+
+  // ID 0: the empty string, so that a default `InternedString` is valid.
+  state_->Insert(std::string_view(), Hash64{}(std::string_view()));
+}
+
+StringInternPool::~StringInternPool() = default;
+
+StringInternPool& StringInternPool::Global() {
+  // Never destroyed, so that interned strings stay valid during static destruction.
+  static StringInternPool* const pool = new StringInternPool();
+  return *pool;
+}
+
+uint32_t StringInternPool::Intern(std::string_view s) {
+  uint64_t const hash = Hash64{}(s);
+  if (auto id = state_->FindIn(*state_->current_table.load(std::memory_order_acquire), s, hash)) {
+    return *id;
+  }
+
+  LockGuard lock(state_->mutex);
+  // Another thread may have interned `s` since the lock-free probe.
+  if (auto id = state_->FindIn(*state_->tables.back(), s, hash)) {
+    return *id;
+  }
+  return state_->Insert(s, hash);
+}
+
+std::optional<uint32_t> StringInternPool::Find(std::string_view s) const {
+  return state_->FindIn(*state_->current_table.load(std::memory_order_acquire), s, Hash64{}(s));
+}
+
+std::string_view StringInternPool::View(uint32_t id) const {
+  Entry const& entry = state_->EntryAt(id);
+  return { entry.data, entry.size };
+}
+
+size_t StringInternPool::Size() const {
+  return state_->size.load(std::memory_order_acquire);
+}
+
+} // namespace mbase
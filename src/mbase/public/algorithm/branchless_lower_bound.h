@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+
+namespace mbase {
+
+/// `std::lower_bound` over a random access range, with the loop body reduced to a conditional move: the probe sequence
+/// depends only on the range size, so there are no mispredicted branches on unpredictable keys.
+template<class TIterator, class T, class TCompare = std::less<>>
+TIterator branchless_lower_bound(TIterator first, TIterator last, T const& value, TCompare comp = TCompare()) {
+  auto length = static_cast<size_t>(std::distance(first, last));
+  if (length == 0) {
+    return first;
+  }
+  while (length > 1) {
+    size_t const half = length / 2;
+    first = comp(first[half - 1], value) ? first + half : first;
+    length -= half;
+  }
+  return first + (comp(*first, value) ? 1 : 0);
+}
+
+/// `std::upper_bound` counterpart of `branchless_lower_bound`.
+template<class TIterator, class T, class TCompare = std::less<>>
+TIterator branchless_upper_bound(TIterator first, TIterator last, T const& value, TCompare comp = TCompare()) {
+  auto length = static_cast<size_t>(std::distance(first, last));
+  if (length == 0) {
+    return first;
+  }
+  while (length > 1) {
+    size_t const half = length / 2;
+    first = comp(value, first[half - 1]) ? first : first + half;
+    length -= half;
+  }
+  return first + (comp(value, *first) ? 0 : 1);
+}
+
+} // namespace mbase
@@ -0,0 +1,303 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <bit>
+#include <concepts>
+#include <latch>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/type_safety.h"
+
+namespace mbase {
+
+/// Maps a key to an unsigned integer `bits_type` whose ascending order is the key's sort order.
+/// Specialize for other key types.
+template<class T>
+struct RadixSortTraits;
+
+template<std::integral T>
+struct RadixSortTraits<T> {
+  using bits_type = std::make_unsigned_t<T>;
+  static constexpr bits_type ToBits(T value) {
+    if constexpr (std::is_signed_v<T>) {
+      return bits_type(value) ^ (bits_type(1) << (sizeof(T) * 8 - 1));
+    }
+    else {
+      return bits_type(value);
+    }
+  }
+};
+
+/// IEEE 754 total order: -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN.
+template<std::floating_point T>
+  requires (sizeof(T) == 4 || sizeof(T) == 8)
+struct RadixSortTraits<T> {
+  using bits_type = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+  static constexpr bits_type ToBits(T value) {
+    bits_type const bits = std::bit_cast<bits_type>(value);
+    constexpr bits_type kSignBit = bits_type(1) << (sizeof(T) * 8 - 1);
+    // Negative: flip all bits so that larger magnitudes sort first. Positive: set the sign bit to sort after negatives.
+    return bits ^ ((bits & kSignBit) != 0 ? ~bits_type(0) : kSignBit);
+  }
+};
+
+template<class T>
+  requires std::is_enum_v<T>
+struct RadixSortTraits<T> {
+  using bits_type = typename RadixSortTraits<std::underlying_type_t<T>>::bits_type;
+  static constexpr bits_type ToBits(T value) {
+    return RadixSortTraits<std::underlying_type_t<T>>::ToBits(std::to_underlying(value));
+  }
+};
+
+template<class Tag, class TStorage, TStorage InvalidValue>
+struct RadixSortTraits<TypesafeHandle<Tag, TStorage, InvalidValue>> {
+  using bits_type = typename RadixSortTraits<TStorage>::bits_type;
+  static constexpr bits_type ToBits(TypesafeHandle<Tag, TStorage, InvalidValue> const& value) {
+    return RadixSortTraits<TStorage>::ToBits(value.Get());
+  }
+};
+
+template<class T>
+concept RadixSortable = requires(T const& value) {
+  { RadixSortTraits<T>::ToBits(value) } -> std::unsigned_integral;
+} && std::is_nothrow_copy_assignable_v<T>;
+
+struct RadixSortOptions final {
+  /// Threads to split histogram and scatter work across, including the calling thread; 0 for
+  /// `std::thread::hardware_concurrency()`. Inputs too small to benefit use fewer.
+  uint32_t thread_count = 1;
+};
+
+namespace detail {
+
+struct RadixNoPayload {};
+
+inline constexpr size_t kRadixBuckets = 256;
+/// Below this size an insertion sort beats the histogram setup.
+inline constexpr size_t kRadixInsertionSortThreshold = 64;
+/// Each thread gets at least this many elements.
+inline constexpr size_t kRadixMinElementsPerThread = size_t(1) << 16;
+
+template<class T>
+constexpr auto RadixBits(T const& key) {
+  return RadixSortTraits<T>::ToBits(key);
+}
+template<class T>
+constexpr size_t RadixDigit(T const& key, unsigned shift) {
+  return size_t(RadixBits(key) >> shift) & (kRadixBuckets - 1);
+}
+
+template<class T, class V>
+void RadixInsertionSort(T* keys, V* values, size_t size) {
+  for (size_t i = 1; i < size; ++i) {
+    T const key = keys[i];
+    auto const bits = RadixBits(key);
+    size_t j = i;
+    if constexpr (std::is_same_v<V, RadixNoPayload>) {
+      for (; j > 0 && bits < RadixBits(keys[j - 1]); --j) {
+        keys[j] = keys[j - 1];
+      }
+      keys[j] = key;
+    }
+    else {
+      V const value = values[i];
+      for (; j > 0 && bits < RadixBits(keys[j - 1]); --j) {
+        keys[j] = keys[j - 1];
+        values[j] = values[j - 1];
+      }
+      keys[j] = key;
+      values[j] = value;
+    }
+  }
+}
+
+/// Stable scatter of `[first, last)` by one digit; `offsets` is advanced past each placed element.
+template<class T, class V>
+void RadixScatter(T const* src_keys, V const* src_values, T* dst_keys, V* dst_values, size_t first, size_t last, unsigned shift, size_t* offsets) {
+  for (size_t i = first; i != last; ++i) {
+    size_t const position = offsets[RadixDigit(src_keys[i], shift)]++;
+    dst_keys[position] = src_keys[i];
+    if constexpr (!std::is_same_v<V, RadixNoPayload>) {
+      dst_values[position] = src_values[i];
+    }
+  }
+}
+
+template<class T, class V>
+void RadixCopy(T const* src_keys, V const* src_values, T* dst_keys, V* dst_values, size_t first, size_t last) {
+  std::copy(src_keys + first, src_keys + last, dst_keys + first);
+  if constexpr (!std::is_same_v<V, RadixNoPayload>) {
+    std::copy(src_values + first, src_values + last, dst_values + first);
+  }
+}
+
+template<class T, class V>
+void RadixSortSerial(T* keys, V* values, T* key_scratch, V* value_scratch, size_t size) {
+  constexpr size_t kPasses = sizeof(typename RadixSortTraits<T>::bits_type);
+
+  // All histograms in one read of the input.
+  std::array<std::array<size_t, kRadixBuckets>, kPasses> counts {};
+  for (size_t i = 0; i != size; ++i) {
+    auto const bits = RadixBits(keys[i]);
+    for (size_t pass = 0; pass != kPasses; ++pass) {
+      ++counts[pass][size_t(bits >> (pass * 8)) & (kRadixBuckets - 1)];
+    }
+  }
+
+  T* src_keys = keys;
+  V* src_values = values;
+  T* dst_keys = key_scratch;
+  V* dst_values = value_scratch;
+  for (size_t pass = 0; pass != kPasses; ++pass) {
+    unsigned const shift = unsigned(pass * 8);
+    auto& offsets = counts[pass];
+    // Every key has the same digit: the pass would be a copy.
+    if (offsets[RadixDigit(keys[0], shift)] == size) {
+      continue;
+    }
+    size_t sum = 0;
+    for (size_t& offset : offsets) {
+      sum += std::exchange(offset, sum);
+    }
+    RadixScatter(src_keys, src_values, dst_keys, dst_values, 0, size, shift, offsets.data());
+    std::swap(src_keys, dst_keys);
+    std::swap(src_values, dst_values);
+  }
+  if (src_keys != keys) {
+    RadixCopy(src_keys, src_values, keys, values, 0, size);
+  }
+}
+
+/// Each participant owns a contiguous chunk. Per pass, participants count their chunk's digits, one of them turns the
+/// counts into per-participant offsets (bucket-major, so the scatter stays stable), and each scatters its chunk.
+template<class T, class V>
+void RadixSortParallel(T* keys, V* values, T* key_scratch, V* value_scratch, size_t size, uint32_t thread_count) {
+  constexpr size_t kPasses = sizeof(typename RadixSortTraits<T>::bits_type);
+  using Counts = std::array<size_t, kRadixBuckets>;
+
+  std::unique_ptr<Counts[]> counts(new Counts[thread_count]);
+  uint32_t participants = 0;
+  bool skip_pass = false;
+  auto compute_offsets = [&]() noexcept {
+    size_t sum = 0;
+    for (size_t bucket = 0; bucket != kRadixBuckets; ++bucket) {
+      size_t const bucket_first = sum;
+      for (uint32_t t = 0; t != participants; ++t) {
+        sum += std::exchange(counts[t][bucket], sum);
+      }
+      // Every key has the same digit: the pass would be a copy.
+      if (sum - bucket_first == size) {
+        skip_pass = true;
+        return;
+      }
+    }
+    skip_pass = false;
+  };
+  std::optional<std::barrier<decltype(compute_offsets)>> counted;
+  std::optional<std::barrier<>> scattered;
+  std::latch start(1);
+
+  auto run = [&](uint32_t t) {
+    size_t const first = size * t / participants;
+    size_t const last = size * (t + 1) / participants;
+    T* src_keys = keys;
+    V* src_values = values;
+    T* dst_keys = key_scratch;
+    V* dst_values = value_scratch;
+    for (size_t pass = 0; pass != kPasses; ++pass) {
+      unsigned const shift = unsigned(pass * 8);
+      counts[t].fill(0);
+      for (size_t i = first; i != last; ++i) {
+        ++counts[t][RadixDigit(src_keys[i], shift)];
+      }
+      counted->arrive_and_wait();
+      if (skip_pass) {
+        continue;
+      }
+      RadixScatter(src_keys, src_values, dst_keys, dst_values, first, last, shift, counts[t].data());
+      scattered->arrive_and_wait();
+      std::swap(src_keys, dst_keys);
+      std::swap(src_values, dst_values);
+    }
+    if (src_keys != keys) {
+      RadixCopy(src_keys, src_values, keys, values, first, last);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  try {
+    for (uint32_t t = 1; t != thread_count; ++t) {
+      threads.emplace_back([&, t] {
+        start.wait();
+        run(t);
+      });
+    }
+  }
+  catch (std::system_error const&) {
+    // Out of threads: sort with the ones already started.
+  }
+  participants = uint32_t(threads.size() + 1);
+  counted.emplace(participants, compute_offsets);
+  scattered.emplace(participants);
+  start.count_down();
+  run(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+template<class T, class V>
+void RadixSort(T* keys, V* values, T* key_scratch, V* value_scratch, size_t size, RadixSortOptions const& options) {
+  if (size < kRadixInsertionSortThreshold) {
+    RadixInsertionSort(keys, values, size);
+    return;
+  }
+  size_t thread_count = options.thread_count != 0 ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::min(thread_count, size / kRadixMinElementsPerThread);
+  if (thread_count <= 1) {
+    RadixSortSerial(keys, values, key_scratch, value_scratch, size);
+  }
+  else {
+    RadixSortParallel(keys, values, key_scratch, value_scratch, size, uint32_t(thread_count));
+  }
+}
+
+} // namespace detail
+
+/// Stable LSD radix sort by `RadixSortTraits<T>`, one pass per key byte; passes in which every key has the same byte
+/// are skipped. `scratch` must hold at least `keys.size()` elements; its contents are overwritten.
+template<RadixSortable T>
+void radix_sort(ArrayProxy<T> keys, ArrayProxy<T> scratch, RadixSortOptions const& options = {}) {
+  MBASE_ASSERT_MSG(scratch.size() >= keys.size(), "radix_sort scratch is smaller than the input!");
+  detail::RadixNoPayload payload;
+  detail::RadixSort(keys.data(), &payload, scratch.data(), &payload, keys.size(), options);
+}
+
+/// Sorts `keys` as above and applies the same permutation to `values`.
+template<RadixSortable T, class V>
+  requires std::is_nothrow_copy_assignable_v<V>
+void radix_sort(ArrayProxy<T> keys, ArrayProxy<V> values, ArrayProxy<T> key_scratch, ArrayProxy<V> value_scratch, RadixSortOptions const& options = {}) {
+  MBASE_ASSERT_MSG(values.size() == keys.size(), "radix_sort keys and values differ in size!");
+  MBASE_ASSERT_MSG(key_scratch.size() >= keys.size() && value_scratch.size() >= keys.size(), "radix_sort scratch is smaller than the input!");
+  detail::RadixSort(keys.data(), values.data(), key_scratch.data(), value_scratch.data(), keys.size(), options);
+}
+
+} // namespace mbase
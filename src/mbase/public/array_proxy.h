@@ -90,10 +90,10 @@ public:
   ArrayProxy(std::vector<std::remove_const_t<T>, Allocator> const& data) : ptr_(data.data()), count_(size_t(data.size())) {}
 
   // SmallVector
-  template<size_t InitialCapacity, size_t Alignment>
-  ArrayProxy(SmallVector<std::remove_const_t<T>, InitialCapacity, Alignment>& data) : ptr_(data.data()), count_(size_t(data.size())) {}
-  template<size_t InitialCapacity, size_t Alignment>
-  ArrayProxy(SmallVector<std::remove_const_t<T>, InitialCapacity, Alignment> const& data) : ptr_(const_cast<T*>(data.data())), count_(size_t(data.size())) {}
+  template<size_t InitialCapacity, size_t Alignment, class Allocator, class Size, class GrowthPolicy>
+  ArrayProxy(SmallVector<std::remove_const_t<T>, InitialCapacity, Alignment, Allocator, Size, GrowthPolicy>& data) : ptr_(data.data()), count_(size_t(data.size())) {}
+  template<size_t InitialCapacity, size_t Alignment, class Allocator, class Size, class GrowthPolicy>
+  ArrayProxy(SmallVector<std::remove_const_t<T>, InitialCapacity, Alignment, Allocator, Size, GrowthPolicy> const& data) : ptr_(const_cast<T*>(data.data())), count_(size_t(data.size())) {}
 
   // StaticVector
   template<size_t Capacity, size_t Alignment>
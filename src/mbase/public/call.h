@@ -23,3 +23,14 @@
 #  define MBASE_STDCALL
 # endif
 #endif
+
+#if !defined(MBASE_PREFETCH)
+# if defined(__GNUC__) || defined(__clang__)
+#  define MBASE_PREFETCH(address) __builtin_prefetch(address)
+# elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <xmmintrin.h>
+#  define MBASE_PREFETCH(address) _mm_prefetch((char const*)(address), _MM_HINT_T0)
+# else
+#  define MBASE_PREFETCH(address) ((void)(address))
+# endif
+#endif
@@ -3,11 +3,12 @@
 // c++ headers ------------------------------------------
 #include <type_traits>
 #include <atomic>
-#include <functional>
+#include <utility>
 
 // public project headers -------------------------------
 #include "mbase/public/assert.h"
 #include "mbase/public/access.h"
+#include "mbase/public/function.h"
 #include "mbase/public/com/com.h"
 
 namespace mbase {
@@ -17,6 +18,10 @@ class ReferenceCountedBaseTemplate : public T {
 public:
   static_assert(std::is_base_of_v<IMbUnknown, T>, "T MUST derive from IMbUnknown");
 
+  /// Called with the object instead of `delete` once the last reference is released. May capture a pointer, e.g. to
+  /// the pool or allocator the object came from.
+  using Deleter = InplaceFunction<void(void*), sizeof(void*)>;
+
   //
   // IMbUnknown implementation
   //
@@ -43,7 +48,9 @@ public:
 
     if (new_ref_count == 0) {
       if (deleter_) {
-        deleter_(this);
+        // Moved out first: the deleter destroys the object holding it.
+        Deleter const deleter = std::move(deleter_);
+        deleter(this);
       }
       else {
         delete this;
@@ -53,8 +60,8 @@ public:
   }
 
 
-  void SetDeleter(std::function<void(void*)> deleter) {
-    deleter_ = deleter;
+  void SetDeleter(Deleter deleter) {
+    deleter_ = std::move(deleter);
   }
 
 protected:
@@ -64,7 +71,7 @@ protected:
 private:
   std::atomic<IMbUnknown::ReferenceCount> ref_count_ { 1 };
 
-  std::function<void(void*)> deleter_ = nullptr;
+  Deleter deleter_;
 };
 
 } // namespace mbase
@@ -1,91 +1,202 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 
 #include <type_traits>
+#include <utility>
+#include <limits>
+#include <memory>
+#include <span>
 #include <iterator>
 #include <algorithm>
 #include <stdexcept>
 
 #include "mbase/public/assert.h"
 #include "mbase/public/memory.h"
+#include "mbase/public/platform.h"
+#include "mbase/public/type_util.h"
+
+/// Declares `T` trivially relocatable; see `mbase::is_trivially_relocatable`.
+/// Must be used at global namespace scope.
+#define MBASE_DECLARE_TRIVIALLY_RELOCATABLE(T) \
+  template<> struct mbase::is_trivially_relocatable<T> : std::true_type {}
 
 namespace mbase {
 
+/// Whether an object of type `T` can be relocated (move-constructed into new storage, then destroyed at the old one)
+/// by copying its bytes.
+/// `true` for `TriviallyCopyable` types; opt other types in (e.g. handles owning a pointer, `std::unique_ptr`-like types)
+/// with `MBASE_DECLARE_TRIVIALLY_RELOCATABLE`.
+template<class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<class T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+template<class T1, class T2>
+struct is_trivially_relocatable<std::pair<T1, T2>> : std::bool_constant<is_trivially_relocatable_v<T1> && is_trivially_relocatable_v<T2>> {};
+
 namespace detail {
 
+// The strategies below are `constexpr`: they construct and destroy through `std::construct_at` and `std::destroy_at`,
+// and fall back from `memcpy`/`memmove` to element-wise loops during constant evaluation.
+// Naming a strategy with `U = bool` selects its generic primary template.
+
 template<class TIterator>
 struct construct_strategy final {
   using value_type = typename std::iterator_traits<TIterator>::value_type;
 
   template<class T = value_type, class V = std::enable_if_t<std::is_trivially_default_constructible_v<T>>>
-  static void on_element([[maybe_unused]]  TIterator it) {
+  static constexpr void on_element([[maybe_unused]]  TIterator it) {
     static_assert(std::is_trivially_default_constructible_v<value_type>);
-    // No-op for TriviallyDefaultConstructible types.
+    // No-op for TriviallyDefaultConstructible types, except that constant evaluation needs an initialized object.
+    if consteval {
+      std::construct_at(std::addressof(*it));
+    }
   }
   template<class T = value_type, class V = std::enable_if_t<std::is_trivially_default_constructible_v<T>>>
-  static void on_range([[maybe_unused]]  TIterator first, [[maybe_unused]] TIterator last) {
+  static constexpr void on_range([[maybe_unused]]  TIterator first, [[maybe_unused]] TIterator last) {
     static_assert(std::is_trivially_default_constructible_v<value_type>);
-    // No-op for TriviallyDefaultConstructible types.
+    // No-op for TriviallyDefaultConstructible types, except that constant evaluation needs initialized objects.
+    if consteval {
+      for (auto it = first; it != last; ++it) {
+        std::construct_at(std::addressof(*it));
+      }
+    }
   }
 
   template<class ... Args>
-  static void on_element(TIterator it, Args&& ... args) {
-    new(std::addressof(*it)) value_type(std::forward<Args>(args)...);
+  static constexpr void on_element(TIterator it, Args&& ... args) {
+    std::construct_at(std::addressof(*it), std::forward<Args>(args)...);
   }
 
   template<class ... Args>
-  static void on_range(TIterator first, TIterator last, Args&& ... args) {
+  static constexpr void on_range(TIterator first, TIterator last, Args&& ... args) {
+    // Not forwarded: every element is constructed from the same arguments.
     for (auto it = first; it != last; ++it) {
-      new(std::addressof(*it)) value_type(std::forward<Args>(args)...);
+      std::construct_at(std::addressof(*it), args...);
     }
   }
 };
 
 template<class TIterator, class U = void>
 struct destruct_strategy final {
-  using value_type = typename std::iterator_traits<TIterator>::value_type;
-
-  static void on_element(TIterator it) {
-    std::addressof(*it)->~value_type();
+  static constexpr void on_element(TIterator it) {
+    std::destroy_at(std::addressof(*it));
   }
 
-  static void on_range(TIterator first, TIterator last) {
+  static constexpr void on_range(TIterator first, TIterator last) {
     for (auto it = first; it != last; ++it) {
-      std::addressof(*it)->~value_type();
+      std::destroy_at(std::addressof(*it));
     }
   }
 };
 
 template<class TIterator>
 struct destruct_strategy<TIterator, std::enable_if_t<std::is_trivially_destructible_v<typename std::iterator_traits<TIterator>::value_type>>> final {
-  static void on_element([[maybe_unused]] TIterator it) {
+  static constexpr void on_element([[maybe_unused]] TIterator it) {
     // No-op for TriviallyDestructible types.
   }
-  static void on_range([[maybe_unused]]  TIterator first, [[maybe_unused]] TIterator last) {
+  static constexpr void on_range([[maybe_unused]]  TIterator first, [[maybe_unused]] TIterator last) {
     // No-op for TriviallyDestructible types.
   }
 };
 
 template<class TInputIterator, class TOutputIterator, class U = void>
 struct non_overlapping_copy_strategy final {
-  static void call(TInputIterator first, TInputIterator last, TOutputIterator position) {
+  static constexpr void call(TInputIterator first, TInputIterator last, TOutputIterator position) {
     for (auto it = first; it != last; ++it, ++position) {
       construct_strategy<TOutputIterator>::on_element(position, *it);
     }
   }
 };
 
+template<class T>
+struct non_overlapping_copy_strategy<T const*, T*, std::enable_if_t<std::is_trivially_copyable_v<T>>> final {
+  static constexpr void call(T const* first, T const* last, T* position) {
+    if consteval {
+      non_overlapping_copy_strategy<T const*, T*, bool>::call(first, last, position);
+    }
+    else {
+      if (first != last) {
+        memcpy(position, first, sizeof(T) * (last - first));
+      }
+    }
+  }
+};
+
+template<class T>
+struct non_overlapping_copy_strategy<T*, T*, std::enable_if_t<std::is_trivially_copyable_v<T>>> final {
+  static constexpr void call(T* first, T* last, T* position) {
+    non_overlapping_copy_strategy<T const*, T*>::call(first, last, position);
+  }
+};
+
 template<class TInputIterator, class TOutputIterator, class U = void>
 struct non_overlapping_move_strategy final {
-  static void call(TInputIterator first, TInputIterator last, TOutputIterator position) {
+  static constexpr void call(TInputIterator first, TInputIterator last, TOutputIterator position) {
     for (auto it = first, out = position; it != last; ++it, ++out) {
       construct_strategy<TOutputIterator>::on_element(out, std::move(*it));
     }
   }
 };
 
+/// Relocates elements: each destination slot is move-constructed from its source, then the source is destroyed.
+/// Destination slots must not hold live objects when they are written.
+/// Reduces to a single `memcpy`/`memmove` for `is_trivially_relocatable` types, outside constant evaluation.
+template<class T, class U = void>
+struct relocate_strategy final {
+  static constexpr void non_overlapping(T* first, T* last, T* position) {
+    for (auto it = first; it != last; ++it, ++position) {
+      std::construct_at(position, std::move(*it));
+      std::destroy_at(it);
+    }
+  }
+
+  static constexpr void overlapping(T* first, T* last, T* position) {
+    if (position < first) {
+      non_overlapping(first, last, position);
+    }
+    else if (first < position) {
+      // Back to front so that every destination slot has already been vacated.
+      position += last - first;
+      while (first != last) {
+        --last;
+        --position;
+        std::construct_at(position, std::move(*last));
+        std::destroy_at(last);
+      }
+    }
+  }
+};
+
+template<class T>
+struct relocate_strategy<T, std::enable_if_t<is_trivially_relocatable_v<T>>> final {
+  static constexpr void non_overlapping(T* first, T* last, T* position) {
+    if consteval {
+      relocate_strategy<T, bool>::non_overlapping(first, last, position);
+    }
+    else {
+      if (first != last) {
+        memcpy(static_cast<void*>(position), static_cast<void const*>(first), sizeof(T) * (last - first));
+      }
+    }
+  }
+
+  static constexpr void overlapping(T* first, T* last, T* position) {
+    if consteval {
+      relocate_strategy<T, bool>::overlapping(first, last, position);
+    }
+    else {
+      if (first != last && first != position) {
+        memmove(static_cast<void*>(position), static_cast<void const*>(first), sizeof(T) * (last - first));
+      }
+    }
+  }
+};
+
 template<class TValue>
 [[nodiscard]] TValue RoundtoNextPowerOf2(TValue value) {
   --value;
@@ -103,7 +214,38 @@ template<class TValue>
 
 } // namespace detail
 
-template<class TValue>
+// Growth policies for `SmallVector`.
+// A growth policy is a default-constructible functor `size_t (size_t current_capacity, size_t required_capacity) const`
+// returning the capacity to grow to, which must be at least `required_capacity`.
+
+/// Grows to the next power of two. Fewest reallocations; wastes up to 50% for large vectors.
+struct PowerOf2GrowthPolicy final {
+  [[nodiscard]] size_t operator()([[maybe_unused]] size_t current_capacity, size_t required_capacity) const noexcept {
+    return detail::RoundtoNextPowerOf2(required_capacity);
+  }
+};
+
+/// Grows by a factor of 1.5.
+struct GeometricGrowthPolicy final {
+  [[nodiscard]] size_t operator()(size_t current_capacity, size_t required_capacity) const noexcept {
+    return std::max(required_capacity, current_capacity + current_capacity / 2);
+  }
+};
+
+/// Grows to exactly the required capacity. Least memory; use with `reserve` when the final size is known.
+struct ExactGrowthPolicy final {
+  [[nodiscard]] size_t operator()([[maybe_unused]] size_t current_capacity, size_t required_capacity) const noexcept {
+    return required_capacity;
+  }
+};
+
+/// Common vector interface over contiguous storage.
+/// Storage hooks (`get_storage_pointer_impl`, `ensure_size_impl`, ...) are resolved statically on `TDerived` (CRTP),
+/// so element access compiles down to a plain pointer load and no vtable pointer is carried.
+/// The size is stored as `TSize` (`size_type` stays `size_t`), allowing compact layouts.
+/// Members are `constexpr` except for the `memcpy`-based and default-initializing ones; whether they can actually be
+/// evaluated at compile time depends on `TDerived`'s storage (see `StaticVector`).
+template<class TValue, class TDerived, class TSize = size_t>
 class VectorBase {
 public:
   using value_type = TValue;
@@ -116,56 +258,56 @@ public:
   using reverse_iterator = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-  iterator begin() noexcept { return get_storage_pointer_impl(); }
-  const_iterator begin() const noexcept { return get_storage_pointer_impl(); }
+  constexpr iterator begin() noexcept { return derived().get_storage_pointer_impl(); }
+  constexpr const_iterator begin() const noexcept { return derived().get_storage_pointer_impl(); }
 
-  iterator end() noexcept { return get_storage_pointer_impl() + size_; }
-  const_iterator end() const noexcept { return get_storage_pointer_impl() + size_; }
+  constexpr iterator end() noexcept { return derived().get_storage_pointer_impl() + size_; }
+  constexpr const_iterator end() const noexcept { return derived().get_storage_pointer_impl() + size_; }
 
-  const_iterator cbegin() const noexcept { return begin(); }
-  const_iterator cend() const noexcept { return end(); }
+  constexpr const_iterator cbegin() const noexcept { return begin(); }
+  constexpr const_iterator cend() const noexcept { return end(); }
 
-  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
-  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  constexpr reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  constexpr const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
 
-  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
-  const_reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+  constexpr reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  constexpr const_reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
 
-  const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(cend()); }
-  const_reverse_iterator crend() const noexcept { return const_reverse_iterator(cbegin()); }
+  constexpr const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(cend()); }
+  constexpr const_reverse_iterator crend() const noexcept { return const_reverse_iterator(cbegin()); }
 
-  [[nodiscard]] size_type size() const noexcept { return size_; }
-  [[nodiscard]] size_type size_in_bytes() const noexcept { return sizeof(value_type) * size_; }
-  [[nodiscard]] size_type max_size() const noexcept { return max_size_impl(); }
-  [[nodiscard]] size_type capacity() const noexcept { return capacity_impl(); }
+  [[nodiscard]] constexpr size_type size() const noexcept { return size_; }
+  [[nodiscard]] constexpr size_type size_in_bytes() const noexcept { return sizeof(value_type) * size_; }
+  [[nodiscard]] constexpr size_type max_size() const noexcept { return derived().max_size_impl(); }
+  [[nodiscard]] constexpr size_type capacity() const noexcept { return derived().capacity_impl(); }
 
-  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] constexpr bool empty() const noexcept { return size_ == 0; }
 
-  reference operator[](size_type i) noexcept { return *(get_storage_pointer_impl() + i); }
-  const_reference operator[](size_type i) const noexcept { return *(get_storage_pointer_impl() + i); }
+  constexpr reference operator[](size_type i) noexcept { return *(derived().get_storage_pointer_impl() + i); }
+  constexpr const_reference operator[](size_type i) const noexcept { return *(derived().get_storage_pointer_impl() + i); }
 
-  reference at(size_type i) {
+  constexpr reference at(size_type i) {
     if (size_ <= i) {
       throw std::out_of_range("Subscript out of range!");
     }
     return operator[](i);
   }
-  const_reference at(size_type i) const {
+  constexpr const_reference at(size_type i) const {
     if (size_ <= i) {
       throw std::out_of_range("Subscript out of range!");
     }
     return operator[](i);
   }
 
-  value_type* data() noexcept { return get_storage_pointer_impl(); }
-  value_type const* data() const noexcept { return get_storage_pointer_impl(); }
+  constexpr value_type* data() noexcept { return derived().get_storage_pointer_impl(); }
+  constexpr value_type const* data() const noexcept { return derived().get_storage_pointer_impl(); }
 
-  reference front() noexcept { return *begin(); }
-  const_reference front() const noexcept { return *begin(); }
-  reference back() noexcept { return *(end() - 1); }
-  const_reference back() const noexcept { return *(end() - 1); }
+  constexpr reference front() noexcept { return *begin(); }
+  constexpr const_reference front() const noexcept { return *begin(); }
+  constexpr reference back() noexcept { return *(end() - 1); }
+  constexpr const_reference back() const noexcept { return *(end() - 1); }
 
-  void clear() {
+  constexpr void clear() {
     if (size_ == 0) {
       // No-op.
       return;
@@ -175,16 +317,16 @@ public:
     size_ = 0;
   }
 
-  void reserve(size_type new_capacity) noexcept {
-    reserve_impl(new_capacity);
+  constexpr void reserve(size_type new_capacity) {
+    derived().reserve_impl(new_capacity);
   }
 
   template<class ... Args>
-  void resize(size_type new_size, Args&& ... args) {
+  constexpr void resize(size_type new_size, Args&& ... args) {
     if (size_ <= new_size) {
       // Growing resize.
       auto old_size = size_;
-      ensure_size_impl(new_size);
+      derived().ensure_size_impl(new_size);
       detail::construct_strategy<iterator>::on_range(begin() + old_size, end(), std::forward<Args>(args)...);
     }
     else {
@@ -194,50 +336,88 @@ public:
     }
   }
 
+  /// Like `resize`, but new elements are default-initialized, i.e. left uninitialized for trivial types.
+  void resize_default_init(size_type new_size) {
+    if (size_ <= new_size) {
+      auto old_size = size_;
+      derived().ensure_size_impl(new_size);
+      std::uninitialized_default_construct(begin() + old_size, end());
+    }
+    else {
+      detail::destruct_strategy<iterator>::on_range(begin() + new_size, end());
+      size_ = new_size;
+    }
+  }
+
+  /// Appends `n` default-initialized elements (uninitialized for trivial types) and returns a writable span over them,
+  /// so that they can be filled in place (e.g. by a read, a decoder or a SIMD kernel).
+  /// Pass the span to `commit` once the number of elements actually written is known.
+  std::span<value_type> append_uninitialized(size_type n) {
+    auto old_size = size_;
+    resize_default_init(size_ + n);
+    return std::span<value_type>(begin() + old_size, n);
+  }
+
+  /// Trims `tail`, the most recent result of `append_uninitialized`, to its first `written` elements and returns them.
+  std::span<value_type> commit(std::span<value_type> tail, size_type written) {
+    MBASE_ASSERT(tail.data() + tail.size() == end());
+    MBASE_ASSERT(written <= tail.size());
+
+    resize_default_init(size_ - (tail.size() - written));
+    return tail.first(written);
+  }
+
   template<class TInputIterator>
-  void assign(TInputIterator first, TInputIterator last) {
+  constexpr void assign(TInputIterator first, TInputIterator last) {
     if (size_ > 0) {
       clear();
     }
 
-    ensure_size_impl(std::distance(first, last));
+    derived().ensure_size_impl(std::distance(first, last));
     detail::non_overlapping_copy_strategy<TInputIterator, iterator>::call(first, last, begin());
   }
-  void assign(size_type n, value_type const& value) {
+  constexpr void assign(size_type n, value_type const& value) {
     if (size_ > 0) {
       clear();
     }
 
-    ensure_size_impl(n);
+    derived().ensure_size_impl(n);
     detail::construct_strategy<iterator>::on_range(begin(), end(), value);
   }
-  void assign(std::initializer_list<value_type> const& values) {
+  constexpr void assign(std::initializer_list<value_type> const& values) {
     assign(std::begin(values), std::end(values));
   }
 
-  void push_back(value_type const& value) {
-    ensure_size_impl(size_ + 1);
+  constexpr void push_back(value_type const& value) {
+    derived().ensure_size_impl(size_ + 1);
     detail::construct_strategy<iterator>::on_element(end() - 1, value);
   }
-  void push_back(value_type&& value) {
-    ensure_size_impl(size_ + 1);
+  constexpr void push_back(value_type&& value) {
+    derived().ensure_size_impl(size_ + 1);
     detail::construct_strategy<iterator>::on_element(end() - 1, std::move(value));
   }
 
   template<class ... Args>
-  reference emplace_back(Args&& ... args) {
-    ensure_size_impl(size_ + 1);
-    detail::construct_strategy<iterator>::on_element(end() - 1, std::forward<Args>(args)...);
+  constexpr reference emplace_back(Args&& ... args) {
+    derived().ensure_size_impl(size_ + 1);
+    try {
+      detail::construct_strategy<iterator>::on_element(end() - 1, std::forward<Args>(args)...);
+    }
+    catch (...) {
+      // The element was never constructed, so it must not be counted.
+      --size_;
+      throw;
+    }
     return back();
   }
 
-  void pop_back() {
+  constexpr void pop_back() {
     detail::destruct_strategy<iterator>::on_element(end() - 1);
     --size_;
   }
 
   template<class TInputIterator>
-  iterator insert(iterator position, TInputIterator first, TInputIterator last) {
+  constexpr iterator insert(iterator position, TInputIterator first, TInputIterator last) {
     position = ensure_size_and_make_room(position, std::distance(first, last));;
     detail::non_overlapping_copy_strategy<TInputIterator, iterator>::call(first, last, position);
     return position;
@@ -250,16 +430,25 @@ public:
     return position;
   }
 
-  void insert(iterator position, size_type n, value_type const& x) {
+  constexpr void insert(iterator position, size_type n, value_type const& x) {
     position = ensure_size_and_make_room(position, n);
     detail::construct_strategy<iterator>::on_range(position, position + n, x);
   }
 
+  /// Constructs the element before making room, so a throwing constructor leaves the vector unchanged.
+  template<class ... Args>
+  constexpr iterator emplace(iterator position, Args&& ... args) {
+    value_type value(std::forward<Args>(args)...);
+    position = ensure_size_and_make_room(position, 1);
+    detail::construct_strategy<iterator>::on_element(position, std::move(value));
+    return position;
+  }
+
   template<class TInputIterator>
   void append_memcpyable(TInputIterator first, TInputIterator last) {
     auto input_range_size = std::distance(first, last);
     auto old_end_position = size_;
-    ensure_size_impl(size_ + input_range_size);
+    derived().ensure_size_impl(size_ + input_range_size);
     auto valid_old_end_it = begin() + old_end_position;
     memcpy(std::addressof(*valid_old_end_it), std::addressof(*first), sizeof(value_type) * input_range_size);
   }
@@ -267,67 +456,73 @@ public:
   void append_memcpyable_unsafe(TInputIterator first, TInputIterator last) {
     auto input_range_size = std::distance(first, last);
     auto old_end_position = size_;
-    ensure_size_unsafe_impl(size_ + input_range_size);
+    derived().ensure_size_unsafe_impl(size_ + input_range_size);
     auto valid_old_end_it = begin() + old_end_position;
     memcpy(std::addressof(*valid_old_end_it), std::addressof(*first), sizeof(value_type) * input_range_size);
   }
 
-  iterator erase(iterator position) {
+  constexpr iterator erase(iterator position) {
     return erase(position, position + 1);
   }
-  iterator erase(iterator first, iterator last) {
+  constexpr iterator erase(iterator first, iterator last) {
     detail::destruct_strategy<iterator>::on_range(first, last);
-    move_range_to(last, end(), first);
+    detail::relocate_strategy<value_type>::overlapping(last, end(), first);
     size_ -= std::distance(first, last);
     return first;
   }
 
 protected:
-  VectorBase() = default;
-  virtual ~VectorBase() = default;
-  [[nodiscard]] virtual value_type* get_storage_pointer_impl() = 0;
-  [[nodiscard]] virtual value_type const* get_storage_pointer_impl() const = 0;
-  virtual void ensure_size_impl(size_type new_size) = 0;
-  virtual void ensure_size_unsafe_impl(size_type new_size) = 0;
-  virtual void reserve_impl(size_type new_capacity) = 0;
-  [[nodiscard]] virtual size_type max_size_impl() const noexcept = 0;
-  [[nodiscard]] virtual size_type capacity_impl() const noexcept = 0;
-
-  size_t size_ = 0;
+  constexpr VectorBase() = default;
+  constexpr ~VectorBase() = default;
+
+  // `TDerived` is expected to provide the following (possibly non-public, with `friend base_type;`):
+  //   value_type* get_storage_pointer_impl();
+  //   value_type const* get_storage_pointer_impl() const;
+  //   void ensure_size_impl(size_type new_size);
+  //   void ensure_size_unsafe_impl(size_type new_size);
+  //   void reserve_impl(size_type new_capacity);
+  //   size_type max_size_impl() const noexcept;
+  //   size_type capacity_impl() const noexcept;
+
+  [[nodiscard]] constexpr TDerived& derived() noexcept { return static_cast<TDerived&>(*this); }
+  [[nodiscard]] constexpr TDerived const& derived() const noexcept { return static_cast<TDerived const&>(*this); }
+
+  TSize size_ = 0;
 
 private:
-  iterator ensure_size_and_make_room(iterator position_it, size_type range_size) {
+  constexpr iterator ensure_size_and_make_room(iterator position_it, size_type range_size) {
     auto position = std::distance(begin(), position_it);
     auto old_end_position = std::distance(begin(), end());
 
-    ensure_size_impl(size_ + range_size);
+    derived().ensure_size_impl(size_ + range_size);
 
     auto valid_position_it = begin() + position;
     auto valid_old_end_position_it = begin() + old_end_position;
 
-    move_range_to_and_destruct(valid_position_it, valid_old_end_position_it, valid_position_it + range_size);
+    // Leaves [valid_position_it, valid_position_it + range_size) uninitialized for the caller to construct into.
+    detail::relocate_strategy<value_type>::overlapping(valid_position_it, valid_old_end_position_it, valid_position_it + range_size);
     return valid_position_it;
   }
-
-  void move_range_to_and_destruct(iterator first, iterator last, iterator position) {
-    move_range_to(first, last, position);
-    detail::destruct_strategy<iterator>::on_range(first, first + std::distance(first, position));
-  }
-  void move_range_to(iterator first, iterator last, iterator position) {
-    if (first < position) {
-      detail::non_overlapping_move_strategy<reverse_iterator, reverse_iterator>::call(reverse_iterator(last), reverse_iterator(first), reverse_iterator(position + std::distance(first, last)));
-    }
-    if (position < first) {
-      detail::non_overlapping_move_strategy<iterator, iterator>::call(first, last, position);
-    }
-  }
 };
 
 /// A vector with small size optimization.
-template<class TValue, size_t InitialCapacity, size_t Alignment = std::max(alignof(TValue), sizeof(void*))>
-class SmallVector final : public VectorBase<TValue> {
+/// Elements beyond `InitialCapacity` spill to storage obtained from `TAllocator` (see `AlignedAllocator` in memory.h);
+/// a stateless allocator adds no size.
+/// Size and capacity are stored as `TSize`; see `CompactSmallVector`.
+/// Heap capacity grows according to `TGrowthPolicy` (see `PowerOf2GrowthPolicy` and friends).
+/// Elements live in the inline buffer iff `capacity() <= InitialCapacity`.
+template<
+  class TValue,
+  size_t InitialCapacity,
+  size_t Alignment = std::max(alignof(TValue), sizeof(void*)),
+  class TAllocator = AlignedAllocator,
+  class TSize = size_t,
+  class TGrowthPolicy = PowerOf2GrowthPolicy
+>
+class SmallVector final : public VectorBase<TValue, SmallVector<TValue, InitialCapacity, Alignment, TAllocator, TSize, TGrowthPolicy>, TSize> {
 public:
-  using base_type = VectorBase<TValue>;
+  using base_type = VectorBase<TValue, SmallVector<TValue, InitialCapacity, Alignment, TAllocator, TSize, TGrowthPolicy>, TSize>;
+  friend base_type;
 
   using value_type = typename base_type::value_type;
   using size_type = typename base_type::size_type;
@@ -338,182 +533,267 @@ public:
   using const_iterator = typename base_type::const_iterator;
   using reverse_iterator = typename base_type::reverse_iterator;
   using const_reverse_iterator = typename base_type::const_reverse_iterator;
+  using allocator_type = TAllocator;
+
+  static_assert(std::is_unsigned_v<TSize> && InitialCapacity <= std::numeric_limits<TSize>::max());
 
   [[nodiscard]] SmallVector() = default;
-  [[nodiscard]] explicit SmallVector(size_t n) {
+  [[nodiscard]] explicit SmallVector(allocator_type const& allocator) :
+    allocator_(allocator)
+  {
+  }
+  [[nodiscard]] explicit SmallVector(size_t n, allocator_type const& allocator = allocator_type()) :
+    allocator_(allocator)
+  {
     ensure_size_impl(n);
     detail::construct_strategy<iterator>::on_range(this->begin(), this->end());
   }
-  [[nodiscard]] SmallVector(size_t n, value_type const& value) {
+  [[nodiscard]] SmallVector(size_t n, value_type const& value, allocator_type const& allocator = allocator_type()) :
+    allocator_(allocator)
+  {
     base_type::assign(n, value);
   }
-  [[nodiscard]] SmallVector(SmallVector const& rhs) {
+  [[nodiscard]] SmallVector(SmallVector const& rhs) :
+    allocator_(rhs.allocator_)
+  {
     base_type::assign(std::begin(rhs), std::end(rhs));
   }
-  [[nodiscard]] SmallVector(SmallVector&& rhs) noexcept {
+  [[nodiscard]] SmallVector(SmallVector&& rhs) noexcept :
+    allocator_(std::move(rhs.allocator_))
+  {
     move_construct_from(std::move(rhs));
   }
-  template<size_t C2, size_t A2>
-  [[nodiscard]] SmallVector(SmallVector<TValue, C2, A2> const& rhs) {
+  template<size_t C2, size_t A2, class L2, class S2, class G2>
+  [[nodiscard]] SmallVector(SmallVector<TValue, C2, A2, L2, S2, G2> const& rhs, allocator_type const& allocator = allocator_type()) :
+    allocator_(allocator)
+  {
     base_type::assign(std::begin(rhs), std::end(rhs));
   }
   template<class TInputIterator>
-  [[nodiscard]] SmallVector(TInputIterator first, TInputIterator last) {
+  [[nodiscard]] SmallVector(TInputIterator first, TInputIterator last, allocator_type const& allocator = allocator_type()) :
+    allocator_(allocator)
+  {
     base_type::assign(first, last);
   }
-  [[nodiscard]] SmallVector(std::initializer_list<value_type> const& values) {
+  [[nodiscard]] SmallVector(std::initializer_list<value_type> const& values, allocator_type const& allocator = allocator_type()) :
+    allocator_(allocator)
+  {
     base_type::assign(std::begin(values), std::end(values));
   }
-  ~SmallVector() override {
+  ~SmallVector() {
     if (base_type::size_ > 0) {
       base_type::clear();
     }
 
-    if (storage_) {
-      AlignedFree(storage_);
+    if (!is_inline()) {
+      allocator_.deallocate(storage_, sizeof(value_type) * capacity_, Alignment);
     }
   }
 
+  /// Copy assignment keeps this vector's allocator.
   SmallVector& operator=(SmallVector const& rhs) {
     if (this != &rhs) {
       base_type::assign(std::begin(rhs), std::end(rhs));
     }
     return *this;
   }
-  SmallVector& operator=(SmallVector&& rhs) noexcept {
+  /// Move assignment keeps this vector's allocator. Heap storage is taken over from `rhs` if the allocators compare
+  /// equal; otherwise, or if `rhs` is inline, elements are moved into the storage this vector already has.
+  /// `noexcept` only if the allocator is stateless, and so always compares equal, and elements move without throwing:
+  /// unequal allocators may need this vector to grow.
+  SmallVector& operator=(SmallVector&& rhs) noexcept(std::is_empty_v<TAllocator> && std::is_nothrow_move_constructible_v<TValue>) {
     base_type::clear();
     move_construct_from(std::move(rhs));
     return *this;
   }
 
-  template<size_t C2, size_t A2>
-  SmallVector& operator=(SmallVector<TValue, C2, A2> const& rhs) {
+  template<size_t C2, size_t A2, class L2, class S2, class G2>
+  SmallVector& operator=(SmallVector<TValue, C2, A2, L2, S2, G2> const& rhs) {
     base_type::assign(std::begin(rhs), std::end(rhs));
     return *this;
   }
 
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  /// Releases unused heap capacity, moving elements back to the inline buffer if they fit.
+  void shrink_to_fit() {
+    if (is_inline() || capacity_ == base_type::size_) {
+      return;
+    }
+
+    size_type const new_capacity = std::max<size_type>(base_type::size_, InitialCapacity);
+    bool const to_heap = InitialCapacity < new_capacity;
+    auto new_storage = to_heap
+      ? static_cast<value_type*>(allocator_.allocate(sizeof(value_type) * new_capacity, Alignment))
+      : initial_storage_pointer();
+
+    try {
+      relocate_elements_to(new_storage);
+    }
+    catch (...) {
+      if (to_heap) {
+        allocator_.deallocate(new_storage, sizeof(value_type) * new_capacity, Alignment);
+      }
+      throw;
+    }
+
+    allocator_.deallocate(storage_, sizeof(value_type) * capacity_, Alignment);
+    storage_ = new_storage;
+    capacity_ = static_cast<TSize>(new_capacity);
+  }
+
 protected:
-  [[nodiscard]] value_type* get_storage_pointer_impl() override {
-    return static_cast<value_type*>(storage_pointer_);
+  [[nodiscard]] value_type* get_storage_pointer_impl() {
+    return storage_;
   }
-  [[nodiscard]] value_type const* get_storage_pointer_impl() const override {
-    return static_cast<value_type const*>(storage_pointer_);
+  [[nodiscard]] value_type const* get_storage_pointer_impl() const {
+    return storage_;
   }
-  void ensure_size_impl(size_type new_size) override {
+  void ensure_size_impl(size_type new_size) {
     ensure_size_unsafe_impl(new_size);
   }
-  void ensure_size_unsafe_impl(size_type new_size) override {
-    reserve_capacity(new_size);
-    base_type::size_ = new_size;
+  void ensure_size_unsafe_impl(size_type new_size) {
+    if (capacity_ < new_size) {
+      reserve_capacity(new_size);
+    }
+    base_type::size_ = static_cast<TSize>(new_size);
   }
-  void reserve_impl(size_type new_capacity) override {
+  void reserve_impl(size_type new_capacity) {
     reserve_capacity(new_capacity);
   }
-  [[nodiscard]] size_type max_size_impl() const noexcept override {
-    return std::numeric_limits<size_type>::max();
+  [[nodiscard]] size_type max_size_impl() const noexcept {
+    return std::numeric_limits<TSize>::max();
   }
-  [[nodiscard]] size_type capacity_impl() const noexcept override {
+  [[nodiscard]] size_type capacity_impl() const noexcept {
     return capacity_;
   }
 
 private:
-  void reserve_capacity(size_type new_capacity) {
-    if (new_capacity == 0) return;
+  [[nodiscard]] bool is_inline() const noexcept {
+    return capacity_ <= InitialCapacity;
+  }
+  [[nodiscard]] value_type* initial_storage_pointer() noexcept {
+    return reinterpret_cast<value_type*>(&initial_storage_);
+  }
 
-    auto effective_new_capacity = detail::RoundtoNextPowerOf2(new_capacity);
+  void reserve_capacity(size_type new_capacity) {
+    if (new_capacity <= capacity_) return;
 
-    if (capacity_ <= InitialCapacity && effective_new_capacity <= InitialCapacity) {
-      storage_pointer_ = std::launder(&initial_storage_);
+    // Always spills to the heap from here on, since `InitialCapacity <= capacity_ < new_capacity`.
+    size_type const effective_new_capacity = TGrowthPolicy{}(capacity_, new_capacity);
+    MBASE_ASSERT(new_capacity <= effective_new_capacity);
+    if (max_size_impl() < effective_new_capacity) {
+      throw std::length_error("SmallVector capacity exceeds size type!");
     }
 
-    if (capacity_ < effective_new_capacity) {
-      if (capacity_ <= InitialCapacity) {
-        if (InitialCapacity < effective_new_capacity) {
-          storage_ = AlignedAlloc(sizeof(value_type) * effective_new_capacity, Alignment);
-
-          auto src_first = reinterpret_cast<value_type*>(std::launder(&initial_storage_));
-          auto dst_first = static_cast<value_type*>(storage_);
-
-          detail::non_overlapping_move_strategy<iterator, iterator>::call(src_first, src_first + base_type::size_, dst_first);
-          detail::destruct_strategy<iterator>::on_range(src_first, src_first + base_type::size_);
-
-          storage_pointer_ = static_cast<value_type*>(storage_);
-        }
-      }
-      else {
-        auto new_storage = AlignedAlloc(sizeof(value_type) * effective_new_capacity, Alignment);
-
-        auto src_first = static_cast<value_type*>(storage_);
-        auto dst_first = reinterpret_cast<value_type*>(new_storage);
-
-        detail::non_overlapping_move_strategy<iterator, iterator>::call(src_first, src_first + base_type::size_, dst_first);
-        detail::destruct_strategy<iterator>::on_range(src_first, src_first + base_type::size_);
+    auto new_storage = static_cast<value_type*>(allocator_.allocate(sizeof(value_type) * effective_new_capacity, Alignment));
 
-        AlignedFree(storage_);
-        storage_ = new_storage;
+    try {
+      relocate_elements_to(new_storage);
+    }
+    catch (...) {
+      allocator_.deallocate(new_storage, sizeof(value_type) * effective_new_capacity, Alignment);
+      throw;
+    }
 
-        storage_pointer_ = static_cast<value_type*>(storage_);
-      }
+    if (!is_inline()) {
+      allocator_.deallocate(storage_, sizeof(value_type) * capacity_, Alignment);
+    }
+    storage_ = new_storage;
+    capacity_ = static_cast<TSize>(effective_new_capacity);
+  }
 
-      capacity_ = effective_new_capacity;
+  /// Moves the elements to `new_storage` and destroys them in the current storage. Like `std::vector`, copies
+  /// instead if moving might throw and copying is possible, so that a throw leaves the elements untouched.
+  void relocate_elements_to(value_type* new_storage) {
+    value_type* const first = storage_;
+    value_type* const last = storage_ + base_type::size_;
+    if constexpr (is_trivially_relocatable_v<TValue> || std::is_nothrow_move_constructible_v<TValue> || !std::is_copy_constructible_v<TValue>) {
+      detail::relocate_strategy<value_type>::non_overlapping(first, last, new_storage);
+    }
+    else {
+      std::uninitialized_copy(first, last, new_storage);
+      detail::destruct_strategy<iterator>::on_range(first, last);
     }
   }
 
   void move_construct_from(SmallVector&& rhs) {
     MBASE_ASSERT(this->empty());
 
-    // TODO: Reuse already-allocated storage ?
-    if (InitialCapacity < this->capacity_) {
-      AlignedFree(this->storage_);
-      this->storage_ = nullptr;
-
-      this->capacity_ = InitialCapacity;
-    }
-
-    if (InitialCapacity < rhs.capacity_) {
+    if (!rhs.is_inline() && allocator_ == rhs.allocator_) {
       // Take rhs's guts.
+      if (!is_inline()) {
+        allocator_.deallocate(storage_, sizeof(value_type) * capacity_, Alignment);
+      }
 
       this->size_ = rhs.size_;
-      this->capacity_ = rhs.capacity_;
-      this->storage_ = rhs.storage_;
-      this->storage_pointer_ = static_cast<value_type*>(this->storage_);
+      capacity_ = rhs.capacity_;
+      storage_ = rhs.storage_;
 
       rhs.size_ = 0;
       rhs.capacity_ = InitialCapacity;
-      rhs.storage_ = nullptr;
-      rhs.storage_pointer_ = std::launder(&rhs.initial_storage_);
+      rhs.storage_ = rhs.initial_storage_pointer();
     }
     else {
-      if constexpr (std::is_trivially_copyable_v<TValue>) {
-        memcpy(&this->initial_storage_, &rhs.initial_storage_, rhs.size_in_bytes());
+      // Reuse the storage we already have, growing only if it is too small.
+      reserve_capacity(rhs.size_);
+
+      if constexpr (is_trivially_relocatable_v<TValue>) {
+        detail::relocate_strategy<value_type>::non_overlapping(rhs.begin(), rhs.end(), this->begin());
         this->size_ = rhs.size_;
+        rhs.size_ = 0;
       }
       else {
         for (auto& v : rhs) {
           this->emplace_back(std::move(v));
         }
-      }
 
-      rhs.clear();
+        rhs.clear();
+      }
     }
   }
 
-  size_type capacity_ = InitialCapacity;
+  TSize capacity_ = InitialCapacity;
+
+  /// Points at `initial_storage_` or at heap storage, depending on `is_inline()`.
+  value_type* storage_ = initial_storage_pointer();
 
   using InitialStorageType = std::byte[sizeof(value_type) * InitialCapacity];
   static_assert(std::is_trivially_destructible_v<InitialStorageType>);
 
   alignas(Alignment) InitialStorageType initial_storage_ {};
 
-  void* storage_ = nullptr;
-
-  void* storage_pointer_ = std::launder(&initial_storage_);
+  MBASE_NO_UNIQUE_ADDRESS allocator_type allocator_ {};
 };
 
+/// `SmallVector` with 32-bit size and capacity, for vectors embedded in large numbers of other objects.
+///
+/// Header size (bytes) in front of the inline buffer on 64-bit platforms, with a stateless allocator:
+///   - `SmallVector`:        24 (size, capacity, data pointer)
+///   - `CompactSmallVector`: 16
+/// e.g. `sizeof(SmallVector<uint32_t, 4>)` is 40 and `sizeof(CompactSmallVector<uint32_t, 4>)` is 32.
+/// (Before devirtualization and dropping the duplicated storage pointer, the header was 40 bytes and the former was 56.)
+template<
+  class TValue,
+  size_t InitialCapacity,
+  size_t Alignment = std::max(alignof(TValue), sizeof(void*)),
+  class TAllocator = AlignedAllocator,
+  class TGrowthPolicy = PowerOf2GrowthPolicy
+>
+using CompactSmallVector = SmallVector<TValue, InitialCapacity, Alignment, TAllocator, uint32_t, TGrowthPolicy>;
+
+#if MBASE_PLATFORM_64_BIT
+static_assert(sizeof(SmallVector<uint32_t, 4>) == 24 + 16);
+static_assert(sizeof(CompactSmallVector<uint32_t, 4>) == 16 + 16);
+static_assert(sizeof(SmallVector<void*, 8>) == 24 + 64);
+static_assert(sizeof(CompactSmallVector<void*, 8>) == 16 + 64);
+#endif
+
 template<class TValue, size_t Capacity, size_t Alignment>
-class StaticVectorImpl : public VectorBase<TValue> {
+class StaticVectorImpl : public VectorBase<TValue, StaticVectorImpl<TValue, Capacity, Alignment>> {
 public:
-  using base_type = VectorBase<TValue>;
+  using base_type = VectorBase<TValue, StaticVectorImpl<TValue, Capacity, Alignment>>;
+  friend base_type;
 
   using value_type = typename base_type::value_type;
   using size_type = typename base_type::size_type;
@@ -525,91 +805,106 @@ public:
   using reverse_iterator = typename base_type::reverse_iterator;
   using const_reverse_iterator = typename base_type::const_reverse_iterator;
 
-  [[nodiscard]] explicit StaticVectorImpl(size_t n) {
+  [[nodiscard]] constexpr explicit StaticVectorImpl(size_t n) {
     ensure_size_impl(n);
     detail::construct_strategy<iterator>::on_range(this->begin(), this->end());
   }
-  [[nodiscard]] StaticVectorImpl(size_t n, value_type const& value) {
+  [[nodiscard]] constexpr StaticVectorImpl(size_t n, value_type const& value) {
     base_type::assign(n, value);
   }
-  [[nodiscard]] StaticVectorImpl(StaticVectorImpl const& rhs) {
+  [[nodiscard]] constexpr StaticVectorImpl(StaticVectorImpl const& rhs) {
     base_type::assign(std::begin(rhs), std::end(rhs));
   }
-  [[nodiscard]] StaticVectorImpl(StaticVectorImpl&& rhs) noexcept {
+  [[nodiscard]] constexpr StaticVectorImpl(StaticVectorImpl&& rhs) noexcept {
     move_construct_from(std::move(rhs));
   }
   template<size_t C2, size_t A2>
-  [[nodiscard]] StaticVectorImpl(StaticVectorImpl<TValue, C2, A2> const& rhs) {
+  [[nodiscard]] constexpr StaticVectorImpl(StaticVectorImpl<TValue, C2, A2> const& rhs) {
     base_type::assign(std::begin(rhs), std::end(rhs));
   }
   template<class TInputIterator>
-  [[nodiscard]] StaticVectorImpl(TInputIterator first, TInputIterator last) {
+  [[nodiscard]] constexpr StaticVectorImpl(TInputIterator first, TInputIterator last) {
     base_type::assign(first, last);
   }
-  [[nodiscard]] StaticVectorImpl(std::initializer_list<value_type> const& values) {
+  [[nodiscard]] constexpr StaticVectorImpl(std::initializer_list<value_type> const& values) {
     base_type::assign(std::begin(values), std::end(values));
   }
 
-  StaticVectorImpl& operator=(StaticVectorImpl const& rhs) {
+  constexpr StaticVectorImpl& operator=(StaticVectorImpl const& rhs) {
     base_type::assign(std::begin(rhs), std::end(rhs));
     return *this;
   }
-  StaticVectorImpl& operator=(StaticVectorImpl&& rhs) noexcept {
+  constexpr StaticVectorImpl& operator=(StaticVectorImpl&& rhs) noexcept {
     base_type::clear();
     move_construct_from(std::move(rhs));
     return *this;
   }
 
   template<size_t C2, size_t A2>
-  StaticVectorImpl& operator=(StaticVectorImpl<TValue, C2, A2> const& rhs) {
+  constexpr StaticVectorImpl& operator=(StaticVectorImpl<TValue, C2, A2> const& rhs) {
     base_type::assign(std::begin(rhs), std::end(rhs));
     return *this;
   }
 
 protected:
-  StaticVectorImpl() = default;
-  ~StaticVectorImpl() override = default;
+  constexpr StaticVectorImpl() = default;
+  constexpr ~StaticVectorImpl() = default;
 
-  [[nodiscard]] value_type* get_storage_pointer_impl() override {
-    return reinterpret_cast<value_type*>(&storage_);
+  [[nodiscard]] constexpr value_type* get_storage_pointer_impl() {
+    if constexpr (kTypedStorage) {
+      return storage_;
+    }
+    else {
+      return reinterpret_cast<value_type*>(&storage_);
+    }
   }
-  [[nodiscard]] value_type const* get_storage_pointer_impl() const override {
-    return reinterpret_cast<value_type const*>(&storage_);
+  [[nodiscard]] constexpr value_type const* get_storage_pointer_impl() const {
+    if constexpr (kTypedStorage) {
+      return storage_;
+    }
+    else {
+      return reinterpret_cast<value_type const*>(&storage_);
+    }
   }
-  void ensure_size_impl(size_type new_size) override {
+  constexpr void ensure_size_impl(size_type new_size) {
     if (Capacity < new_size) {
       throw std::bad_alloc();
     }
     ensure_size_unsafe_impl(new_size);
   }
-  void ensure_size_unsafe_impl(size_type new_size) override {
+  constexpr void ensure_size_unsafe_impl(size_type new_size) {
     base_type::size_ = std::max(base_type::size_, new_size);
   }
-  void reserve_impl([[maybe_unused]] size_type new_capacity) override {
+  constexpr void reserve_impl([[maybe_unused]] size_type new_capacity) {
   }
-  [[nodiscard]] size_type max_size_impl() const noexcept override {
+  [[nodiscard]] constexpr size_type max_size_impl() const noexcept {
     return Capacity;
   }
-  [[nodiscard]] size_type capacity_impl() const noexcept override {
+  [[nodiscard]] constexpr size_type capacity_impl() const noexcept {
     return Capacity;
   }
   
 private:
-  void move_construct_from(StaticVectorImpl&& rhs) {
-    if constexpr (std::is_trivially_copyable_v<TValue>) {
-      memcpy(&storage_, &rhs.storage_, sizeof(storage_));
+  constexpr void move_construct_from(StaticVectorImpl&& rhs) {
+    if constexpr (is_trivially_relocatable_v<TValue>) {
+      detail::relocate_strategy<value_type>::non_overlapping(rhs.begin(), rhs.end(), this->begin());
       base_type::size_ = rhs.size_;
+      rhs.size_ = 0;
     }
     else {
       for (auto& v : rhs) {
         this->emplace_back(std::move(v));
       }
-    }
 
-    rhs.clear();
+      rhs.clear();
+    }
   }
 
-  using StorageType = std::byte[sizeof(value_type) * Capacity];
+  /// Elements that need neither construction nor destruction are stored as a `value_type` array rather than raw bytes,
+  /// which constant evaluation can access without `reinterpret_cast`.
+  static constexpr bool kTypedStorage = std::is_trivially_default_constructible_v<value_type> && std::is_trivially_destructible_v<value_type>;
+
+  using StorageType = std::conditional_t<kTypedStorage, value_type[Capacity], std::byte[sizeof(value_type) * Capacity]>;
   static_assert(std::is_trivially_destructible_v<StorageType>);
 
   alignas(Alignment) StorageType storage_ {};
@@ -620,7 +915,7 @@ class ConditionallyTriviallyDestructibleStaticVector final : public StaticVector
 public:
   using StaticVectorImpl<TValue, Capacity, Alignment>::StaticVectorImpl;
 
-  ~ConditionallyTriviallyDestructibleStaticVector() override {
+  constexpr ~ConditionallyTriviallyDestructibleStaticVector() {
     this->clear();
   }
 private:
@@ -631,29 +926,37 @@ class ConditionallyTriviallyDestructibleStaticVector<TValue, Capacity, Alignment
 public:
   using StaticVectorImpl<TValue, Capacity, Alignment>::StaticVectorImpl;
 
-  ~ConditionallyTriviallyDestructibleStaticVector() override = default;
+  ~ConditionallyTriviallyDestructibleStaticVector() = default;
 private:
 };
 
 /// A vector with a static capacity. `TriviallyDestructible` if TValue is `TriviallyDestructible`.
+/// Usable in constant expressions if TValue is also `TriviallyDefaultConstructible` (e.g. scalars and aggregates of
+/// them), so that lookup tables can be built by `constexpr` functions and land in read-only data:
+///   constexpr auto kTable = [] {
+///     StaticVector<uint16_t, 256> table;
+///     ...
+///     std::sort(table.begin(), table.end());
+///     return table;
+///   }();
 template<class TValue, size_t Capacity, size_t Alignment = alignof(TValue)>
 using StaticVector = ConditionallyTriviallyDestructibleStaticVector<TValue, Capacity, Alignment>;
 
 template<class TValue, size_t C1, size_t A1, size_t C2, size_t A2>
-bool operator==(StaticVector<TValue, C1, A1> const& lhs, StaticVector<TValue, C2, A2> const& rhs) {
+constexpr bool operator==(StaticVector<TValue, C1, A1> const& lhs, StaticVector<TValue, C2, A2> const& rhs) {
   return lhs.size() == rhs.size() && std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs));
 }
 template<class TValue, size_t C1, size_t A1, size_t C2, size_t A2>
-bool operator!=(StaticVector<TValue, C1, A1> const& lhs, StaticVector<TValue, C2, A2> const& rhs) {
+constexpr bool operator!=(StaticVector<TValue, C1, A1> const& lhs, StaticVector<TValue, C2, A2> const& rhs) {
   return !operator==(lhs, rhs);
 }
 
-template<class TValue, size_t C1, size_t A1, size_t C2, size_t A2>
-bool operator==(SmallVector<TValue, C1, A1> const& lhs, SmallVector<TValue, C2, A2> const& rhs) {
+template<class TValue, size_t C1, size_t A1, class L1, class S1, class G1, size_t C2, size_t A2, class L2, class S2, class G2>
+bool operator==(SmallVector<TValue, C1, A1, L1, S1, G1> const& lhs, SmallVector<TValue, C2, A2, L2, S2, G2> const& rhs) {
   return lhs.size() == rhs.size() && std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs));
 }
-template<class TValue, size_t C1, size_t A1, size_t C2, size_t A2>
-bool operator!=(SmallVector<TValue, C1, A1> const& lhs, SmallVector<TValue, C2, A2> const& rhs) {
+template<class TValue, size_t C1, size_t A1, class L1, class S1, class G1, size_t C2, size_t A2, class L2, class S2, class G2>
+bool operator!=(SmallVector<TValue, C1, A1, L1, S1, G1> const& lhs, SmallVector<TValue, C2, A2, L2, S2, G2> const& rhs) {
   return !operator==(lhs, rhs);
 }
 
@@ -0,0 +1,208 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/call.h"
+#include "mbase/public/container.h"
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+/// Split-block Bloom filter: every key sets one bit in each of the 8 words of one 64-byte block, so an insert or a
+/// query touches a single cache line and no bit positions depend on each other.
+/// No false negatives; see `FalsePositiveRate` for sizing.
+/// Keys are hashed as `TKey`, so that equal keys of other types (e.g. integers of another width) find it; with a
+/// transparent `THash`, string-like keys are hashed as they are (see `detail::KeyHasher`).
+/// `THash` maps keys to 64-bit hashes (`Hash64`, i.e. `Hasher64`, by default); it must be stable across processes for
+/// `words()` to be persisted.
+/// Const member functions may be called concurrently.
+template<class TKey, class THash = Hash64, class TAllocator = AlignedAllocator>
+class BloomFilter final {
+public:
+  using key_type = TKey;
+  using hasher = THash;
+  using allocator_type = TAllocator;
+  using word_type = uint64_t;
+
+  /// Heterogeneous keys are accepted when `THash` is transparent.
+  template<class K>
+  using key_arg = typename detail::KeyArg<is_transparent_v<THash>>::template type<K, key_type>;
+
+  static constexpr size_t kBlockWords = 8;
+  static constexpr size_t kBlockSize = kBlockWords * sizeof(word_type);
+
+  BloomFilter() = default;
+  /// Sized so that `expected_count` keys give at most `false_positive_rate`.
+  BloomFilter(size_t expected_count, double false_positive_rate, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) :
+    words_(BlockCountFor(expected_count, false_positive_rate) * kBlockWords, word_type(0), allocator),
+    hash_(hash)
+  {
+  }
+  /// Restores a filter from `words()` of one using the same hasher.
+  explicit BloomFilter(ArrayProxy<word_type const> words, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) :
+    words_(words.begin(), words.end(), allocator),
+    hash_(hash)
+  {
+    if (words.empty() || words.size() % kBlockWords != 0 || words.size() / kBlockWords > UINT32_MAX) {
+      throw std::length_error("BloomFilter word count is not a valid block count!");
+    }
+  }
+
+  [[nodiscard]] size_t block_count() const noexcept { return words_.size() / kBlockWords; }
+  [[nodiscard]] size_t bit_count() const noexcept { return words_.size() * 64; }
+  [[nodiscard]] hasher hash_function() const { return hash_.get(); }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return words_.get_allocator(); }
+  /// The bit array, for serialization. Words are in host byte order.
+  [[nodiscard]] ArrayProxy<word_type const> words() const noexcept { return { words_.data(), words_.size() }; }
+
+  template<class K = key_type>
+  void insert(key_arg<K> const& key) {
+    insert_hash(hash_(key));
+  }
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    return contains_hash(hash_(key));
+  }
+
+  void insert_hash(uint64_t hash) noexcept {
+    if (words_.empty()) {
+      return;
+    }
+    word_type* block = words_.data() + BlockIndex(hash) * kBlockWords;
+    for (size_t i = 0; i != kBlockWords; ++i) {
+      block[i] |= BlockBit(hash, i);
+    }
+  }
+  [[nodiscard]] bool contains_hash(uint64_t hash) const noexcept {
+    if (words_.empty()) {
+      return false;
+    }
+    word_type const* block = words_.data() + BlockIndex(hash) * kBlockWords;
+    word_type missing = 0;
+    for (size_t i = 0; i != kBlockWords; ++i) {
+      missing |= BlockBit(hash, i) & ~block[i];
+    }
+    return missing == 0;
+  }
+
+  /// Hashes a group of keys ahead and prefetches their blocks before touching them.
+  template<class K = key_type>
+  void insert_batch(ArrayProxy<key_arg<K> const> keys) {
+    for_each_hash_batch(keys, [&](size_t, uint64_t hash) {
+      insert_hash(hash);
+    });
+  }
+  /// `found[i] = contains(keys[i])`.
+  template<class K = key_type>
+  void contains_batch(ArrayProxy<key_arg<K> const> keys, ArrayProxy<bool> found) const {
+    MBASE_ASSERT(keys.size() == found.size());
+    for_each_hash_batch(keys, [&](size_t i, uint64_t hash) {
+      found[i] = contains_hash(hash);
+    });
+  }
+
+  void clear() noexcept {
+    std::fill(words_.begin(), words_.end(), word_type(0));
+  }
+  /// Adds every key of `rhs`, which must have the same block count and hasher.
+  void merge(BloomFilter const& rhs) {
+    MBASE_ASSERT_MSG(words_.size() == rhs.words_.size(), "BloomFilter block counts differ!");
+    for (size_t i = 0; i != words_.size(); ++i) {
+      words_[i] |= rhs.words_[i];
+    }
+  }
+
+  void swap(BloomFilter& rhs) noexcept {
+    std::swap(words_, rhs.words_);
+    std::swap(hash_, rhs.hash_);
+  }
+
+  /// Expected false positive rate with `count` keys in `block_count` blocks: the single-block rate averaged over the
+  /// Poisson distribution of keys per block.
+  [[nodiscard]] static double FalsePositiveRate(size_t count, size_t block_count) {
+    if (block_count == 0) {
+      return 1.0;
+    }
+    double const mean = double(count) / double(block_count);
+    double const spread = 8.0 * std::sqrt(mean) + 8.0;
+    size_t const first = size_t(std::max(0.0, mean - spread));
+    size_t const last = size_t(mean + spread) + 1;
+    double rate = 0.0;
+    for (size_t keys = first; keys != last; ++keys) {
+      double const probability = mean > 0.0
+        ? std::exp(double(keys) * std::log(mean) - mean - std::lgamma(double(keys) + 1.0))
+        : (keys == 0 ? 1.0 : 0.0);
+      double const bit_set = 1.0 - std::pow(1.0 - 1.0 / 64.0, double(keys));
+      rate += probability * std::pow(bit_set, double(kBlockWords));
+    }
+    return std::min(rate, 1.0);
+  }
+  /// Smallest block count giving at most `false_positive_rate` with `count` keys.
+  [[nodiscard]] static size_t BlockCountFor(size_t count, double false_positive_rate) {
+    MBASE_ASSERT_MSG(false_positive_rate > 0.0 && false_positive_rate < 1.0, "BloomFilter false positive rate must be in (0, 1)!");
+    size_t high = 1;
+    while (FalsePositiveRate(count, high) > false_positive_rate) {
+      if (high > UINT32_MAX / 2) {
+        throw std::length_error("BloomFilter would exceed the maximum block count!");
+      }
+      high *= 2;
+    }
+    size_t low = high / 2;
+    while (high - low > 1) {
+      size_t const mid = low + (high - low) / 2;
+      (FalsePositiveRate(count, mid) > false_positive_rate ? low : high) = mid;
+    }
+    return high;
+  }
+
+private:
+  static constexpr size_t kBatchSize = 16;
+  /// Odd multipliers spreading the low hash half over the 8 words (as in the Parquet split-block filter).
+  static constexpr uint32_t kSalts[kBlockWords] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+  };
+
+  /// High hash half scaled onto the block count.
+  [[nodiscard]] size_t BlockIndex(uint64_t hash) const noexcept {
+    return size_t((hash >> 32) * uint64_t(block_count()) >> 32);
+  }
+  [[nodiscard]] static word_type BlockBit(uint64_t hash, size_t word) noexcept {
+    return word_type(1) << ((uint32_t(hash) * kSalts[word]) >> 26);
+  }
+
+  template<class K, class TFunction>
+  void for_each_hash_batch(ArrayProxy<K const> keys, TFunction&& function) const {
+    uint64_t hashes[kBatchSize];
+    for (size_t first = 0; first < keys.size(); first += kBatchSize) {
+      size_t const count = std::min(kBatchSize, keys.size() - first);
+      for (size_t j = 0; j != count; ++j) {
+        hashes[j] = hash_(keys[first + j]);
+        if (!words_.empty()) {
+          MBASE_PREFETCH(words_.data() + BlockIndex(hashes[j]) * kBlockWords);
+        }
+      }
+      for (size_t j = 0; j != count; ++j) {
+        function(first + j, hashes[j]);
+      }
+    }
+  }
+
+  SmallVector<word_type, kBlockWords, kBlockSize, TAllocator> words_;
+  MBASE_NO_UNIQUE_ADDRESS detail::KeyHasher<THash, TKey> hash_ {};
+};
+
+} // namespace mbase
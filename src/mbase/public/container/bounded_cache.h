@@ -0,0 +1,558 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/access.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/tsa.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+enum class CacheEviction {
+  /// Evicts the least recently used entry; every hit relinks the entry.
+  kLru,
+  /// Second chance: a hit only sets a flag, and a clock hand sweeping the slots evicts the first unflagged entry,
+  /// clearing flags as it goes. Approximates LRU with cheaper hits.
+  kClock,
+};
+
+/// Default `BoundedCache` eviction callback: does nothing.
+struct NoEvictionCallback final {
+  template<class K, class V>
+  void operator()(K const&, V&) const noexcept {}
+};
+
+/// Fixed-capacity key-value cache: once full, inserting evicts an entry chosen by `Eviction`.
+/// Entries live in flat storage allocated up front, linked into recency order by 32-bit indices, and are found
+/// through an open-addressing index table, so no operation allocates after construction.
+/// `TOnEvict(key, value)` is called for entries evicted to make room, before they are destroyed; not for `erase`,
+/// `clear` or assignment.
+/// Pointers to values stay valid until their entry is evicted or erased.
+template<
+  class TKey,
+  class TValue,
+  CacheEviction Eviction = CacheEviction::kLru,
+  class TOnEvict = NoEvictionCallback,
+  class THash = Hash64,
+  class TEqual = std::equal_to<>,
+  class TAllocator = AlignedAllocator
+>
+class BoundedCache final {
+public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using value_type = std::pair<TKey const, TValue>;
+  using size_type = size_t;
+  using hasher = THash;
+  using key_equal = TEqual;
+  using allocator_type = TAllocator;
+  template<class K>
+  using key_arg = typename detail::KeyArg<is_transparent_v<THash> && is_transparent_v<TEqual>>::template type<K, key_type>;
+
+  static constexpr CacheEviction kEviction = Eviction;
+
+  explicit BoundedCache(
+    size_type capacity,
+    TOnEvict const& on_evict = TOnEvict(),
+    THash const& hash = THash(),
+    TEqual const& equal = TEqual(),
+    TAllocator const& allocator = TAllocator()
+  ) :
+    nodes_(allocator),
+    table_(allocator),
+    on_evict_(on_evict),
+    hash_(hash),
+    equal_(equal),
+    allocator_(allocator)
+  {
+    if (capacity == 0 || capacity >= kNil) {
+      throw std::length_error("BoundedCache capacity out of range!");
+    }
+    size_t const table_size = std::bit_ceil(capacity * 2);
+    table_shift_ = uint32_t(64 - std::countr_zero(table_size));
+    table_.resize(table_size, uint32_t(0));
+    nodes_.resize(capacity, Node {});
+    for (size_t i = 0; i != capacity; ++i) {
+      nodes_[i].next = i + 1 != capacity ? uint32_t(i + 1) : kNil;
+    }
+    free_head_ = 0;
+    slots_ = static_cast<value_type*>(allocator_.allocate(sizeof(value_type) * capacity, alignof(value_type)));
+  }
+  BoundedCache(BoundedCache&& rhs) noexcept :
+    nodes_(std::move(rhs.nodes_)),
+    table_(std::move(rhs.table_)),
+    slots_(std::exchange(rhs.slots_, nullptr)),
+    size_(std::exchange(rhs.size_, 0)),
+    head_(std::exchange(rhs.head_, kNil)),
+    tail_(std::exchange(rhs.tail_, kNil)),
+    free_head_(std::exchange(rhs.free_head_, kNil)),
+    hand_(std::exchange(rhs.hand_, 0)),
+    table_shift_(rhs.table_shift_),
+    on_evict_(std::move(rhs.on_evict_)),
+    hash_(std::move(rhs.hash_)),
+    equal_(std::move(rhs.equal_)),
+    allocator_(rhs.allocator_)
+  {
+  }
+  ~BoundedCache() {
+    if (slots_ != nullptr) {
+      clear();
+      allocator_.deallocate(slots_, sizeof(value_type) * nodes_.size(), alignof(value_type));
+    }
+  }
+  MBASE_DISALLOW_COPY(BoundedCache);
+  BoundedCache& operator=(BoundedCache&& rhs) noexcept {
+    if (this != &rhs) {
+      BoundedCache tmp(std::move(rhs));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] size_type capacity() const noexcept { return nodes_.size(); }
+  [[nodiscard]] hasher hash_function() const { return hash_.get(); }
+  [[nodiscard]] key_equal key_eq() const { return equal_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  /// Looks up `key` and marks it as used; `nullptr` on a miss.
+  template<class K = key_type>
+  [[nodiscard]] TValue* find(key_arg<K> const& key) {
+    return find_hashed<K>(key, hash_(key));
+  }
+  /// `find` with `hash` the hash of `key` as the cache hashes it, e.g. already computed to pick a shard.
+  template<class K = key_type>
+  [[nodiscard]] TValue* find_hashed(key_arg<K> const& key, uint64_t hash) {
+    uint32_t const index = lookup(key, hash).second;
+    if (index == kNil) {
+      return nullptr;
+    }
+    touch(index);
+    return &slots_[index].second;
+  }
+  /// Looks up `key` without marking it as used.
+  template<class K = key_type>
+  [[nodiscard]] TValue const* peek(key_arg<K> const& key) const {
+    uint32_t const index = lookup(key, hash_(key)).second;
+    return index != kNil ? &slots_[index].second : nullptr;
+  }
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    return lookup(key, hash_(key)).second != kNil;
+  }
+
+  /// Inserts `key` with a value constructed from `args` unless present; either way `key` is marked as used.
+  template<class K = key_type, class ... Args>
+  std::pair<TValue*, bool> try_emplace(key_arg<K> const& key, Args&& ... args) {
+    return try_emplace_hashed<K>(key, hash_(key), std::forward<Args>(args)...);
+  }
+  template<class K = key_type, class ... Args>
+  std::pair<TValue*, bool> try_emplace_hashed(key_arg<K> const& key, uint64_t hash, Args&& ... args) {
+    return find_or_insert(key, hash, [&](value_type* slot) {
+      new(slot) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+    });
+  }
+  template<class ... Args>
+  std::pair<TValue*, bool> try_emplace(key_type&& key, Args&& ... args) {
+    uint64_t const hash = hash_(key);
+    return find_or_insert(key, hash, [&](value_type* slot) {
+      new(slot) value_type(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    });
+  }
+
+  template<class K = key_type, class V>
+  std::pair<TValue*, bool> insert_or_assign(key_arg<K> const& key, V&& value) {
+    return insert_or_assign_hashed<K>(key, hash_(key), std::forward<V>(value));
+  }
+  template<class K = key_type, class V>
+  std::pair<TValue*, bool> insert_or_assign_hashed(key_arg<K> const& key, uint64_t hash, V&& value) {
+    auto result = try_emplace_hashed<K>(key, hash, std::forward<V>(value));
+    if (!result.second) {
+      *result.first = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  /// Returns `false` if `key` was not present.
+  template<class K = key_type>
+  bool erase(key_arg<K> const& key) {
+    return erase_hashed<K>(key, hash_(key));
+  }
+  template<class K = key_type>
+  bool erase_hashed(key_arg<K> const& key, uint64_t hash) {
+    auto const [position, index] = lookup(key, hash);
+    if (index == kNil) {
+      return false;
+    }
+    remove(position, index);
+    return true;
+  }
+
+  /// Destroys all entries without calling the eviction callback.
+  void clear() noexcept {
+    for (size_t i = 0; i != nodes_.size(); ++i) {
+      if (nodes_[i].occupied) {
+        std::destroy_at(slots_ + i);
+      }
+      nodes_[i] = Node {};
+      nodes_[i].next = i + 1 != nodes_.size() ? uint32_t(i + 1) : kNil;
+    }
+    std::fill(table_.begin(), table_.end(), uint32_t(0));
+    size_ = 0;
+    head_ = kNil;
+    tail_ = kNil;
+    free_head_ = nodes_.empty() ? kNil : 0;
+    hand_ = 0;
+  }
+
+  /// Calls `function(key, value)` for every entry, most recently used first for `kLru`, in slot order for `kClock`.
+  template<class TFunction>
+  void for_each(TFunction&& function) {
+    if constexpr (Eviction == CacheEviction::kLru) {
+      for (uint32_t i = head_; i != kNil; i = nodes_[i].next) {
+        function(slots_[i].first, slots_[i].second);
+      }
+    }
+    else {
+      for (size_t i = 0; i != nodes_.size(); ++i) {
+        if (nodes_[i].occupied) {
+          function(slots_[i].first, slots_[i].second);
+        }
+      }
+    }
+  }
+
+  void swap(BoundedCache& rhs) noexcept {
+    std::swap(nodes_, rhs.nodes_);
+    std::swap(table_, rhs.table_);
+    std::swap(slots_, rhs.slots_);
+    std::swap(size_, rhs.size_);
+    std::swap(head_, rhs.head_);
+    std::swap(tail_, rhs.tail_);
+    std::swap(free_head_, rhs.free_head_);
+    std::swap(hand_, rhs.hand_);
+    std::swap(table_shift_, rhs.table_shift_);
+    std::swap(on_evict_, rhs.on_evict_);
+    std::swap(hash_, rhs.hash_);
+    std::swap(equal_, rhs.equal_);
+    std::swap(allocator_, rhs.allocator_);
+  }
+
+private:
+  static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+
+  /// Per-slot metadata. `prev`/`next` link live entries in recency order (`kLru` only) and free slots into a list.
+  struct Node final {
+    uint64_t hash = 0;
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    bool occupied = false;
+    /// `kClock` only: used since the hand last passed.
+    bool referenced = false;
+  };
+
+  [[nodiscard]] size_t home_position(uint64_t hash) const noexcept {
+    // Fibonacci hashing: the multiply mixes low-entropy hashes into the top bits.
+    return size_t((hash * 0x9e3779b97f4a7c15) >> table_shift_);
+  }
+  [[nodiscard]] size_t table_mask() const noexcept {
+    return table_.size() - 1;
+  }
+
+  /// Table position and entry index of `key`, or the empty position ending the probe and `kNil`.
+  template<class K>
+  [[nodiscard]] std::pair<size_t, uint32_t> lookup(K const& key, uint64_t hash) const {
+    for (size_t position = home_position(hash);; position = (position + 1) & table_mask()) {
+      uint32_t const entry = table_[position];
+      if (entry == 0) {
+        return { position, kNil };
+      }
+      uint32_t const index = entry - 1;
+      if (nodes_[index].hash == hash && equal_(slots_[index].first, key)) {
+        return { position, index };
+      }
+    }
+  }
+  /// Table position holding entry `index`.
+  [[nodiscard]] size_t position_of(uint32_t index) const noexcept {
+    size_t position = home_position(nodes_[index].hash);
+    while (table_[position] != index + 1) {
+      position = (position + 1) & table_mask();
+    }
+    return position;
+  }
+
+  template<class K, class TConstruct>
+  std::pair<TValue*, bool> find_or_insert(K const& key, uint64_t hash, TConstruct&& construct) {
+    auto [position, index] = lookup(key, hash);
+    if (index != kNil) {
+      touch(index);
+      return { &slots_[index].second, false };
+    }
+    if (free_head_ == kNil) {
+      uint32_t const victim = pick_victim();
+      on_evict_(slots_[victim].first, slots_[victim].second);
+      remove(position_of(victim), victim);
+      // Removing shifts later entries back; the probe for `key` may now end earlier.
+      position = lookup(key, hash).first;
+    }
+    index = free_head_;
+    construct(slots_ + index);
+    free_head_ = nodes_[index].next;
+
+    Node& node = nodes_[index];
+    node.hash = hash;
+    node.occupied = true;
+    node.referenced = false;
+    link_front(index);
+    table_[position] = index + 1;
+    ++size_;
+    return { &slots_[index].second, true };
+  }
+
+  /// Unlinks and destroys entry `index` at table `position`, and closes the gap by shifting back later entries of the
+  /// probe run (no tombstones).
+  void remove(size_t position, uint32_t index) noexcept {
+    unlink(index);
+    std::destroy_at(slots_ + index);
+    nodes_[index].occupied = false;
+    nodes_[index].next = free_head_;
+    free_head_ = index;
+    --size_;
+
+    size_t hole = position;
+    for (size_t next = (hole + 1) & table_mask(); table_[next] != 0; next = (next + 1) & table_mask()) {
+      size_t const home = home_position(nodes_[table_[next] - 1].hash);
+      // Movable into the hole unless its home lies cyclically within (hole, next].
+      if (((next - home) & table_mask()) >= ((next - hole) & table_mask())) {
+        table_[hole] = table_[next];
+        hole = next;
+      }
+    }
+    table_[hole] = 0;
+  }
+
+  void touch(uint32_t index) noexcept {
+    if constexpr (Eviction == CacheEviction::kLru) {
+      if (head_ != index) {
+        unlink(index);
+        link_front(index);
+      }
+    }
+    else {
+      nodes_[index].referenced = true;
+    }
+  }
+  void link_front(uint32_t index) noexcept {
+    if constexpr (Eviction == CacheEviction::kLru) {
+      nodes_[index].prev = kNil;
+      nodes_[index].next = head_;
+      if (head_ != kNil) {
+        nodes_[head_].prev = index;
+      }
+      head_ = index;
+      if (tail_ == kNil) {
+        tail_ = index;
+      }
+    }
+  }
+  void unlink(uint32_t index) noexcept {
+    if constexpr (Eviction == CacheEviction::kLru) {
+      Node& node = nodes_[index];
+      (node.prev != kNil ? nodes_[node.prev].next : head_) = node.next;
+      (node.next != kNil ? nodes_[node.next].prev : tail_) = node.prev;
+    }
+  }
+
+  /// The cache is full when this is called, so every slot is occupied.
+  [[nodiscard]] uint32_t pick_victim() noexcept {
+    if constexpr (Eviction == CacheEviction::kLru) {
+      return tail_;
+    }
+    else {
+      for (;;) {
+        uint32_t const index = hand_;
+        hand_ = hand_ + 1 != nodes_.size() ? hand_ + 1 : 0;
+        if (!std::exchange(nodes_[index].referenced, false)) {
+          return index;
+        }
+      }
+    }
+  }
+
+  SmallVector<Node, 1, alignof(uint64_t), TAllocator> nodes_;
+  /// Entry index + 1 per position; 0 is empty.
+  SmallVector<uint32_t, 1, alignof(uint32_t), TAllocator> table_;
+  /// `capacity()` entries, live where `nodes_[i].occupied`.
+  value_type* slots_ = nullptr;
+  size_t size_ = 0;
+  uint32_t head_ = kNil;
+  uint32_t tail_ = kNil;
+  uint32_t free_head_ = kNil;
+  uint32_t hand_ = 0;
+  uint32_t table_shift_ = 63;
+  MBASE_NO_UNIQUE_ADDRESS TOnEvict on_evict_ {};
+  MBASE_NO_UNIQUE_ADDRESS detail::KeyHasher<THash, TKey> hash_ {};
+  MBASE_NO_UNIQUE_ADDRESS TEqual equal_ {};
+  MBASE_NO_UNIQUE_ADDRESS TAllocator allocator_ {};
+};
+
+template<class TKey, class TValue, class TOnEvict = NoEvictionCallback, class THash = Hash64, class TEqual = std::equal_to<>, class TAllocator = AlignedAllocator>
+using LruCache = BoundedCache<TKey, TValue, CacheEviction::kLru, TOnEvict, THash, TEqual, TAllocator>;
+template<class TKey, class TValue, class TOnEvict = NoEvictionCallback, class THash = Hash64, class TEqual = std::equal_to<>, class TAllocator = AlignedAllocator>
+using ClockCache = BoundedCache<TKey, TValue, CacheEviction::kClock, TOnEvict, THash, TEqual, TAllocator>;
+
+/// `BoundedCache` split into `ShardCount` independently locked shards picked by key hash, so that threads working on
+/// different keys rarely contend. Capacity is divided evenly and eviction is per shard.
+/// Values are returned by copy, or visited under the shard lock; the eviction callback also runs under it.
+template<
+  class TKey,
+  class TValue,
+  CacheEviction Eviction = CacheEviction::kLru,
+  size_t ShardCount = 16,
+  class TOnEvict = NoEvictionCallback,
+  class THash = Hash64,
+  class TEqual = std::equal_to<>,
+  class TAllocator = AlignedAllocator
+>
+class ShardedBoundedCache final {
+  using shard_cache_type = BoundedCache<TKey, TValue, Eviction, TOnEvict, THash, TEqual, TAllocator>;
+
+public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using size_type = size_t;
+  template<class K>
+  using key_arg = typename shard_cache_type::template key_arg<K>;
+
+  static_assert(ShardCount > 0 && std::has_single_bit(ShardCount));
+
+  /// Each shard holds `capacity / ShardCount` entries, rounded up.
+  explicit ShardedBoundedCache(
+    size_type capacity,
+    TOnEvict const& on_evict = TOnEvict(),
+    THash const& hash = THash(),
+    TEqual const& equal = TEqual(),
+    TAllocator const& allocator = TAllocator()
+  ) MBASE_NO_THREAD_SAFETY_ANALYSIS :
+    shard_capacity_(std::max<size_t>(1, (capacity + ShardCount - 1) / ShardCount)),
+    hash_(hash)
+  {
+    for (Shard& shard : shards_) {
+      shard.cache.emplace(shard_capacity_, on_evict, hash, equal, allocator);
+    }
+  }
+  MBASE_DISALLOW_COPY_MOVE(ShardedBoundedCache);
+
+  [[nodiscard]] size_type capacity() const noexcept {
+    return shard_capacity_ * ShardCount;
+  }
+  /// Sum of the shard sizes, each read under its lock; a snapshot under concurrent modification.
+  [[nodiscard]] size_type size() {
+    size_t total = 0;
+    for (Shard& shard : shards_) {
+      LockGuard lock(shard.mutex);
+      total += shard.cache->size();
+    }
+    return total;
+  }
+
+  /// Copy of the value of `key`, marking it as used; `std::nullopt` on a miss.
+  template<class K = key_type>
+  [[nodiscard]] std::optional<TValue> get(key_arg<K> const& key) {
+    uint64_t const hash = hash_(key);
+    Shard& shard = shard_for(hash);
+    LockGuard lock(shard.mutex);
+    TValue const* value = shard.cache->template find_hashed<K>(key, hash);
+    return value != nullptr ? std::optional<TValue>(*value) : std::nullopt;
+  }
+  /// Calls `function(value)` under the shard lock if `key` is present, marking it as used; returns whether it was.
+  template<class K = key_type, class TFunction>
+  bool visit(key_arg<K> const& key, TFunction&& function) {
+    uint64_t const hash = hash_(key);
+    Shard& shard = shard_for(hash);
+    LockGuard lock(shard.mutex);
+    TValue* value = shard.cache->template find_hashed<K>(key, hash);
+    if (value == nullptr) {
+      return false;
+    }
+    function(*value);
+    return true;
+  }
+  /// Copy of the value of `key`, inserting `make_value()` first on a miss. `make_value` runs under the shard lock.
+  template<class K = key_type, class TMakeValue>
+  TValue get_or_insert_with(key_arg<K> const& key, TMakeValue&& make_value) {
+    uint64_t const hash = hash_(key);
+    Shard& shard = shard_for(hash);
+    LockGuard lock(shard.mutex);
+    if (TValue const* value = shard.cache->template find_hashed<K>(key, hash)) {
+      return *value;
+    }
+    return *shard.cache->template try_emplace_hashed<K>(key, hash, make_value()).first;
+  }
+
+  template<class K = key_type, class V>
+  void insert_or_assign(key_arg<K> const& key, V&& value) {
+    uint64_t const hash = hash_(key);
+    Shard& shard = shard_for(hash);
+    LockGuard lock(shard.mutex);
+    shard.cache->template insert_or_assign_hashed<K>(key, hash, std::forward<V>(value));
+  }
+  template<class K = key_type>
+  bool erase(key_arg<K> const& key) {
+    uint64_t const hash = hash_(key);
+    Shard& shard = shard_for(hash);
+    LockGuard lock(shard.mutex);
+    return shard.cache->template erase_hashed<K>(key, hash);
+  }
+  void clear() {
+    for (Shard& shard : shards_) {
+      LockGuard lock(shard.mutex);
+      shard.cache->clear();
+    }
+  }
+
+private:
+  /// Own cache line each, so that locking one shard does not invalidate its neighbours.
+  struct alignas(64) Shard final {
+    Lockable<std::mutex> mutex;
+    /// Optional only to be constructed in place after the mutex.
+    std::optional<shard_cache_type> cache MBASE_GUARDED_BY(mutex);
+  };
+
+  /// The top hash bits pick the shard; the shard's table uses the hash multiplied, so both stay well spread.
+  [[nodiscard]] Shard& shard_for(uint64_t hash) noexcept {
+    if constexpr (ShardCount == 1) {
+      return shards_[0];
+    }
+    else {
+      return shards_[size_t(hash >> (64 - std::countr_zero(ShardCount)))];
+    }
+  }
+
+  Shard shards_[ShardCount];
+  size_t shard_capacity_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS detail::KeyHasher<THash, TKey> hash_ {};
+};
+
+} // namespace mbase
@@ -0,0 +1,1000 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/platform.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+#include "mbase/public/algorithm/branchless_lower_bound.h"
+
+// conditional platform headers -------------------------
+#if MBASE_PLATFORM_SSE2
+# include <emmintrin.h>
+#elif MBASE_PLATFORM_NEON
+# include <arm_neon.h>
+#endif
+
+namespace mbase {
+
+namespace detail::btree {
+
+/// `true` if nodes are searched with a branch-free linear scan over all keys instead of a binary search. For the node
+/// sizes used here, comparing every key with SIMD beats the mispredicted branches of a binary search.
+template<class TKey, class TCompare>
+inline constexpr bool kLinearSearch =
+  std::is_arithmetic_v<TKey> && (std::is_same_v<TCompare, std::less<>> || std::is_same_v<TCompare, std::less<TKey>>);
+
+/// Number of `keys` ordered before `key`: `keys[i] < key`, or `!(key < keys[i])` if `OrEqual`.
+/// 32-bit integers and floats are compared four at a time.
+template<bool OrEqual, class TKey>
+[[nodiscard]] inline size_t CountBelow(TKey const* keys, size_t count, TKey key) noexcept {
+  size_t i = 0;
+  size_t result = 0;
+#if MBASE_PLATFORM_SSE2
+  if constexpr (std::is_same_v<TKey, int32_t>) {
+    __m128i const probe = _mm_set1_epi32(key);
+    for (; i + 4 <= count; i += 4) {
+      __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i));
+      int const mask = OrEqual
+        ? ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, probe))) & 0xF
+        : _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, probe)));
+      result += size_t(std::popcount(unsigned(mask)));
+    }
+  }
+  else if constexpr (std::is_same_v<TKey, float>) {
+    __m128 const probe = _mm_set1_ps(key);
+    for (; i + 4 <= count; i += 4) {
+      __m128 const v = _mm_loadu_ps(keys + i);
+      int const mask = _mm_movemask_ps(OrEqual ? _mm_cmpnlt_ps(probe, v) : _mm_cmplt_ps(v, probe));
+      result += size_t(std::popcount(unsigned(mask)));
+    }
+  }
+#elif MBASE_PLATFORM_NEON
+  if constexpr (std::is_same_v<TKey, int32_t> || std::is_same_v<TKey, float>) {
+    for (; i + 4 <= count; i += 4) {
+      uint32x4_t mask;
+      if constexpr (std::is_same_v<TKey, int32_t>) {
+        int32x4_t const v = vld1q_s32(keys + i);
+        int32x4_t const probe = vdupq_n_s32(key);
+        mask = OrEqual ? vmvnq_u32(vcgtq_s32(v, probe)) : vcltq_s32(v, probe);
+      }
+      else {
+        float32x4_t const v = vld1q_f32(keys + i);
+        float32x4_t const probe = vdupq_n_f32(key);
+        mask = OrEqual ? vmvnq_u32(vcltq_f32(probe, v)) : vcltq_f32(v, probe);
+      }
+      // Narrow each lane to 16 bits and count the set bits of the resulting 64-bit word.
+      uint64_t const bits = vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(mask)), 0);
+      result += size_t(std::popcount(bits)) / 16;
+    }
+  }
+#endif
+  // Also the whole loop for other arithmetic types, which compilers vectorize on their own.
+  for (; i != count; ++i) {
+    result += OrEqual ? !(key < keys[i]) : (keys[i] < key);
+  }
+  return result;
+}
+
+/// Uninitialized storage for `N` objects of type `T`.
+template<class T, size_t N>
+struct SlotArray final {
+  T* data() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+  T const* data() const noexcept { return std::launder(reinterpret_cast<T const*>(bytes)); }
+
+  alignas(T) std::byte bytes[sizeof(T) * N];
+};
+
+struct NoValue final {};
+
+} // namespace detail::btree
+
+namespace detail {
+
+/// B+tree shared by `BTreeMap` (`TValue` is the mapped type) and `BTreeSet` (`TValue` is `void`).
+/// All elements live in leaves, which are linked for iteration; internal nodes only hold separator keys (copies of
+/// keys) and child pointers. Nodes are sized to about `NodeBytes` and aligned to cache lines.
+template<class TKey, class TValue, class TCompare, class TAllocator, size_t NodeBytes>
+class BTree {
+  static_assert(std::is_nothrow_move_constructible_v<TKey> && std::is_nothrow_move_assignable_v<TKey>);
+  static_assert(std::is_copy_constructible_v<TKey>, "Separator keys are copies.");
+  static_assert(NodeBytes >= 128);
+
+protected:
+  static constexpr bool kIsMap = !std::is_void_v<TValue>;
+  using Mapped = std::conditional_t<kIsMap, TValue, btree::NoValue>;
+  static_assert(!kIsMap || std::is_nothrow_move_constructible_v<Mapped>);
+
+private:
+  static constexpr size_t kMappedSize = kIsMap ? sizeof(Mapped) : 0;
+  static constexpr size_t kLeafSlots =
+    std::max<size_t>(4, (NodeBytes - 3 * sizeof(void*)) / (sizeof(TKey) + kMappedSize));
+  static constexpr size_t kInternalSlots =
+    std::max<size_t>(4, (NodeBytes - 2 * sizeof(void*)) / (sizeof(TKey) + sizeof(void*)));
+  static constexpr size_t kMinLeafCount = kLeafSlots / 2;
+  static constexpr size_t kMinInternalCount = kInternalSlots / 2;
+  static constexpr size_t kNodeAlignment = std::max({ size_t(64), alignof(TKey), alignof(Mapped) });
+  /// Enough for 2^64 elements with the minimum fanout of 3.
+  static constexpr size_t kMaxHeight = 48;
+
+  static_assert(kLeafSlots <= UINT16_MAX && kInternalSlots <= UINT16_MAX);
+
+  struct Node {
+    uint16_t count = 0;
+    bool is_leaf = false;
+  };
+
+  struct Leaf final : Node {
+    TKey* keys() noexcept { return key_slots.data(); }
+    Mapped* values() noexcept {
+      if constexpr (kIsMap) { return value_slots.data(); }
+      else { return nullptr; }
+    }
+
+    Leaf* prev = nullptr;
+    Leaf* next = nullptr;
+    btree::SlotArray<TKey, kLeafSlots> key_slots;
+    MBASE_NO_UNIQUE_ADDRESS std::conditional_t<kIsMap, btree::SlotArray<Mapped, kLeafSlots>, btree::NoValue> value_slots;
+  };
+
+  struct Internal final : Node {
+    TKey* keys() noexcept { return key_slots.data(); }
+
+    btree::SlotArray<TKey, kInternalSlots> key_slots;
+    Node* children[kInternalSlots + 1];
+  };
+
+  /// Internal nodes visited on the way to a leaf, and the child taken in each.
+  struct Path final {
+    struct Entry final {
+      Internal* node;
+      size_t index;
+    };
+
+    Entry entries[kMaxHeight];
+    size_t depth = 0;
+  };
+
+public:
+  using key_type = TKey;
+  using value_type = std::conditional_t<kIsMap, std::pair<TKey, Mapped>, TKey>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using key_compare = TCompare;
+  using allocator_type = TAllocator;
+
+  template<class K>
+  using key_arg = typename detail::KeyArg<is_transparent_v<TCompare>>::template type<K, key_type>;
+
+  /// Bidirectional iterator walking the linked leaves.
+  /// Map iterators dereference to `std::pair<key_type const&, mapped_type&>` proxies; set iterators to `key_type const&`.
+  template<bool IsConst>
+  class Iterator final {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = BTree::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<
+      kIsMap,
+      std::pair<TKey const&, std::conditional_t<IsConst, Mapped const&, Mapped&>>,
+      TKey const&
+    >;
+
+    struct ArrowProxy final {
+      reference ref;
+      std::remove_reference_t<reference> const* operator->() const noexcept { return &ref; }
+    };
+    using pointer = std::conditional_t<kIsMap, ArrowProxy, TKey const*>;
+
+    Iterator() = default;
+    // Iterator -> ConstIterator
+    template<bool C = IsConst, std::enable_if_t<C, int> = 0>
+    Iterator(Iterator<false> const& rhs) noexcept : leaf_(rhs.leaf_), index_(rhs.index_) {}
+
+    reference operator*() const noexcept {
+      if constexpr (kIsMap) {
+        return { leaf_->keys()[index_], leaf_->values()[index_] };
+      }
+      else {
+        return leaf_->keys()[index_];
+      }
+    }
+    pointer operator->() const noexcept {
+      if constexpr (kIsMap) {
+        return { **this };
+      }
+      else {
+        return leaf_->keys() + index_;
+      }
+    }
+
+    TKey const& key() const noexcept { return leaf_->keys()[index_]; }
+    template<bool M = kIsMap, std::enable_if_t<M, int> = 0>
+    auto& value() const noexcept {
+      if constexpr (IsConst) { return std::as_const(leaf_->values()[index_]); }
+      else { return leaf_->values()[index_]; }
+    }
+
+    Iterator& operator++() noexcept {
+      if (++index_ == leaf_->count && leaf_->next != nullptr) {
+        leaf_ = leaf_->next;
+        index_ = 0;
+      }
+      return *this;
+    }
+    Iterator& operator--() noexcept {
+      if (index_ == 0) {
+        leaf_ = leaf_->prev;
+        index_ = leaf_->count;
+      }
+      --index_;
+      return *this;
+    }
+    Iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+    Iterator operator--(int) noexcept { auto tmp = *this; --*this; return tmp; }
+
+    friend bool operator==(Iterator const& lhs, Iterator const& rhs) noexcept {
+      return lhs.leaf_ == rhs.leaf_ && lhs.index_ == rhs.index_;
+    }
+
+  private:
+    friend class BTree;
+    friend class Iterator<true>;
+
+    Iterator(Leaf* leaf, size_t index) noexcept : leaf_(leaf), index_(index) {}
+
+    Leaf* leaf_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  BTree() = default;
+  explicit BTree(TCompare const& comp, TAllocator const& allocator = TAllocator()) :
+    comp_(comp),
+    allocator_(allocator)
+  {
+  }
+  explicit BTree(TAllocator const& allocator) :
+    allocator_(allocator)
+  {
+  }
+  BTree(BTree const& rhs) :
+    comp_(rhs.comp_),
+    allocator_(rhs.allocator_)
+  {
+    bulk_load(rhs.begin(), rhs.end(), [](auto const& element) -> TKey const& {
+      if constexpr (kIsMap) { return element.first; }
+      else { return element; }
+    }, [](TKey* key, Mapped* value, auto const& element) {
+      if constexpr (kIsMap) {
+        std::construct_at(key, element.first);
+        try {
+          std::construct_at(value, element.second);
+        }
+        catch (...) {
+          std::destroy_at(key);
+          throw;
+        }
+      }
+      else {
+        std::construct_at(key, element);
+      }
+    });
+  }
+  BTree(BTree&& rhs) noexcept :
+    root_(std::exchange(rhs.root_, nullptr)),
+    leftmost_(std::exchange(rhs.leftmost_, nullptr)),
+    rightmost_(std::exchange(rhs.rightmost_, nullptr)),
+    size_(std::exchange(rhs.size_, 0)),
+    comp_(rhs.comp_),
+    allocator_(rhs.allocator_)
+  {
+  }
+  ~BTree() {
+    clear();
+  }
+
+  BTree& operator=(BTree const& rhs) {
+    if (this != &rhs) {
+      BTree tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+  BTree& operator=(BTree&& rhs) noexcept {
+    if (this != &rhs) {
+      BTree tmp(std::move(rhs));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  iterator begin() noexcept { return { leftmost_, 0 }; }
+  const_iterator begin() const noexcept { return iterator(leftmost_, 0); }
+  iterator end() noexcept { return { rightmost_, rightmost_ ? rightmost_->count : size_t(0) }; }
+  const_iterator end() const noexcept { return const_cast<BTree*>(this)->end(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+
+  [[nodiscard]] key_compare key_comp() const { return comp_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  void clear() noexcept {
+    if (root_ != nullptr) {
+      destroy_subtree(root_);
+    }
+    root_ = nullptr;
+    leftmost_ = nullptr;
+    rightmost_ = nullptr;
+    size_ = 0;
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] iterator lower_bound(key_arg<K> const& key) {
+    if (root_ == nullptr) {
+      return end();
+    }
+    Leaf* leaf = descend(key, nullptr);
+    return make_iterator(leaf, lower_index(leaf->keys(), leaf->count, key));
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator lower_bound(key_arg<K> const& key) const {
+    return const_cast<BTree*>(this)->template lower_bound<K>(key);
+  }
+  template<class K = key_type>
+  [[nodiscard]] iterator upper_bound(key_arg<K> const& key) {
+    if (root_ == nullptr) {
+      return end();
+    }
+    Leaf* leaf = descend(key, nullptr);
+    return make_iterator(leaf, upper_index(leaf->keys(), leaf->count, key));
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator upper_bound(key_arg<K> const& key) const {
+    return const_cast<BTree*>(this)->template upper_bound<K>(key);
+  }
+  template<class K = key_type>
+  [[nodiscard]] std::pair<iterator, iterator> equal_range(key_arg<K> const& key) {
+    iterator first = find<K>(key);
+    if (first == end()) {
+      return { first, first };
+    }
+    return { first, std::next(first) };
+  }
+  template<class K = key_type>
+  [[nodiscard]] std::pair<const_iterator, const_iterator> equal_range(key_arg<K> const& key) const {
+    auto [first, last] = const_cast<BTree*>(this)->template equal_range<K>(key);
+    return { first, last };
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] iterator find(key_arg<K> const& key) {
+    if (root_ == nullptr) {
+      return end();
+    }
+    Leaf* leaf = descend(key, nullptr);
+    size_t const index = lower_index(leaf->keys(), leaf->count, key);
+    if (index != leaf->count && !comp_(key, leaf->keys()[index])) {
+      return { leaf, index };
+    }
+    return end();
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator find(key_arg<K> const& key) const {
+    return const_cast<BTree*>(this)->template find<K>(key);
+  }
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    return find<K>(key) != end();
+  }
+  template<class K = key_type>
+  [[nodiscard]] size_type count(key_arg<K> const& key) const {
+    return contains<K>(key) ? 1 : 0;
+  }
+
+  /// Returns the iterator following `position`. Invalidates all other iterators.
+  iterator erase(const_iterator position) {
+    return erase_at(position.leaf_, position.index_);
+  }
+  iterator erase(iterator position) {
+    return erase_at(position.leaf_, position.index_);
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator it(first.leaf_, first.index_);
+    for (auto n = std::distance(first, last); n > 0; --n) {
+      it = erase(it);
+    }
+    return it;
+  }
+  template<class K = key_type>
+  size_type erase(key_arg<K> const& key) {
+    iterator it = find<K>(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  void swap(BTree& rhs) noexcept {
+    std::swap(root_, rhs.root_);
+    std::swap(leftmost_, rhs.leftmost_);
+    std::swap(rightmost_, rhs.rightmost_);
+    std::swap(size_, rhs.size_);
+    std::swap(comp_, rhs.comp_);
+    std::swap(allocator_, rhs.allocator_);
+  }
+
+protected:
+  /// Finds `key`, or inserts an element built by `make_key(TKey*)` and `make_value(Mapped*)` (which must construct an
+  /// equivalent key and the mapped value in place). Strong exception guarantee.
+  template<class K, class TMakeKey, class TMakeValue>
+  std::pair<iterator, bool> find_or_insert(K const& key, TMakeKey&& make_key, TMakeValue&& make_value) {
+    Path path;
+    Leaf* leaf = nullptr;
+    size_t index = 0;
+    if (root_ != nullptr) {
+      leaf = descend(key, &path);
+      index = lower_index(leaf->keys(), leaf->count, key);
+      if (index != leaf->count && !comp_(key, leaf->keys()[index])) {
+        return { iterator(leaf, index), false };
+      }
+    }
+    else {
+      leaf = new_node<Leaf>();
+      root_ = leftmost_ = rightmost_ = leaf;
+    }
+
+    if (leaf->count == kLeafSlots) {
+      Leaf* right = split_leaf(leaf, path);
+      if (index > leaf->count) {
+        index -= leaf->count;
+        leaf = right;
+      }
+    }
+
+    Relocate<TKey>::overlapping(leaf->keys() + index, leaf->keys() + leaf->count, leaf->keys() + index + 1);
+    if constexpr (kIsMap) {
+      Relocate<Mapped>::overlapping(leaf->values() + index, leaf->values() + leaf->count, leaf->values() + index + 1);
+    }
+    try {
+      make_key(leaf->keys() + index);
+      if constexpr (kIsMap) {
+        try {
+          make_value(leaf->values() + index);
+        }
+        catch (...) {
+          std::destroy_at(leaf->keys() + index);
+          throw;
+        }
+      }
+    }
+    catch (...) {
+      Relocate<TKey>::overlapping(leaf->keys() + index + 1, leaf->keys() + leaf->count + 1, leaf->keys() + index);
+      if constexpr (kIsMap) {
+        Relocate<Mapped>::overlapping(leaf->values() + index + 1, leaf->values() + leaf->count + 1, leaf->values() + index);
+      }
+      throw;
+    }
+    ++leaf->count;
+    ++size_;
+    return { iterator(leaf, index), true };
+  }
+
+  /// Builds the tree bottom-up from a key-sorted range, filling leaves completely; the first of repeated keys wins.
+  /// The tree must be empty. `key_of(element)` returns the element's key; `construct(TKey*, Mapped*, element)` builds
+  /// a slot from it.
+  template<class TInputIterator, class TKeyOf, class TConstruct>
+  void bulk_load(TInputIterator first, TInputIterator last, TKeyOf&& key_of, TConstruct&& construct) {
+    MBASE_ASSERT(empty());
+    clear();
+
+    SmallVector<Node*, 32, alignof(Node*), TAllocator> level(allocator_);
+    try {
+      Leaf* leaf = nullptr;
+      for (; first != last; ++first) {
+        decltype(auto) element = *first;
+        TKey const& key = key_of(element);
+        if (leaf != nullptr) {
+          TKey const& last_key = leaf->keys()[leaf->count - 1];
+          MBASE_ASSERT_MSG(!comp_(key, last_key), "BTree::bulk_load input is not sorted!");
+          if (!comp_(last_key, key)) {
+            continue;
+          }
+        }
+        if (leaf == nullptr || leaf->count == kLeafSlots) {
+          Leaf* next = new_node<Leaf>();
+          link_leaf_after(leaf, next);
+          leaf = next;
+          level.push_back(leaf);
+        }
+        construct(leaf->keys() + leaf->count, leaf->values() + leaf->count, element);
+        ++leaf->count;
+        ++size_;
+      }
+    }
+    catch (...) {
+      for (Leaf* leaf = leftmost_; leaf != nullptr; ) {
+        destroy_subtree(std::exchange(leaf, leaf->next));
+      }
+      leftmost_ = rightmost_ = nullptr;
+      size_ = 0;
+      throw;
+    }
+    if (level.empty()) {
+      return;
+    }
+
+    // Top up the last leaf from its (full) predecessor.
+    if (Leaf* leaf = rightmost_; leaf->prev != nullptr && leaf->count < kMinLeafCount) {
+      move_from_left_leaf(leaf->prev, leaf, kMinLeafCount - leaf->count);
+    }
+
+    // Spread each level evenly over as few internal nodes as possible; every node gets at least
+    // `kMinInternalCount + 1` children.
+    SmallVector<Node*, 32, alignof(Node*), TAllocator> parents(allocator_);
+    SmallVector<Internal*, 32, alignof(Internal*), TAllocator> internals(allocator_);
+    try {
+      while (level.size() > 1) {
+        size_t const node_count = (level.size() + kInternalSlots) / (kInternalSlots + 1);
+        size_t const base = level.size() / node_count;
+        size_t const extra = level.size() % node_count;
+        parents.clear();
+        size_t child = 0;
+        for (size_t i = 0; i != node_count; ++i) {
+          internals.reserve(internals.size() + 1);
+          Internal* node = new_node<Internal>();
+          internals.push_back(node);
+          size_t const child_count = base + (i < extra ? 1 : 0);
+          node->children[0] = level[child++];
+          for (size_t j = 1; j != child_count; ++j, ++child) {
+            std::construct_at(node->keys() + node->count, FirstKey(level[child]));
+            node->children[node->count + 1] = level[child];
+            ++node->count;
+          }
+          parents.push_back(node);
+        }
+        std::swap(level, parents);
+      }
+    }
+    catch (...) {
+      for (Internal* node : internals) {
+        std::destroy_n(node->keys(), node->count);
+        delete_node(node);
+      }
+      for (Leaf* leaf = leftmost_; leaf != nullptr; ) {
+        destroy_subtree(std::exchange(leaf, leaf->next));
+      }
+      leftmost_ = rightmost_ = nullptr;
+      size_ = 0;
+      throw;
+    }
+    root_ = level[0];
+  }
+
+private:
+  template<class T>
+  using Relocate = detail::relocate_strategy<T>;
+
+  [[nodiscard]] static TKey const& FirstKey(Node* node) noexcept {
+    while (!node->is_leaf) {
+      node = static_cast<Internal*>(node)->children[0];
+    }
+    return static_cast<Leaf*>(node)->keys()[0];
+  }
+
+  template<class K>
+  [[nodiscard]] size_t lower_index(TKey const* keys, size_t count, K const& key) const {
+    if constexpr (btree::kLinearSearch<TKey, TCompare> && std::is_same_v<K, TKey>) {
+      return btree::CountBelow<false>(keys, count, key);
+    }
+    else {
+      return size_t(branchless_lower_bound(keys, keys + count, key, comp_) - keys);
+    }
+  }
+  template<class K>
+  [[nodiscard]] size_t upper_index(TKey const* keys, size_t count, K const& key) const {
+    if constexpr (btree::kLinearSearch<TKey, TCompare> && std::is_same_v<K, TKey>) {
+      return btree::CountBelow<true>(keys, count, key);
+    }
+    else {
+      return size_t(branchless_upper_bound(keys, keys + count, key, comp_) - keys);
+    }
+  }
+
+  /// Walks down to the leaf whose range holds `key`, optionally recording the path.
+  template<class K>
+  [[nodiscard]] Leaf* descend(K const& key, Path* path) const {
+    Node* node = root_;
+    if (path != nullptr) {
+      path->depth = 0;
+    }
+    while (!node->is_leaf) {
+      Internal* internal = static_cast<Internal*>(node);
+      size_t const index = upper_index(internal->keys(), internal->count, key);
+      if (path != nullptr) {
+        MBASE_ASSERT(path->depth < kMaxHeight);
+        path->entries[path->depth++] = { internal, index };
+      }
+      node = internal->children[index];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  /// Iterator to slot `index` of `leaf`, moved to the next leaf if `index` is one past the end.
+  [[nodiscard]] iterator make_iterator(Leaf* leaf, size_t index) noexcept {
+    if (index == leaf->count && leaf->next != nullptr) {
+      return { leaf->next, 0 };
+    }
+    return { leaf, index };
+  }
+
+  template<class TNode>
+  [[nodiscard]] TNode* new_node() {
+    void* memory = allocator_.allocate(sizeof(TNode), kNodeAlignment);
+    TNode* node = ::new(memory) TNode;
+    node->is_leaf = std::is_same_v<TNode, Leaf>;
+    return node;
+  }
+  template<class TNode>
+  void delete_node(TNode* node) noexcept {
+    node->~TNode();
+    allocator_.deallocate(node, sizeof(TNode), kNodeAlignment);
+  }
+
+  void destroy_subtree(Node* node) noexcept {
+    if (node->is_leaf) {
+      Leaf* leaf = static_cast<Leaf*>(node);
+      std::destroy_n(leaf->keys(), leaf->count);
+      if constexpr (kIsMap) {
+        std::destroy_n(leaf->values(), leaf->count);
+      }
+      delete_node(leaf);
+    }
+    else {
+      Internal* internal = static_cast<Internal*>(node);
+      for (size_t i = 0; i <= internal->count; ++i) {
+        destroy_subtree(internal->children[i]);
+      }
+      std::destroy_n(internal->keys(), internal->count);
+      delete_node(internal);
+    }
+  }
+
+  void link_leaf_after(Leaf* leaf, Leaf* next) noexcept {
+    next->prev = leaf;
+    if (leaf != nullptr) {
+      next->next = leaf->next;
+      leaf->next = next;
+    }
+    else {
+      leftmost_ = next;
+    }
+    (next->next != nullptr ? next->next->prev : rightmost_) = next;
+  }
+  void unlink_leaf(Leaf* leaf) noexcept {
+    (leaf->prev != nullptr ? leaf->prev->next : leftmost_) = leaf->next;
+    (leaf->next != nullptr ? leaf->next->prev : rightmost_) = leaf->prev;
+  }
+
+  /// Moves slots `[first, first + n)` of `src` to `dst + position`, which must be vacant.
+  static void MoveSlots(Leaf* src, size_t first, size_t n, Leaf* dst, size_t position) noexcept {
+    Relocate<TKey>::non_overlapping(src->keys() + first, src->keys() + first + n, dst->keys() + position);
+    if constexpr (kIsMap) {
+      Relocate<Mapped>::non_overlapping(src->values() + first, src->values() + first + n, dst->values() + position);
+    }
+  }
+  /// Moves slots `[first, count)` of `leaf` by `shift` (positive: right, negative: left).
+  static void ShiftSlots(Leaf* leaf, size_t first, std::ptrdiff_t shift) noexcept {
+    Relocate<TKey>::overlapping(leaf->keys() + first, leaf->keys() + leaf->count, leaf->keys() + first + shift);
+    if constexpr (kIsMap) {
+      Relocate<Mapped>::overlapping(leaf->values() + first, leaf->values() + leaf->count, leaf->values() + first + shift);
+    }
+  }
+
+  /// Moves the last `n` slots of `left` to the front of `right`.
+  static void move_from_left_leaf(Leaf* left, Leaf* right, size_t n) noexcept {
+    ShiftSlots(right, 0, std::ptrdiff_t(n));
+    MoveSlots(left, left->count - n, n, right, 0);
+    left->count = uint16_t(left->count - n);
+    right->count = uint16_t(right->count + n);
+  }
+
+  /// Splits a full leaf in two and links the new right half into the tree. Strong exception guarantee: every node and
+  /// the separator key are obtained before anything is modified.
+  Leaf* split_leaf(Leaf* leaf, Path const& path) {
+    // One new internal node per full ancestor, plus a new root if they are all full.
+    size_t internal_count = 0;
+    while (internal_count != path.depth && path.entries[path.depth - 1 - internal_count].node->count == kInternalSlots) {
+      ++internal_count;
+    }
+    if (internal_count == path.depth) {
+      ++internal_count;
+    }
+
+    size_t const keep = leaf->count - leaf->count / 2;
+    Internal* spare[kMaxHeight + 1];
+    size_t spare_count = 0;
+    Leaf* right = nullptr;
+    std::optional<TKey> separator;
+    try {
+      right = new_node<Leaf>();
+      for (; spare_count != internal_count; ++spare_count) {
+        spare[spare_count] = new_node<Internal>();
+      }
+      separator.emplace(leaf->keys()[keep]);
+    }
+    catch (...) {
+      while (spare_count != 0) {
+        delete_node(spare[--spare_count]);
+      }
+      if (right != nullptr) {
+        delete_node(right);
+      }
+      throw;
+    }
+
+    MoveSlots(leaf, keep, leaf->count - keep, right, 0);
+    right->count = uint16_t(leaf->count - keep);
+    leaf->count = uint16_t(keep);
+    link_leaf_after(leaf, right);
+
+    insert_into_parent(path, std::move(*separator), right, spare);
+    return right;
+  }
+
+  /// Inserts `separator` and the new node `right` into the parent of the node at the end of `path`, splitting
+  /// ancestors as needed. `spare` holds preallocated internal nodes.
+  void insert_into_parent(Path const& path, TKey&& separator, Node* right, Internal** spare) noexcept {
+    for (size_t depth = path.depth; ; --depth) {
+      if (depth == 0) {
+        Internal* root = *spare;
+        std::construct_at(root->keys(), std::move(separator));
+        root->children[0] = root_;
+        root->children[1] = right;
+        root->count = 1;
+        root_ = root;
+        return;
+      }
+
+      auto [parent, index] = path.entries[depth - 1];
+      if (parent->count < kInternalSlots) {
+        insert_internal(parent, index, std::move(separator), right);
+        return;
+      }
+
+      // Split the full parent: keys [0, mid) stay, key `mid` goes up, keys (mid, count] move to `sibling`.
+      Internal* sibling = *spare++;
+      size_t const mid = kInternalSlots / 2;
+      TKey up(std::move(parent->keys()[mid]));
+      std::destroy_at(parent->keys() + mid);
+      Relocate<TKey>::non_overlapping(parent->keys() + mid + 1, parent->keys() + parent->count, sibling->keys());
+      std::copy(parent->children + mid + 1, parent->children + parent->count + 1, sibling->children);
+      sibling->count = uint16_t(parent->count - mid - 1);
+      parent->count = uint16_t(mid);
+
+      if (index <= mid) {
+        insert_internal(parent, index, std::move(separator), right);
+      }
+      else {
+        insert_internal(sibling, index - mid - 1, std::move(separator), right);
+      }
+      separator = std::move(up);
+      right = sibling;
+    }
+  }
+
+  /// Inserts `key` at `index` and `child` at `index + 1`.
+  static void insert_internal(Internal* node, size_t index, TKey&& key, Node* child) noexcept {
+    Relocate<TKey>::overlapping(node->keys() + index, node->keys() + node->count, node->keys() + index + 1);
+    std::construct_at(node->keys() + index, std::move(key));
+    std::copy_backward(node->children + index + 1, node->children + node->count + 1, node->children + node->count + 2);
+    node->children[index + 1] = child;
+    ++node->count;
+  }
+  /// Removes key `index` and child `index + 1`.
+  static void remove_internal(Internal* node, size_t index) noexcept {
+    std::destroy_at(node->keys() + index);
+    Relocate<TKey>::overlapping(node->keys() + index + 1, node->keys() + node->count, node->keys() + index);
+    std::copy(node->children + index + 2, node->children + node->count + 1, node->children + index + 1);
+    --node->count;
+  }
+
+  iterator erase_at(Leaf* leaf, size_t index) {
+    MBASE_ASSERT(leaf != nullptr && index < leaf->count);
+
+    Path path;
+    if (leaf != root_) {
+      [[maybe_unused]] Leaf* found = descend(leaf->keys()[index], &path);
+      MBASE_ASSERT(found == leaf);
+    }
+
+    // Borrowing from a sibling replaces a separator with a copy of a key. Make that copy, the only step that can throw,
+    // before changing anything.
+    Internal* parent = nullptr;
+    size_t child_index = 0;
+    Leaf* left = nullptr;
+    Leaf* right = nullptr;
+    std::optional<TKey> separator;
+    if (leaf != root_ && leaf->count - 1u < kMinLeafCount) {
+      parent = path.entries[path.depth - 1].node;
+      child_index = path.entries[path.depth - 1].index;
+      if (child_index > 0) {
+        left = static_cast<Leaf*>(parent->children[child_index - 1]);
+        if (left->count > kMinLeafCount) {
+          separator.emplace(left->keys()[left->count - 1]);
+        }
+      }
+      else {
+        right = static_cast<Leaf*>(parent->children[1]);
+        if (right->count > kMinLeafCount) {
+          separator.emplace(right->keys()[1]);
+        }
+      }
+    }
+
+    std::destroy_at(leaf->keys() + index);
+    if constexpr (kIsMap) {
+      std::destroy_at(leaf->values() + index);
+    }
+    ShiftSlots(leaf, index + 1, -1);
+    --leaf->count;
+    --size_;
+
+    if (leaf == root_) {
+      if (leaf->count == 0) {
+        delete_node(leaf);
+        root_ = leftmost_ = rightmost_ = nullptr;
+        return end();
+      }
+      return make_iterator(leaf, index);
+    }
+    if (parent == nullptr) {
+      return make_iterator(leaf, index);
+    }
+
+    if (separator) {
+      if (left != nullptr) {
+        move_from_left_leaf(left, leaf, 1);
+        parent->keys()[child_index - 1] = std::move(*separator);
+        ++index;
+      }
+      else {
+        MoveSlots(right, 0, 1, leaf, leaf->count);
+        ++leaf->count;
+        ShiftSlots(right, 1, -1);
+        --right->count;
+        parent->keys()[0] = std::move(*separator);
+      }
+      return make_iterator(leaf, index);
+    }
+
+    if (left != nullptr) {
+      // Merge into the left sibling.
+      MoveSlots(leaf, 0, leaf->count, left, left->count);
+      index += left->count;
+      left->count = uint16_t(left->count + leaf->count);
+      leaf->count = 0;
+      unlink_leaf(leaf);
+      delete_node(leaf);
+      remove_internal(parent, child_index - 1);
+      leaf = left;
+    }
+    else {
+      // Merge the right sibling in.
+      MoveSlots(right, 0, right->count, leaf, leaf->count);
+      leaf->count = uint16_t(leaf->count + right->count);
+      right->count = 0;
+      unlink_leaf(right);
+      delete_node(right);
+      remove_internal(parent, 0);
+    }
+    rebalance_internal(path, path.depth - 1);
+    return make_iterator(leaf, index);
+  }
+
+  /// Restores the minimum occupancy of the internal node at `path.entries[depth]` by rotating a key through the parent
+  /// or merging with a sibling, walking up as merges empty ancestors.
+  void rebalance_internal(Path const& path, size_t depth) noexcept {
+    for (;; --depth) {
+      Internal* node = path.entries[depth].node;
+      if (depth == 0) {
+        if (node->count == 0) {
+          root_ = node->children[0];
+          delete_node(node);
+        }
+        return;
+      }
+      if (node->count >= kMinInternalCount) {
+        return;
+      }
+
+      auto [parent, child_index] = path.entries[depth - 1];
+      if (child_index > 0) {
+        Internal* left = static_cast<Internal*>(parent->children[child_index - 1]);
+        TKey& separator = parent->keys()[child_index - 1];
+        if (left->count > kMinInternalCount) {
+          // Rotate right through the parent.
+          Relocate<TKey>::overlapping(node->keys(), node->keys() + node->count, node->keys() + 1);
+          std::copy_backward(node->children, node->children + node->count + 1, node->children + node->count + 2);
+          std::construct_at(node->keys(), std::move(separator));
+          node->children[0] = left->children[left->count];
+          separator = std::move(left->keys()[left->count - 1]);
+          std::destroy_at(left->keys() + left->count - 1);
+          --left->count;
+          ++node->count;
+          return;
+        }
+        // Merge into the left sibling, pulling the separator down.
+        std::construct_at(left->keys() + left->count, std::move(separator));
+        Relocate<TKey>::non_overlapping(node->keys(), node->keys() + node->count, left->keys() + left->count + 1);
+        std::copy(node->children, node->children + node->count + 1, left->children + left->count + 1);
+        left->count = uint16_t(left->count + node->count + 1);
+        node->count = 0;
+        delete_node(node);
+        remove_internal(parent, child_index - 1);
+      }
+      else {
+        Internal* right = static_cast<Internal*>(parent->children[1]);
+        TKey& separator = parent->keys()[0];
+        if (right->count > kMinInternalCount) {
+          // Rotate left through the parent.
+          std::construct_at(node->keys() + node->count, std::move(separator));
+          node->children[node->count + 1] = right->children[0];
+          separator = std::move(right->keys()[0]);
+          std::destroy_at(right->keys());
+          Relocate<TKey>::overlapping(right->keys() + 1, right->keys() + right->count, right->keys());
+          std::copy(right->children + 1, right->children + right->count + 1, right->children);
+          --right->count;
+          ++node->count;
+          return;
+        }
+        // Merge the right sibling in, pulling the separator down.
+        std::construct_at(node->keys() + node->count, std::move(separator));
+        Relocate<TKey>::non_overlapping(right->keys(), right->keys() + right->count, node->keys() + node->count + 1);
+        std::copy(right->children, right->children + right->count + 1, node->children + node->count + 1);
+        node->count = uint16_t(node->count + right->count + 1);
+        right->count = 0;
+        delete_node(right);
+        remove_internal(parent, 0);
+      }
+    }
+  }
+
+  Node* root_ = nullptr;
+  Leaf* leftmost_ = nullptr;
+  Leaf* rightmost_ = nullptr;
+  size_t size_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS TCompare comp_ {};
+  MBASE_NO_UNIQUE_ADDRESS TAllocator allocator_ {};
+};
+
+} // namespace detail
+
+} // namespace mbase
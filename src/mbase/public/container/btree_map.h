@@ -0,0 +1,169 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/memory.h"
+#include "mbase/public/container/btree.h"
+
+namespace mbase {
+
+/// Ordered map backed by a B+tree with cache-line aligned nodes of about `NodeBytes` bytes.
+/// Compared to `std::map`, elements are packed many to a node, so lookups touch a few cache lines and range scans
+/// walk contiguous keys through linked leaves. Arithmetic keys with `std::less` are searched with SIMD comparisons.
+/// - Keys and values must be nothrow move constructible; inserting or erasing moves elements and invalidates
+///   iterators.
+/// - `insert_sorted` into an empty map builds the tree bottom-up in linear time.
+/// - Nodes come from `TAllocator`, e.g. `PmrAllocator` to place them in an arena.
+/// Iterators dereference to `std::pair<key_type const&, mapped_type&>` proxies.
+template<
+  class TKey,
+  class TValue,
+  class TCompare = std::less<>,
+  class TAllocator = AlignedAllocator,
+  size_t NodeBytes = 256
+>
+class BTreeMap final : public detail::BTree<TKey, TValue, TCompare, TAllocator, NodeBytes> {
+  using base_type = detail::BTree<TKey, TValue, TCompare, TAllocator, NodeBytes>;
+
+public:
+  using mapped_type = TValue;
+  using typename base_type::key_type;
+  using typename base_type::value_type;
+  using typename base_type::iterator;
+  using typename base_type::const_iterator;
+  template<class K>
+  using key_arg = typename base_type::template key_arg<K>;
+
+  using base_type::base_type;
+  BTreeMap() = default;
+  template<class TInputIterator>
+  BTreeMap(TInputIterator first, TInputIterator last, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    base_type(comp, allocator)
+  {
+    insert(first, last);
+  }
+  BTreeMap(std::initializer_list<value_type> list, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    base_type(comp, allocator)
+  {
+    insert(list);
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] mapped_type& at(key_arg<K> const& key) {
+    auto it = this->template find<K>(key);
+    if (it == this->end()) {
+      throw std::out_of_range("BTreeMap::at: key not found");
+    }
+    return it.value();
+  }
+  template<class K = key_type>
+  [[nodiscard]] mapped_type const& at(key_arg<K> const& key) const {
+    return const_cast<BTreeMap*>(this)->template at<K>(key);
+  }
+
+  template<class K = key_type>
+  mapped_type& operator[](key_arg<K> const& key) {
+    return try_emplace<K>(key).first.value();
+  }
+  mapped_type& operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first.value();
+  }
+
+  template<class K = key_type, class ... Args>
+  std::pair<iterator, bool> try_emplace(key_arg<K> const& key, Args&& ... args) {
+    return this->find_or_insert(key, [&](TKey* slot) {
+      std::construct_at(slot, key);
+    }, [&](TValue* slot) {
+      std::construct_at(slot, std::forward<Args>(args)...);
+    });
+  }
+  template<class ... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&& ... args) {
+    return this->find_or_insert(key, [&](TKey* slot) {
+      std::construct_at(slot, std::move(key));
+    }, [&](TValue* slot) {
+      std::construct_at(slot, std::forward<Args>(args)...);
+    });
+  }
+
+  template<class K = key_type, class V>
+  std::pair<iterator, bool> insert_or_assign(key_arg<K> const& key, V&& value) {
+    auto result = try_emplace<K>(key, std::forward<V>(value));
+    if (!result.second) {
+      result.first.value() = std::forward<V>(value);
+    }
+    return result;
+  }
+  template<class V>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, V&& value) {
+    auto result = try_emplace(std::move(key), std::forward<V>(value));
+    if (!result.second) {
+      result.first.value() = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return try_emplace(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return try_emplace(std::move(value.first), std::move(value.second));
+  }
+  template<class ... Args>
+  std::pair<iterator, bool> emplace(Args&& ... args) {
+    value_type value(std::forward<Args>(args)...);
+    return insert(std::move(value));
+  }
+
+  template<class TInputIterator>
+  void insert(TInputIterator first, TInputIterator last) {
+    for (; first != last; ++first) {
+      decltype(auto) element = *first;
+      try_emplace(element.first, element.second);
+    }
+  }
+  void insert(std::initializer_list<value_type> list) {
+    insert(list.begin(), list.end());
+  }
+
+  /// Inserts a key-sorted range of pair-likes; the first of repeated keys wins.
+  /// An empty map is built bottom-up with full nodes, in linear time.
+  template<class TInputIterator>
+  void insert_sorted(TInputIterator first, TInputIterator last) {
+    if (!this->empty()) {
+      insert(first, last);
+      return;
+    }
+    this->bulk_load(first, last, [](auto const& element) -> decltype(auto) {
+      return (element.first);
+    }, [](TKey* key, TValue* value, auto&& element) {
+      std::construct_at(key, element.first);
+      try {
+        std::construct_at(value, element.second);
+      }
+      catch (...) {
+        std::destroy_at(key);
+        throw;
+      }
+    });
+  }
+};
+
+template<class TKey, class TValue, class TCompare, class A1, class A2, size_t N1, size_t N2>
+bool operator==(BTreeMap<TKey, TValue, TCompare, A1, N1> const& lhs, BTreeMap<TKey, TValue, TCompare, A2, N2> const& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](auto const& a, auto const& b) {
+    return a.first == b.first && a.second == b.second;
+  });
+}
+
+} // namespace mbase
@@ -0,0 +1,95 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/memory.h"
+#include "mbase/public/container/btree.h"
+
+namespace mbase {
+
+/// Ordered set backed by a B+tree with cache-line aligned nodes of about `NodeBytes` bytes.
+/// See `BTreeMap`: keys must be nothrow move constructible, insertions and erasures invalidate iterators, and
+/// `insert_sorted` into an empty set builds the tree in linear time.
+template<
+  class TKey,
+  class TCompare = std::less<>,
+  class TAllocator = AlignedAllocator,
+  size_t NodeBytes = 256
+>
+class BTreeSet final : public detail::BTree<TKey, void, TCompare, TAllocator, NodeBytes> {
+  using base_type = detail::BTree<TKey, void, TCompare, TAllocator, NodeBytes>;
+
+public:
+  using typename base_type::key_type;
+  using typename base_type::value_type;
+  using typename base_type::iterator;
+  using typename base_type::const_iterator;
+
+  using base_type::base_type;
+  BTreeSet() = default;
+  template<class TInputIterator>
+  BTreeSet(TInputIterator first, TInputIterator last, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    base_type(comp, allocator)
+  {
+    insert(first, last);
+  }
+  BTreeSet(std::initializer_list<value_type> list, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    base_type(comp, allocator)
+  {
+    insert(list);
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return this->find_or_insert(value, [&](TKey* slot) {
+      std::construct_at(slot, value);
+    }, [](auto*) {});
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return this->find_or_insert(value, [&](TKey* slot) {
+      std::construct_at(slot, std::move(value));
+    }, [](auto*) {});
+  }
+  template<class ... Args>
+  std::pair<iterator, bool> emplace(Args&& ... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+  }
+
+  template<class TInputIterator>
+  void insert(TInputIterator first, TInputIterator last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+  void insert(std::initializer_list<value_type> list) {
+    insert(list.begin(), list.end());
+  }
+
+  /// Inserts a sorted range; an empty set is built bottom-up with full nodes, in linear time.
+  template<class TInputIterator>
+  void insert_sorted(TInputIterator first, TInputIterator last) {
+    if (!this->empty()) {
+      insert(first, last);
+      return;
+    }
+    this->bulk_load(first, last, [](auto const& element) -> auto const& {
+      return element;
+    }, [](TKey* key, auto*, auto&& element) {
+      std::construct_at(key, element);
+    });
+  }
+};
+
+template<class TKey, class TCompare, class A1, class A2, size_t N1, size_t N2>
+bool operator==(BTreeSet<TKey, TCompare, A1, N1> const& lhs, BTreeSet<TKey, TCompare, A2, N2> const& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+} // namespace mbase
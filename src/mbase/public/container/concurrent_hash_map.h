@@ -0,0 +1,245 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <optional>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/access.h"
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/tsa.h"
+#include "mbase/public/type_util.h"
+#include "mbase/public/container/flat_hash_map.h"
+
+namespace mbase {
+
+/// Hash map for lookup tables shared between threads: `ShardCount` `FlatHashMap`s, each behind its own
+/// `SharedLockable<std::shared_mutex>`, picked by the top bits of the key hash. Lookups take their shard's lock
+/// shared, so concurrent readers never block each other; writers block only the readers and writers of one shard.
+/// Elements are never handed out by reference: lookups return copies or run a function under the shard lock.
+/// Such functions must not call back into the map.
+template<
+  class TKey,
+  class TValue,
+  size_t ShardCount = 16,
+  class THash = Hash64,
+  class TEqual = std::equal_to<>,
+  class TAllocator = AlignedAllocator
+>
+class ConcurrentHashMap final {
+  using shard_map_type = FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>;
+
+public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using size_type = size_t;
+  using hasher = THash;
+  using key_equal = TEqual;
+  using allocator_type = TAllocator;
+  template<class K>
+  using key_arg = typename shard_map_type::template key_arg<K>;
+
+  static_assert(ShardCount > 0 && std::has_single_bit(ShardCount));
+
+  ConcurrentHashMap() = default;
+  /// Reserves room for `count` elements spread evenly over the shards.
+  explicit ConcurrentHashMap(
+    size_type count,
+    THash const& hash = THash(),
+    TEqual const& equal = TEqual(),
+    TAllocator const& allocator = TAllocator()
+  ) MBASE_NO_THREAD_SAFETY_ANALYSIS :
+    hash_(hash)
+  {
+    for (Shard& shard : shards_) {
+      shard.map = shard_map_type((count + ShardCount - 1) / ShardCount, hash, equal, allocator);
+    }
+  }
+  MBASE_DISALLOW_COPY_MOVE(ConcurrentHashMap);
+
+  [[nodiscard]] hasher hash_function() const { return hash_.get(); }
+
+  /// Sum of the shard sizes, each read under its lock; a snapshot under concurrent modification.
+  [[nodiscard]] size_type size() const {
+    size_t total = 0;
+    for (Shard const& shard : shards_) {
+      SharedLockGuard lock(shard.mutex);
+      total += shard.map.size();
+    }
+    return total;
+  }
+  [[nodiscard]] bool empty() const {
+    return size() == 0;
+  }
+
+  /// Copy of the value of `key`; `std::nullopt` if absent.
+  template<class K = key_type>
+  [[nodiscard]] std::optional<TValue> find(key_arg<K> const& key) const {
+    Shard const& shard = shard_for(hash_(key));
+    SharedLockGuard lock(shard.mutex);
+    auto it = shard.map.template find<K>(key);
+    return it != shard.map.end() ? std::optional<TValue>(it->second) : std::nullopt;
+  }
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    Shard const& shard = shard_for(hash_(key));
+    SharedLockGuard lock(shard.mutex);
+    return shard.map.template contains<K>(key);
+  }
+  /// Calls `function(value)` under the shared shard lock if `key` is present; returns whether it was.
+  template<class K = key_type, class TFunction>
+  bool visit(key_arg<K> const& key, TFunction&& function) const {
+    Shard const& shard = shard_for(hash_(key));
+    SharedLockGuard lock(shard.mutex);
+    auto it = shard.map.template find<K>(key);
+    if (it == shard.map.end()) {
+      return false;
+    }
+    function(std::as_const(it->second));
+    return true;
+  }
+
+  /// Copy of the value of `key`, inserting `make_value()` first if absent; `second` is whether it was inserted.
+  /// Hits only take the shard lock shared. On a miss `make_value` runs under the exclusive shard lock, so exactly one
+  /// of several racing callers inserts.
+  template<class K = key_type, class TMakeValue>
+  std::pair<TValue, bool> find_or_insert(key_arg<K> const& key, TMakeValue&& make_value) {
+    Shard& shard = shard_for(hash_(key));
+    {
+      SharedLockGuard lock(shard.mutex);
+      auto it = shard.map.template find<K>(key);
+      if (it != shard.map.end()) {
+        return { it->second, false };
+      }
+    }
+    LockGuard lock(shard.mutex);
+    // Another thread may have inserted `key` since the shared lookup.
+    auto it = shard.map.template find<K>(key);
+    if (it != shard.map.end()) {
+      return { it->second, false };
+    }
+    return { shard.map.template try_emplace<K>(key, make_value()).first->second, true };
+  }
+  /// Inserts `key` with a value constructed from `args` unless present; returns whether it was inserted.
+  template<class K = key_type, class ... Args>
+  bool try_emplace(key_arg<K> const& key, Args&& ... args) {
+    Shard& shard = shard_for(hash_(key));
+    LockGuard lock(shard.mutex);
+    return shard.map.template try_emplace<K>(key, std::forward<Args>(args)...).second;
+  }
+  /// Returns `true` if `key` was inserted, `false` if its value was assigned.
+  template<class K = key_type, class V>
+  bool insert_or_assign(key_arg<K> const& key, V&& value) {
+    Shard& shard = shard_for(hash_(key));
+    LockGuard lock(shard.mutex);
+    return shard.map.template insert_or_assign<K>(key, std::forward<V>(value)).second;
+  }
+
+  /// Calls `function(value)` under the exclusive shard lock if `key` is present, so that read-modify-write updates
+  /// are atomic; returns whether it was.
+  template<class K = key_type, class TFunction>
+  bool update(key_arg<K> const& key, TFunction&& function) {
+    Shard& shard = shard_for(hash_(key));
+    LockGuard lock(shard.mutex);
+    auto it = shard.map.template find<K>(key);
+    if (it == shard.map.end()) {
+      return false;
+    }
+    function(it->second);
+    return true;
+  }
+  /// `update`, inserting `make_value()` first if absent; returns whether it was inserted.
+  template<class K = key_type, class TMakeValue, class TFunction>
+  bool update_or_insert(key_arg<K> const& key, TMakeValue&& make_value, TFunction&& function) {
+    Shard& shard = shard_for(hash_(key));
+    LockGuard lock(shard.mutex);
+    auto it = shard.map.template find<K>(key);
+    if (it != shard.map.end()) {
+      function(it->second);
+      return false;
+    }
+    shard.map.template try_emplace<K>(key, make_value());
+    return true;
+  }
+
+  /// Returns `false` if `key` was not present.
+  template<class K = key_type>
+  bool erase(key_arg<K> const& key) {
+    Shard& shard = shard_for(hash_(key));
+    LockGuard lock(shard.mutex);
+    return shard.map.template erase<K>(key) != 0;
+  }
+  /// Erases the elements for which `predicate(key, value)` holds, one shard at a time; returns the number erased.
+  template<class TPredicate>
+  size_type erase_if(TPredicate&& predicate) {
+    size_t erased = 0;
+    for (Shard& shard : shards_) {
+      LockGuard lock(shard.mutex);
+      for (auto it = shard.map.begin(); it != shard.map.end();) {
+        if (predicate(std::as_const(it->first), it->second)) {
+          it = shard.map.erase(it);
+          ++erased;
+        }
+        else {
+          ++it;
+        }
+      }
+    }
+    return erased;
+  }
+  void clear() {
+    for (Shard& shard : shards_) {
+      LockGuard lock(shard.mutex);
+      shard.map.clear();
+    }
+  }
+
+  /// Calls `function(key, value)` for every element, one shard at a time under its shared lock. Not a snapshot:
+  /// shards visited later may already reflect writes made after earlier ones were visited.
+  template<class TFunction>
+  void for_each(TFunction&& function) const {
+    for (Shard const& shard : shards_) {
+      SharedLockGuard lock(shard.mutex);
+      for (auto const& [key, value] : shard.map) {
+        function(key, value);
+      }
+    }
+  }
+
+private:
+  /// Own cache line each, so that locking one shard does not invalidate its neighbours.
+  struct alignas(64) Shard final {
+    mutable SharedLockable<std::shared_mutex> mutex;
+    shard_map_type map MBASE_GUARDED_BY(mutex);
+  };
+
+  /// The top hash bits pick the shard; `FlatHashMap` probes with the low bits, so both stay well spread.
+  [[nodiscard]] static size_t ShardIndex(uint64_t hash) noexcept {
+    if constexpr (ShardCount == 1) {
+      return 0;
+    }
+    else {
+      return size_t(hash >> (64 - std::countr_zero(ShardCount)));
+    }
+  }
+  [[nodiscard]] Shard& shard_for(uint64_t hash) noexcept {
+    return shards_[ShardIndex(hash)];
+  }
+  [[nodiscard]] Shard const& shard_for(uint64_t hash) const noexcept {
+    return shards_[ShardIndex(hash)];
+  }
+
+  Shard shards_[ShardCount];
+  MBASE_NO_UNIQUE_ADDRESS detail::KeyHasher<THash, TKey> hash_ {};
+};
+
+} // namespace mbase
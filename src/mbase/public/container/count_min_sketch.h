@@ -0,0 +1,169 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+/// Count-min sketch: `depth` rows of `width` saturating counters; a key's count is estimated as the minimum of its
+/// counter in each row, which never underestimates. With `width = WidthFor(epsilon)` and `depth = DepthFor(delta)` the
+/// overestimate exceeds `epsilon * total_count()` with probability at most `delta`.
+/// `add` uses conservative update (only counters below the new estimate are raised), which leaves every estimate an
+/// upper bound but makes overestimates much smaller on skewed streams.
+/// Sketches with the same shape and hasher merge by summing counters, e.g. per-thread sketches into one.
+/// `THash` maps keys to 64-bit hashes (`Hash64`, i.e. `Hasher64`, by default). Const member functions may be called
+/// concurrently.
+template<class THash = Hash64, class TCounter = uint32_t, class TAllocator = AlignedAllocator>
+class CountMinSketch final {
+  static_assert(std::is_unsigned_v<TCounter>);
+
+public:
+  using hasher = THash;
+  using counter_type = TCounter;
+  using allocator_type = TAllocator;
+
+  static constexpr size_t kMaxDepth = 16;
+
+  CountMinSketch() = default;
+  CountMinSketch(size_t width, size_t depth, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) :
+    width_(width),
+    depth_(depth),
+    counters_(CheckedCounterCount(width, depth), TCounter(0), allocator),
+    hash_(hash)
+  {
+  }
+  /// Restores a sketch from `counters()` and `total_count()` of one with the same shape and hasher.
+  CountMinSketch(size_t width, size_t depth, ArrayProxy<TCounter const> counters, uint64_t total_count, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) :
+    width_(width),
+    depth_(depth),
+    counters_(counters.begin(), counters.end(), allocator),
+    total_count_(total_count),
+    hash_(hash)
+  {
+    if (counters.size() != CheckedCounterCount(width, depth)) {
+      throw std::length_error("CountMinSketch counter count does not match its shape!");
+    }
+  }
+
+  [[nodiscard]] size_t width() const noexcept { return width_; }
+  [[nodiscard]] size_t depth() const noexcept { return depth_; }
+  /// Sum of all counts added, saturated at the maximum of `uint64_t`.
+  [[nodiscard]] uint64_t total_count() const noexcept { return total_count_; }
+  [[nodiscard]] hasher hash_function() const { return hash_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return counters_.get_allocator(); }
+  /// Row-major counters, for serialization. Counters are in host byte order.
+  [[nodiscard]] ArrayProxy<TCounter const> counters() const noexcept { return { counters_.data(), counters_.size() }; }
+
+  template<class K>
+  void add(K const& key, TCounter count = 1) {
+    add_hash(hash_(key), count);
+  }
+  template<class K>
+  [[nodiscard]] TCounter estimate(K const& key) const {
+    return estimate_hash(hash_(key));
+  }
+
+  void add_hash(uint64_t hash, TCounter count = 1) noexcept {
+    if (counters_.empty()) {
+      return;
+    }
+    size_t columns[kMaxDepth];
+    TCounter current = std::numeric_limits<TCounter>::max();
+    for (size_t row = 0; row != depth_; ++row) {
+      columns[row] = row * width_ + Column(hash, row);
+      current = std::min(current, counters_[columns[row]]);
+    }
+    TCounter const target = SaturatingAdd(current, count);
+    for (size_t row = 0; row != depth_; ++row) {
+      counters_[columns[row]] = std::max(counters_[columns[row]], target);
+    }
+    total_count_ = SaturatingAdd(total_count_, uint64_t(count));
+  }
+  [[nodiscard]] TCounter estimate_hash(uint64_t hash) const noexcept {
+    if (counters_.empty()) {
+      return 0;
+    }
+    TCounter result = std::numeric_limits<TCounter>::max();
+    for (size_t row = 0; row != depth_; ++row) {
+      result = std::min(result, counters_[row * width_ + Column(hash, row)]);
+    }
+    return result;
+  }
+
+  /// Adds every count of `rhs`, which must have the same shape and hasher.
+  void merge(CountMinSketch const& rhs) {
+    MBASE_ASSERT_MSG(width_ == rhs.width_ && depth_ == rhs.depth_, "CountMinSketch shapes differ!");
+    for (size_t i = 0; i != counters_.size(); ++i) {
+      counters_[i] = SaturatingAdd(counters_[i], rhs.counters_[i]);
+    }
+    total_count_ = SaturatingAdd(total_count_, rhs.total_count_);
+  }
+
+  void clear() noexcept {
+    std::fill(counters_.begin(), counters_.end(), TCounter(0));
+    total_count_ = 0;
+  }
+
+  void swap(CountMinSketch& rhs) noexcept {
+    std::swap(width_, rhs.width_);
+    std::swap(depth_, rhs.depth_);
+    std::swap(counters_, rhs.counters_);
+    std::swap(total_count_, rhs.total_count_);
+    std::swap(hash_, rhs.hash_);
+  }
+
+  /// Width bounding the overestimate by `epsilon * total_count()`.
+  [[nodiscard]] static size_t WidthFor(double epsilon) {
+    MBASE_ASSERT_MSG(epsilon > 0.0 && epsilon < 1.0, "CountMinSketch epsilon must be in (0, 1)!");
+    return size_t(std::ceil(std::numbers::e / epsilon));
+  }
+  /// Depth bounding the probability of exceeding that overestimate by `delta`.
+  [[nodiscard]] static size_t DepthFor(double delta) {
+    MBASE_ASSERT_MSG(delta > 0.0 && delta < 1.0, "CountMinSketch delta must be in (0, 1)!");
+    return std::clamp<size_t>(size_t(std::ceil(std::log(1.0 / delta))), 1, kMaxDepth);
+  }
+
+private:
+  [[nodiscard]] static size_t CheckedCounterCount(size_t width, size_t depth) {
+    if (width == 0 || width > UINT32_MAX || depth == 0 || depth > kMaxDepth) {
+      throw std::out_of_range("CountMinSketch shape out of range!");
+    }
+    return width * depth;
+  }
+
+  template<class T>
+  [[nodiscard]] static T SaturatingAdd(T lhs, T rhs) noexcept {
+    return lhs > std::numeric_limits<T>::max() - rhs ? std::numeric_limits<T>::max() : T(lhs + rhs);
+  }
+
+  /// Row hashes by double hashing (Kirsch and Mitzenmacher), scaled onto the width.
+  [[nodiscard]] size_t Column(uint64_t hash, size_t row) const noexcept {
+    uint32_t const row_hash = uint32_t(hash) + uint32_t(row) * (uint32_t(hash >> 32) | 1);
+    return size_t(uint64_t(row_hash) * uint64_t(width_) >> 32);
+  }
+
+  size_t width_ = 0;
+  size_t depth_ = 0;
+  SmallVector<TCounter, 1, alignof(TCounter), TAllocator> counters_;
+  uint64_t total_count_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS THash hash_ {};
+};
+
+} // namespace mbase
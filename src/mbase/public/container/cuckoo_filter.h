@@ -0,0 +1,283 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/call.h"
+#include "mbase/public/container.h"
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+/// Cuckoo filter: approximate membership with deletion. Each key is stored as a `TFingerprint` in one of two buckets
+/// of 4 slots; the second bucket is derived from the first and the fingerprint alone, so fingerprints can be moved
+/// between them without the key.
+/// - No false negatives for inserted and not erased keys. Erase only keys that were inserted: erasing another key
+///   sharing a fingerprint and bucket removes that key instead.
+/// - A key inserted `n` times must be erased `n` times; at most 8 copies fit.
+/// - `insert` fails, leaving the filter unchanged, once a bounded number of relocations cannot free a slot; with 16-bit
+///   fingerprints this happens at a load factor of about 0.95.
+/// Keys are hashed as `TKey`, so that equal keys of other types (e.g. integers of another width) find it; with a
+/// transparent `THash`, string-like keys are hashed as they are (see `detail::KeyHasher`).
+/// Const member functions may be called concurrently.
+template<class TKey, class THash = Hash64, class TFingerprint = uint16_t, class TAllocator = AlignedAllocator>
+class CuckooFilter final {
+  static_assert(std::is_unsigned_v<TFingerprint> && sizeof(TFingerprint) <= 4);
+
+public:
+  using key_type = TKey;
+  using hasher = THash;
+  using fingerprint_type = TFingerprint;
+  using allocator_type = TAllocator;
+  using size_type = size_t;
+
+  /// Heterogeneous keys are accepted when `THash` is transparent.
+  template<class K>
+  using key_arg = typename detail::KeyArg<is_transparent_v<THash>>::template type<K, key_type>;
+
+  static constexpr size_t kBucketSize = 4;
+
+  CuckooFilter() = default;
+  /// Sized for `expected_count` keys at a load factor of at most 0.9.
+  explicit CuckooFilter(size_t expected_count, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) :
+    slots_(BucketCountFor(expected_count) * kBucketSize, TFingerprint(0), allocator),
+    hash_(hash)
+  {
+  }
+  /// Restores a filter from `slots()` of one using the same hasher and fingerprint type.
+  explicit CuckooFilter(ArrayProxy<TFingerprint const> slots, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) :
+    slots_(slots.begin(), slots.end(), allocator),
+    size_(size_t(std::count_if(slots.begin(), slots.end(), [](TFingerprint slot) { return slot != 0; }))),
+    hash_(hash)
+  {
+    if (slots.size() % kBucketSize != 0 || !std::has_single_bit(slots.size() / kBucketSize)) {
+      throw std::length_error("CuckooFilter slot count is not a valid bucket count!");
+    }
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] size_type capacity() const noexcept { return slots_.size(); }
+  [[nodiscard]] size_type bucket_count() const noexcept { return slots_.size() / kBucketSize; }
+  [[nodiscard]] double load_factor() const noexcept { return slots_.empty() ? 0.0 : double(size_) / double(slots_.size()); }
+  [[nodiscard]] hasher hash_function() const { return hash_.get(); }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return slots_.get_allocator(); }
+  /// The fingerprint table, for serialization; 0 marks an empty slot. Fingerprints are in host byte order.
+  [[nodiscard]] ArrayProxy<TFingerprint const> slots() const noexcept { return { slots_.data(), slots_.size() }; }
+
+  /// `false` if the filter is too full; it is then unchanged.
+  template<class K = key_type>
+  bool insert(key_arg<K> const& key) {
+    return insert_hash(hash_(key));
+  }
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    return contains_hash(hash_(key));
+  }
+  /// Removes one copy of `key`; `false` if none was found.
+  template<class K = key_type>
+  bool erase(key_arg<K> const& key) {
+    return erase_hash(hash_(key));
+  }
+
+  bool insert_hash(uint64_t hash) {
+    if (slots_.empty()) {
+      return false;
+    }
+    TFingerprint fingerprint = Fingerprint(hash);
+    size_t const first = PrimaryBucket(hash);
+    size_t const second = AlternateBucket(first, fingerprint);
+    if (TryPlace(first, fingerprint) || TryPlace(second, fingerprint)) {
+      ++size_;
+      return true;
+    }
+
+    // Evict a random victim to its alternate bucket, and so on; every swap is recorded so that a failed walk can be
+    // undone.
+    struct Eviction {
+      size_t bucket;
+      size_t slot;
+    };
+    Eviction path[kMaxEvictions];
+    size_t bucket = (NextRandom() & 1) != 0 ? first : second;
+    for (size_t step = 0; step != kMaxEvictions; ++step) {
+      size_t const slot = size_t(NextRandom() % kBucketSize);
+      path[step] = { bucket, slot };
+      std::swap(fingerprint, slots_[bucket * kBucketSize + slot]);
+      bucket = AlternateBucket(bucket, fingerprint);
+      if (TryPlace(bucket, fingerprint)) {
+        ++size_;
+        return true;
+      }
+    }
+    for (size_t step = kMaxEvictions; step-- != 0;) {
+      std::swap(fingerprint, slots_[path[step].bucket * kBucketSize + path[step].slot]);
+    }
+    return false;
+  }
+  [[nodiscard]] bool contains_hash(uint64_t hash) const noexcept {
+    if (slots_.empty()) {
+      return false;
+    }
+    TFingerprint const fingerprint = Fingerprint(hash);
+    size_t const first = PrimaryBucket(hash);
+    return BucketHas(first, fingerprint) || BucketHas(AlternateBucket(first, fingerprint), fingerprint);
+  }
+  bool erase_hash(uint64_t hash) noexcept {
+    if (slots_.empty()) {
+      return false;
+    }
+    TFingerprint const fingerprint = Fingerprint(hash);
+    size_t const first = PrimaryBucket(hash);
+    if (TryRemove(first, fingerprint) || TryRemove(AlternateBucket(first, fingerprint), fingerprint)) {
+      --size_;
+      return true;
+    }
+    return false;
+  }
+
+  /// Hashes a group of keys ahead and prefetches their buckets; returns the number inserted.
+  template<class K = key_type>
+  size_t insert_batch(ArrayProxy<key_arg<K> const> keys) {
+    size_t inserted = 0;
+    for_each_hash_batch(keys, [&](size_t, uint64_t hash) {
+      inserted += insert_hash(hash) ? 1 : 0;
+    });
+    return inserted;
+  }
+  /// `found[i] = contains(keys[i])`.
+  template<class K = key_type>
+  void contains_batch(ArrayProxy<key_arg<K> const> keys, ArrayProxy<bool> found) const {
+    MBASE_ASSERT(keys.size() == found.size());
+    for_each_hash_batch(keys, [&](size_t i, uint64_t hash) {
+      found[i] = contains_hash(hash);
+    });
+  }
+
+  void clear() noexcept {
+    std::fill(slots_.begin(), slots_.end(), TFingerprint(0));
+    size_ = 0;
+  }
+
+  void swap(CuckooFilter& rhs) noexcept {
+    std::swap(slots_, rhs.slots_);
+    std::swap(size_, rhs.size_);
+    std::swap(hash_, rhs.hash_);
+    std::swap(random_state_, rhs.random_state_);
+  }
+
+  /// Expected false positive rate at `load_factor`: a query compares against `2 * kBucketSize * load_factor`
+  /// fingerprints on average.
+  [[nodiscard]] static double FalsePositiveRate(double load_factor) {
+    double const comparisons = 2.0 * double(kBucketSize) * std::clamp(load_factor, 0.0, 1.0);
+    return 1.0 - std::pow(1.0 - 1.0 / double(kFingerprintValues), comparisons);
+  }
+  /// Power-of-two bucket count holding `count` keys at a load factor of at most 0.9.
+  [[nodiscard]] static size_t BucketCountFor(size_t count) {
+    size_t const buckets = std::max<size_t>(1, size_t(std::ceil(double(count) / (double(kBucketSize) * 0.9))));
+    if (buckets > (std::numeric_limits<size_t>::max() >> 1) / kBucketSize) {
+      throw std::length_error("CuckooFilter would exceed the maximum bucket count!");
+    }
+    return std::bit_ceil(buckets);
+  }
+
+private:
+  static constexpr size_t kBatchSize = 16;
+  static constexpr size_t kMaxEvictions = 500;
+  /// Number of non-empty fingerprint values.
+  static constexpr double kFingerprintValues = double(std::numeric_limits<TFingerprint>::max());
+
+  /// High hash bits; 0 marks empty slots and is remapped.
+  [[nodiscard]] static TFingerprint Fingerprint(uint64_t hash) noexcept {
+    auto const fingerprint = TFingerprint(hash >> (64 - sizeof(TFingerprint) * 8));
+    return fingerprint != 0 ? fingerprint : TFingerprint(1);
+  }
+  [[nodiscard]] size_t BucketMask() const noexcept {
+    return bucket_count() - 1;
+  }
+  /// Low hash bits; disjoint from the fingerprint bits as long as the bucket count fits in the remaining bits.
+  [[nodiscard]] size_t PrimaryBucket(uint64_t hash) const noexcept {
+    return size_t(hash) & BucketMask();
+  }
+  /// An involution: the alternate of the alternate bucket is the original one.
+  [[nodiscard]] size_t AlternateBucket(size_t bucket, TFingerprint fingerprint) const noexcept {
+    return (bucket ^ size_t(uint64_t(fingerprint) * 0xc6a4a7935bd1e995)) & BucketMask();
+  }
+
+  [[nodiscard]] bool BucketHas(size_t bucket, TFingerprint fingerprint) const noexcept {
+    TFingerprint const* slots = slots_.data() + bucket * kBucketSize;
+    bool found = false;
+    for (size_t i = 0; i != kBucketSize; ++i) {
+      found |= slots[i] == fingerprint;
+    }
+    return found;
+  }
+  bool TryPlace(size_t bucket, TFingerprint fingerprint) noexcept {
+    TFingerprint* slots = slots_.data() + bucket * kBucketSize;
+    for (size_t i = 0; i != kBucketSize; ++i) {
+      if (slots[i] == 0) {
+        slots[i] = fingerprint;
+        return true;
+      }
+    }
+    return false;
+  }
+  bool TryRemove(size_t bucket, TFingerprint fingerprint) noexcept {
+    TFingerprint* slots = slots_.data() + bucket * kBucketSize;
+    for (size_t i = 0; i != kBucketSize; ++i) {
+      if (slots[i] == fingerprint) {
+        slots[i] = 0;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// xorshift64; only steers the eviction walk.
+  uint64_t NextRandom() noexcept {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 7;
+    random_state_ ^= random_state_ << 17;
+    return random_state_;
+  }
+
+  template<class K, class TFunction>
+  void for_each_hash_batch(ArrayProxy<K const> keys, TFunction&& function) const {
+    uint64_t hashes[kBatchSize];
+    for (size_t first = 0; first < keys.size(); first += kBatchSize) {
+      size_t const count = std::min(kBatchSize, keys.size() - first);
+      for (size_t j = 0; j != count; ++j) {
+        hashes[j] = hash_(keys[first + j]);
+        if (!slots_.empty()) {
+          size_t const bucket = PrimaryBucket(hashes[j]);
+          MBASE_PREFETCH(slots_.data() + bucket * kBucketSize);
+          MBASE_PREFETCH(slots_.data() + AlternateBucket(bucket, Fingerprint(hashes[j])) * kBucketSize);
+        }
+      }
+      for (size_t j = 0; j != count; ++j) {
+        function(first + j, hashes[j]);
+      }
+    }
+  }
+
+  SmallVector<TFingerprint, kBucketSize, kBucketSize * sizeof(TFingerprint), TAllocator> slots_;
+  size_t size_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS detail::KeyHasher<THash, TKey> hash_ {};
+  uint64_t random_state_ = 0x9e3779b97f4a7c15;
+};
+
+} // namespace mbase
@@ -0,0 +1,382 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+// public project headers -------------------------------
+#include "mbase/public/platform.h"
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+
+// conditional platform headers -------------------------
+#if MBASE_PLATFORM_SSE2
+# include <emmintrin.h>
+#elif MBASE_PLATFORM_NEON
+# include <arm_neon.h>
+#endif
+
+namespace mbase {
+
+namespace detail::bitset {
+
+enum class WordOp {
+  kAnd,
+  kOr,
+  kXor,
+  kAndNot, // lhs & ~rhs
+};
+
+template<WordOp Op>
+[[nodiscard]] constexpr uint64_t ApplyWord(uint64_t lhs, uint64_t rhs) noexcept {
+  if constexpr (Op == WordOp::kAnd) { return lhs & rhs; }
+  else if constexpr (Op == WordOp::kOr) { return lhs | rhs; }
+  else if constexpr (Op == WordOp::kXor) { return lhs ^ rhs; }
+  else { return lhs & ~rhs; }
+}
+
+#if MBASE_PLATFORM_SSE2
+template<WordOp Op>
+[[nodiscard]] inline __m128i ApplyVector(__m128i lhs, __m128i rhs) noexcept {
+  if constexpr (Op == WordOp::kAnd) { return _mm_and_si128(lhs, rhs); }
+  else if constexpr (Op == WordOp::kOr) { return _mm_or_si128(lhs, rhs); }
+  else if constexpr (Op == WordOp::kXor) { return _mm_xor_si128(lhs, rhs); }
+  else { return _mm_andnot_si128(rhs, lhs); }
+}
+#elif MBASE_PLATFORM_NEON
+template<WordOp Op>
+[[nodiscard]] inline uint64x2_t ApplyVector(uint64x2_t lhs, uint64x2_t rhs) noexcept {
+  if constexpr (Op == WordOp::kAnd) { return vandq_u64(lhs, rhs); }
+  else if constexpr (Op == WordOp::kOr) { return vorrq_u64(lhs, rhs); }
+  else if constexpr (Op == WordOp::kXor) { return veorq_u64(lhs, rhs); }
+  else { return vbicq_u64(lhs, rhs); }
+}
+#endif
+
+/// `dst[i] = dst[i] Op src[i]` for `count` words, four words per iteration on SSE2/NEON.
+template<WordOp Op>
+inline void ApplyWords(uint64_t* dst, uint64_t const* src, size_t count) noexcept {
+  size_t i = 0;
+#if MBASE_PLATFORM_SSE2
+  for (; i + 4 <= count; i += 4) {
+    auto d = reinterpret_cast<__m128i*>(dst + i);
+    auto s = reinterpret_cast<__m128i const*>(src + i);
+    __m128i const r0 = ApplyVector<Op>(_mm_loadu_si128(d), _mm_loadu_si128(s));
+    __m128i const r1 = ApplyVector<Op>(_mm_loadu_si128(d + 1), _mm_loadu_si128(s + 1));
+    _mm_storeu_si128(d, r0);
+    _mm_storeu_si128(d + 1, r1);
+  }
+#elif MBASE_PLATFORM_NEON
+  for (; i + 4 <= count; i += 4) {
+    uint64x2_t const r0 = ApplyVector<Op>(vld1q_u64(dst + i), vld1q_u64(src + i));
+    uint64x2_t const r1 = ApplyVector<Op>(vld1q_u64(dst + i + 2), vld1q_u64(src + i + 2));
+    vst1q_u64(dst + i, r0);
+    vst1q_u64(dst + i + 2, r1);
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] = ApplyWord<Op>(dst[i], src[i]);
+  }
+}
+
+#if MBASE_PLATFORM_SSE2
+/// Set bits in each 64-bit half of `v`: SWAR bit counts within the bytes, summed by `psadbw`.
+[[nodiscard]] inline __m128i PopcountVector(__m128i v) noexcept {
+  __m128i const m1 = _mm_set1_epi8(0x55);
+  __m128i const m2 = _mm_set1_epi8(0x33);
+  __m128i const m4 = _mm_set1_epi8(0x0F);
+  v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), m1));
+  v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi64(v, 2), m2));
+  v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), m4);
+  return _mm_sad_epu8(v, _mm_setzero_si128());
+}
+
+/// Carry-save adder: per bit, `carry` and `sum` of `a + b + c`.
+inline void CarrySaveAdd(__m128i& carry, __m128i& sum, __m128i a, __m128i b, __m128i c) noexcept {
+  __m128i const u = _mm_xor_si128(a, b);
+  carry = _mm_or_si128(_mm_and_si128(a, b), _mm_and_si128(u, c));
+  sum = _mm_xor_si128(u, c);
+}
+
+/// Harley-Seal popcount of `block_count` blocks of 16 vectors (32 words): carry-save adders reduce each block to one
+/// vector of sixteens, so only one vector popcount runs per block (Mula, Kurz, Lemire, "Faster Population Counts
+/// Using AVX2 Instructions", 2018).
+[[nodiscard]] inline uint64_t CountBlocks(__m128i const* v, size_t block_count) noexcept {
+  __m128i total = _mm_setzero_si128();
+  __m128i ones = _mm_setzero_si128(), twos = _mm_setzero_si128(), fours = _mm_setzero_si128(), eights = _mm_setzero_si128();
+  __m128i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b, sixteens;
+  for (size_t block = 0; block != block_count; ++block, v += 16) {
+    CarrySaveAdd(twos_a, ones, ones, _mm_loadu_si128(v), _mm_loadu_si128(v + 1));
+    CarrySaveAdd(twos_b, ones, ones, _mm_loadu_si128(v + 2), _mm_loadu_si128(v + 3));
+    CarrySaveAdd(fours_a, twos, twos, twos_a, twos_b);
+    CarrySaveAdd(twos_a, ones, ones, _mm_loadu_si128(v + 4), _mm_loadu_si128(v + 5));
+    CarrySaveAdd(twos_b, ones, ones, _mm_loadu_si128(v + 6), _mm_loadu_si128(v + 7));
+    CarrySaveAdd(fours_b, twos, twos, twos_a, twos_b);
+    CarrySaveAdd(eights_a, fours, fours, fours_a, fours_b);
+    CarrySaveAdd(twos_a, ones, ones, _mm_loadu_si128(v + 8), _mm_loadu_si128(v + 9));
+    CarrySaveAdd(twos_b, ones, ones, _mm_loadu_si128(v + 10), _mm_loadu_si128(v + 11));
+    CarrySaveAdd(fours_a, twos, twos, twos_a, twos_b);
+    CarrySaveAdd(twos_a, ones, ones, _mm_loadu_si128(v + 12), _mm_loadu_si128(v + 13));
+    CarrySaveAdd(twos_b, ones, ones, _mm_loadu_si128(v + 14), _mm_loadu_si128(v + 15));
+    CarrySaveAdd(fours_b, twos, twos, twos_a, twos_b);
+    CarrySaveAdd(eights_b, fours, fours, fours_a, fours_b);
+    CarrySaveAdd(sixteens, eights, eights, eights_a, eights_b);
+    total = _mm_add_epi64(total, PopcountVector(sixteens));
+  }
+  total = _mm_slli_epi64(total, 4);
+  total = _mm_add_epi64(total, _mm_slli_epi64(PopcountVector(eights), 3));
+  total = _mm_add_epi64(total, _mm_slli_epi64(PopcountVector(fours), 2));
+  total = _mm_add_epi64(total, _mm_slli_epi64(PopcountVector(twos), 1));
+  total = _mm_add_epi64(total, PopcountVector(ones));
+  uint64_t halves[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(halves), total);
+  return halves[0] + halves[1];
+}
+#endif
+
+/// Number of set bits in `count` words: Harley-Seal over 32-word blocks on SSE2, `vcntq_u8` four words at a time on
+/// NEON, and `std::popcount` with four independent accumulators for the rest.
+[[nodiscard]] inline size_t CountWords(uint64_t const* words, size_t count) noexcept {
+  size_t result = 0;
+  size_t i = 0;
+#if MBASE_PLATFORM_SSE2
+  result += size_t(CountBlocks(reinterpret_cast<__m128i const*>(words), count / 32));
+  i = count / 32 * 32;
+#elif MBASE_PLATFORM_NEON
+  uint64x2_t total = vdupq_n_u64(0);
+  for (; i + 4 <= count; i += 4) {
+    auto const bytes = reinterpret_cast<uint8_t const*>(words + i);
+    // At most 16 per byte lane, widened pairwise to 64-bit lanes.
+    uint8x16_t const counts = vaddq_u8(vcntq_u8(vld1q_u8(bytes)), vcntq_u8(vld1q_u8(bytes + 16)));
+    total = vpadalq_u32(total, vpaddlq_u16(vpaddlq_u8(counts)));
+  }
+  result += size_t(vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1));
+#endif
+  size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+  for (; i + 4 <= count; i += 4) {
+    c0 += std::popcount(words[i]);
+    c1 += std::popcount(words[i + 1]);
+    c2 += std::popcount(words[i + 2]);
+    c3 += std::popcount(words[i + 3]);
+  }
+  for (; i < count; ++i) {
+    c0 += std::popcount(words[i]);
+  }
+  return result + c0 + c1 + c2 + c3;
+}
+
+} // namespace detail::bitset
+
+/// Resizable bitset over 64-bit words, with SIMD kernels for whole-set algebra.
+/// Bits past `size()` in the last word are kept zero; code writing through `words()` must preserve that.
+/// Up to `InlineWords * 64` bits are stored inline; word storage is aligned for vector loads either way.
+template<size_t InlineWords = 4, class TAllocator = AlignedAllocator>
+class BasicDynamicBitset final {
+public:
+  using word_type = uint64_t;
+  using size_type = size_t;
+  using allocator_type = TAllocator;
+
+  static constexpr size_t kBitsPerWord = 64;
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  BasicDynamicBitset() = default;
+  explicit BasicDynamicBitset(allocator_type const& allocator) : words_(allocator) {}
+  explicit BasicDynamicBitset(size_type size, bool value = false, allocator_type const& allocator = allocator_type()) :
+    words_(allocator)
+  {
+    resize(size, value);
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] size_type word_count() const noexcept { return words_.size(); }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return words_.get_allocator(); }
+
+  /// Word storage: bit `i` is bit `i % 64` of word `i / 64`.
+  [[nodiscard]] ArrayProxy<word_type> words() noexcept { return { words_.data(), words_.size() }; }
+  [[nodiscard]] ArrayProxy<word_type const> words() const noexcept { return { words_.data(), words_.size() }; }
+
+  void reserve(size_type bit_capacity) {
+    words_.reserve(WordCount(bit_capacity));
+  }
+
+  /// New bits are set to `value`.
+  void resize(size_type new_size, bool value = false) {
+    size_type const old_size = size_;
+    words_.resize(WordCount(new_size), value ? ~word_type(0) : word_type(0));
+    if (value && new_size > old_size && old_size % kBitsPerWord != 0) {
+      words_[old_size / kBitsPerWord] |= ~word_type(0) << (old_size % kBitsPerWord);
+    }
+    size_ = new_size;
+    clear_unused_bits();
+  }
+  void clear() noexcept {
+    words_.clear();
+    size_ = 0;
+  }
+
+  void push_back(bool value) {
+    if (size_ % kBitsPerWord == 0) {
+      words_.push_back(0);
+    }
+    ++size_;
+    set(size_ - 1, value);
+  }
+
+  [[nodiscard]] bool test(size_type i) const noexcept {
+    return (words_[i / kBitsPerWord] >> (i % kBitsPerWord)) & 1;
+  }
+  [[nodiscard]] bool operator[](size_type i) const noexcept { return test(i); }
+
+  BasicDynamicBitset& set(size_type i) noexcept {
+    words_[i / kBitsPerWord] |= Bit(i);
+    return *this;
+  }
+  BasicDynamicBitset& set(size_type i, bool value) noexcept {
+    return value ? set(i) : reset(i);
+  }
+  BasicDynamicBitset& reset(size_type i) noexcept {
+    words_[i / kBitsPerWord] &= ~Bit(i);
+    return *this;
+  }
+  BasicDynamicBitset& flip(size_type i) noexcept {
+    words_[i / kBitsPerWord] ^= Bit(i);
+    return *this;
+  }
+
+  BasicDynamicBitset& set() noexcept {
+    std::fill(words_.begin(), words_.end(), ~word_type(0));
+    clear_unused_bits();
+    return *this;
+  }
+  BasicDynamicBitset& reset() noexcept {
+    std::fill(words_.begin(), words_.end(), word_type(0));
+    return *this;
+  }
+  BasicDynamicBitset& flip() noexcept {
+    for (word_type& word : words_) {
+      word = ~word;
+    }
+    clear_unused_bits();
+    return *this;
+  }
+
+  [[nodiscard]] size_type count() const noexcept {
+    return detail::bitset::CountWords(words_.data(), words_.size());
+  }
+  [[nodiscard]] bool any() const noexcept {
+    return std::any_of(words_.begin(), words_.end(), [](word_type word) { return word != 0; });
+  }
+  [[nodiscard]] bool none() const noexcept { return !any(); }
+  [[nodiscard]] bool all() const noexcept { return count() == size_; }
+
+  /// `true` if any bit is set in both bitsets.
+  [[nodiscard]] bool intersects(BasicDynamicBitset const& rhs) const noexcept {
+    MBASE_ASSERT(size_ == rhs.size_);
+    for (size_t i = 0; i != words_.size(); ++i) {
+      if (words_[i] & rhs.words_[i]) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Index of the lowest set bit, or `npos`.
+  [[nodiscard]] size_type find_first() const noexcept {
+    return find_from_word(0);
+  }
+  /// Index of the lowest set bit after `pos`, or `npos`.
+  [[nodiscard]] size_type find_next(size_type pos) const noexcept {
+    ++pos;
+    if (pos >= size_) {
+      return npos;
+    }
+    size_t const word_index = pos / kBitsPerWord;
+    word_type const word = words_[word_index] & (~word_type(0) << (pos % kBitsPerWord));
+    if (word != 0) {
+      return word_index * kBitsPerWord + std::countr_zero(word);
+    }
+    return find_from_word(word_index + 1);
+  }
+
+  /// Calls `function(index)` for every set bit, in increasing order.
+  template<class TFunction>
+  void for_each_set(TFunction&& function) const {
+    for (size_t word_index = 0; word_index != words_.size(); ++word_index) {
+      for (word_type word = words_[word_index]; word != 0; word &= word - 1) {
+        function(word_index * kBitsPerWord + std::countr_zero(word));
+      }
+    }
+  }
+
+  // Bulk algebra; both operands must have the same size.
+  BasicDynamicBitset& operator&=(BasicDynamicBitset const& rhs) noexcept {
+    return apply<detail::bitset::WordOp::kAnd>(rhs);
+  }
+  BasicDynamicBitset& operator|=(BasicDynamicBitset const& rhs) noexcept {
+    return apply<detail::bitset::WordOp::kOr>(rhs);
+  }
+  BasicDynamicBitset& operator^=(BasicDynamicBitset const& rhs) noexcept {
+    return apply<detail::bitset::WordOp::kXor>(rhs);
+  }
+  /// `*this &= ~rhs`, without materializing `~rhs`.
+  BasicDynamicBitset& and_not(BasicDynamicBitset const& rhs) noexcept {
+    return apply<detail::bitset::WordOp::kAndNot>(rhs);
+  }
+
+  friend BasicDynamicBitset operator&(BasicDynamicBitset lhs, BasicDynamicBitset const& rhs) { return lhs &= rhs; }
+  friend BasicDynamicBitset operator|(BasicDynamicBitset lhs, BasicDynamicBitset const& rhs) { return lhs |= rhs; }
+  friend BasicDynamicBitset operator^(BasicDynamicBitset lhs, BasicDynamicBitset const& rhs) { return lhs ^= rhs; }
+  friend BasicDynamicBitset operator~(BasicDynamicBitset value) { return value.flip(); }
+
+  friend bool operator==(BasicDynamicBitset const& lhs, BasicDynamicBitset const& rhs) noexcept {
+    return lhs.size_ == rhs.size_ && std::equal(lhs.words_.begin(), lhs.words_.end(), rhs.words_.begin());
+  }
+
+private:
+  // Wide enough for aligned SSE/NEON and AVX loads.
+  static constexpr size_t kWordAlignment = 32;
+
+  [[nodiscard]] static constexpr size_t WordCount(size_t bits) noexcept {
+    return (bits + kBitsPerWord - 1) / kBitsPerWord;
+  }
+  [[nodiscard]] static constexpr word_type Bit(size_t i) noexcept {
+    return word_type(1) << (i % kBitsPerWord);
+  }
+
+  void clear_unused_bits() noexcept {
+    if (size_ % kBitsPerWord != 0) {
+      words_.back() &= ~(~word_type(0) << (size_ % kBitsPerWord));
+    }
+  }
+
+  [[nodiscard]] size_type find_from_word(size_t word_index) const noexcept {
+    for (; word_index < words_.size(); ++word_index) {
+      if (words_[word_index] != 0) {
+        return word_index * kBitsPerWord + std::countr_zero(words_[word_index]);
+      }
+    }
+    return npos;
+  }
+
+  template<detail::bitset::WordOp Op>
+  BasicDynamicBitset& apply(BasicDynamicBitset const& rhs) noexcept {
+    MBASE_ASSERT(size_ == rhs.size_);
+    detail::bitset::ApplyWords<Op>(words_.data(), rhs.words_.data(), words_.size());
+    return *this;
+  }
+
+  SmallVector<word_type, InlineWords, kWordAlignment, TAllocator> words_;
+  size_t size_ = 0;
+};
+
+using DynamicBitset = BasicDynamicBitset<>;
+
+} // namespace mbase
@@ -0,0 +1,143 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/container/flat_hash_table.h"
+
+namespace mbase {
+
+namespace detail {
+
+template<class TKey, class TValue>
+struct FlatHashMapPolicy final {
+  using key_type = TKey;
+  using slot_type = std::pair<TKey const, TValue>;
+
+  static key_type const& Key(slot_type const& slot) noexcept { return slot.first; }
+};
+
+} // namespace detail
+
+/// Unordered map storing its elements inline in an open-addressing SwissTable-style table.
+/// Inserting may move elements: unlike `std::unordered_map`, references and iterators are invalidated by a rehash.
+/// Heterogeneous lookup is available with the default `Hash64` and `std::equal_to<>`.
+template<class TKey, class TValue, class THash = Hash64, class TEqual = std::equal_to<>, class TAllocator = AlignedAllocator>
+class FlatHashMap final : public detail::FlatHashTable<detail::FlatHashMapPolicy<TKey, TValue>, THash, TEqual, TAllocator> {
+  using base_type = detail::FlatHashTable<detail::FlatHashMapPolicy<TKey, TValue>, THash, TEqual, TAllocator>;
+
+public:
+  using mapped_type = TValue;
+  using typename base_type::key_type;
+  using typename base_type::value_type;
+  using typename base_type::iterator;
+  using typename base_type::const_iterator;
+  template<class K>
+  using key_arg = typename base_type::template key_arg<K>;
+
+  using base_type::base_type;
+  FlatHashMap() = default;
+  FlatHashMap(std::initializer_list<value_type> list) {
+    this->reserve(list.size());
+    for (auto const& value : list) {
+      insert(value);
+    }
+  }
+
+  template<class K = key_type, class... TArgs>
+  std::pair<iterator, bool> try_emplace(key_arg<K> const& key, TArgs&&... args) {
+    return this->find_or_insert(key, [&](value_type* slot) {
+      new(slot) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<TArgs>(args)...));
+    });
+  }
+  template<class... TArgs>
+  std::pair<iterator, bool> try_emplace(key_type&& key, TArgs&&... args) {
+    return this->find_or_insert(key, [&](value_type* slot) {
+      new(slot) value_type(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<TArgs>(args)...));
+    });
+  }
+
+  template<class K = key_type, class V>
+  std::pair<iterator, bool> insert_or_assign(key_arg<K> const& key, V&& value) {
+    auto result = try_emplace<K>(key, std::forward<V>(value));
+    if (!result.second) {
+      result.first->second = std::forward<V>(value);
+    }
+    return result;
+  }
+  template<class V>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, V&& value) {
+    auto result = try_emplace(std::move(key), std::forward<V>(value));
+    if (!result.second) {
+      result.first->second = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return this->find_or_insert(value.first, [&](value_type* slot) {
+      new(slot) value_type(value);
+    });
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return this->find_or_insert(value.first, [&](value_type* slot) {
+      new(slot) value_type(std::move(value));
+    });
+  }
+  template<class TIterator>
+  void insert(TIterator first, TIterator last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  /// Constructs the element up front to learn its key; prefer `try_emplace` when the key is at hand.
+  template<class... TArgs>
+  std::pair<iterator, bool> emplace(TArgs&&... args) {
+    value_type value(std::forward<TArgs>(args)...);
+    return insert(std::move(value));
+  }
+
+  template<class K = key_type>
+  mapped_type& operator[](key_arg<K> const& key) {
+    return try_emplace<K>(key).first->second;
+  }
+  mapped_type& operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] mapped_type& at(key_arg<K> const& key) {
+    auto it = this->template find<K>(key);
+    if (it == this->end()) {
+      throw std::out_of_range("FlatHashMap::at");
+    }
+    return it->second;
+  }
+  template<class K = key_type>
+  [[nodiscard]] mapped_type const& at(key_arg<K> const& key) const {
+    return const_cast<FlatHashMap*>(this)->template at<K>(key);
+  }
+};
+
+template<class TKey, class TValue, class THash, class TEqual, class TAllocator>
+bool operator==(FlatHashMap<TKey, TValue, THash, TEqual, TAllocator> const& lhs, FlatHashMap<TKey, TValue, THash, TEqual, TAllocator> const& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (auto const& [key, value] : lhs) {
+    auto it = rhs.find(key);
+    if (it == rhs.end() || !(it->second == value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace mbase
@@ -0,0 +1,85 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <functional>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/container/flat_hash_table.h"
+
+namespace mbase {
+
+namespace detail {
+
+template<class TKey>
+struct FlatHashSetPolicy final {
+  using key_type = TKey;
+  using slot_type = TKey;
+
+  static key_type const& Key(slot_type const& slot) noexcept { return slot; }
+};
+
+} // namespace detail
+
+/// Unordered set storing its elements inline in an open-addressing SwissTable-style table.
+/// Inserting may move elements: references and iterators are invalidated by a rehash.
+/// Elements must not be modified through iterators.
+template<class TKey, class THash = Hash64, class TEqual = std::equal_to<>, class TAllocator = AlignedAllocator>
+class FlatHashSet final : public detail::FlatHashTable<detail::FlatHashSetPolicy<TKey>, THash, TEqual, TAllocator> {
+  using base_type = detail::FlatHashTable<detail::FlatHashSetPolicy<TKey>, THash, TEqual, TAllocator>;
+
+public:
+  using typename base_type::key_type;
+  using typename base_type::value_type;
+  using typename base_type::iterator;
+  using typename base_type::const_iterator;
+
+  using base_type::base_type;
+  FlatHashSet() = default;
+  FlatHashSet(std::initializer_list<value_type> list) {
+    this->reserve(list.size());
+    for (auto const& value : list) {
+      insert(value);
+    }
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return this->find_or_insert(value, [&](value_type* slot) {
+      new(slot) value_type(value);
+    });
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return this->find_or_insert(value, [&](value_type* slot) {
+      new(slot) value_type(std::move(value));
+    });
+  }
+  template<class TIterator>
+  void insert(TIterator first, TIterator last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  template<class... TArgs>
+  std::pair<iterator, bool> emplace(TArgs&&... args) {
+    value_type value(std::forward<TArgs>(args)...);
+    return insert(std::move(value));
+  }
+};
+
+template<class TKey, class THash, class TEqual, class TAllocator>
+bool operator==(FlatHashSet<TKey, THash, TEqual, TAllocator> const& lhs, FlatHashSet<TKey, THash, TEqual, TAllocator> const& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (auto const& key : lhs) {
+    if (!rhs.contains(key)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace mbase
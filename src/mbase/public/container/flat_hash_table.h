@@ -0,0 +1,626 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/platform.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+#include "mbase/public/container.h"
+
+// conditional platform headers -------------------------
+#if MBASE_PLATFORM_SSE2
+# include <emmintrin.h>
+#elif MBASE_PLATFORM_NEON
+# include <arm_neon.h>
+#endif
+
+namespace mbase {
+
+namespace detail::swiss {
+
+// Control bytes, one per slot: `kEmpty`, `kDeleted` (tombstone) or, for a full slot, the 7-bit H2 part of its hash.
+using ctrl_t = int8_t;
+
+static constexpr ctrl_t kEmpty = -128;   // 0b10000000
+static constexpr ctrl_t kDeleted = -2;   // 0b11111110
+static constexpr ctrl_t kSentinel = -1;  // 0b11111111; never stored, used to classify `kEmpty`/`kDeleted` at once.
+
+[[nodiscard]] constexpr bool IsFull(ctrl_t c) noexcept { return c >= 0; }
+
+[[nodiscard]] constexpr size_t H1(uint64_t hash) noexcept { return static_cast<size_t>(hash >> 7); }
+[[nodiscard]] constexpr ctrl_t H2(uint64_t hash) noexcept { return static_cast<ctrl_t>(hash & 0x7F); }
+
+/// Set of slot indices within a group of `Width` slots, encoded `1 << Shift` bits per slot.
+template<class T, int Width, int Shift>
+class BitMask final {
+public:
+  explicit BitMask(T mask) noexcept : mask_(mask) {}
+
+  explicit operator bool() const noexcept { return mask_ != 0; }
+
+  [[nodiscard]] uint32_t LowestBitSet() const noexcept {
+    return static_cast<uint32_t>(std::countr_zero(mask_)) >> Shift;
+  }
+  /// Number of slots before the first set one; `Width` if none is set.
+  [[nodiscard]] uint32_t TrailingZeros() const noexcept {
+    return mask_ == 0 ? Width : LowestBitSet();
+  }
+  /// Number of slots after the last set one; `Width` if none is set.
+  [[nodiscard]] uint32_t LeadingZeros() const noexcept {
+    constexpr int kUnusedBits = static_cast<int>(sizeof(T) * 8) - (Width << Shift);
+    return mask_ == 0 ? Width : static_cast<uint32_t>(std::countl_zero(mask_) - kUnusedBits) >> Shift;
+  }
+
+  // Range-for support over the set indices.
+  BitMask begin() const noexcept { return *this; }
+  BitMask end() const noexcept { return BitMask(0); }
+  uint32_t operator*() const noexcept { return LowestBitSet(); }
+  BitMask& operator++() noexcept { mask_ &= mask_ - 1; return *this; }
+  bool operator!=(BitMask const& rhs) const noexcept { return mask_ != rhs.mask_; }
+
+private:
+  T mask_;
+};
+
+#if MBASE_PLATFORM_SSE2
+
+/// 16 control bytes matched with SSE2.
+struct Group final {
+  static constexpr size_t kWidth = 16;
+
+  explicit Group(ctrl_t const* pos) noexcept : ctrl(_mm_loadu_si128(reinterpret_cast<__m128i const*>(pos))) {}
+
+  [[nodiscard]] BitMask<uint32_t, 16, 0> Match(ctrl_t h2) const noexcept {
+    return BitMask<uint32_t, 16, 0>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))));
+  }
+  [[nodiscard]] BitMask<uint32_t, 16, 0> MaskEmpty() const noexcept {
+    return Match(kEmpty);
+  }
+  [[nodiscard]] BitMask<uint32_t, 16, 0> MaskEmptyOrDeleted() const noexcept {
+    return BitMask<uint32_t, 16, 0>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl))));
+  }
+
+  __m128i ctrl;
+};
+
+#elif MBASE_PLATFORM_NEON
+
+/// 8 control bytes matched with NEON; each slot maps to one byte of the 64-bit mask.
+struct Group final {
+  static constexpr size_t kWidth = 8;
+  static constexpr uint64_t kMsbs = 0x8080808080808080ULL;
+
+  explicit Group(ctrl_t const* pos) noexcept : ctrl(vld1_u8(reinterpret_cast<uint8_t const*>(pos))) {}
+
+  [[nodiscard]] BitMask<uint64_t, 8, 3> Match(ctrl_t h2) const noexcept {
+    uint8x8_t const eq = vceq_u8(ctrl, vdup_n_u8(static_cast<uint8_t>(h2)));
+    return BitMask<uint64_t, 8, 3>(vget_lane_u64(vreinterpret_u64_u8(eq), 0) & kMsbs);
+  }
+  [[nodiscard]] BitMask<uint64_t, 8, 3> MaskEmpty() const noexcept {
+    return Match(kEmpty);
+  }
+  [[nodiscard]] BitMask<uint64_t, 8, 3> MaskEmptyOrDeleted() const noexcept {
+    uint8x8_t const lt = vclt_s8(vreinterpret_s8_u8(ctrl), vdup_n_s8(kSentinel));
+    return BitMask<uint64_t, 8, 3>(vget_lane_u64(vreinterpret_u64_u8(lt), 0) & kMsbs);
+  }
+
+  uint8x8_t ctrl;
+};
+
+#else
+
+/// 8 control bytes matched with 64-bit SWAR arithmetic.
+struct Group final {
+  static constexpr size_t kWidth = 8;
+  static constexpr uint64_t kMsbs = 0x8080808080808080ULL;
+  static constexpr uint64_t kLsbs = 0x0101010101010101ULL;
+
+  explicit Group(ctrl_t const* pos) noexcept {
+    memcpy(&ctrl, pos, sizeof(ctrl));
+#if MBASE_ENDIAN_ORDER == MBASE_ENDIAN_BIG
+    ctrl = __builtin_bswap64(ctrl);
+#endif
+  }
+
+  /// May report false positives for bytes next to a true match; callers compare keys anyway.
+  [[nodiscard]] BitMask<uint64_t, 8, 3> Match(ctrl_t h2) const noexcept {
+    uint64_t const x = ctrl ^ (kLsbs * static_cast<uint8_t>(h2));
+    return BitMask<uint64_t, 8, 3>((x - kLsbs) & ~x & kMsbs);
+  }
+  [[nodiscard]] BitMask<uint64_t, 8, 3> MaskEmpty() const noexcept {
+    return BitMask<uint64_t, 8, 3>((ctrl & ~(ctrl << 6)) & kMsbs);
+  }
+  [[nodiscard]] BitMask<uint64_t, 8, 3> MaskEmptyOrDeleted() const noexcept {
+    return BitMask<uint64_t, 8, 3>((ctrl & ~(ctrl << 7)) & kMsbs);
+  }
+
+  uint64_t ctrl;
+};
+
+#endif
+
+/// Smallest valid capacity (a power of two, at least one group) holding `size` elements under the maximum load factor.
+[[nodiscard]] inline size_t CapacityForSize(size_t size) noexcept {
+  if (size == 0) {
+    return 0;
+  }
+  size_t const min_capacity = size + (size + 6) / 7; // size * 8 / 7, rounded up.
+  return std::max(Group::kWidth, std::bit_ceil(min_capacity));
+}
+
+/// Maximum number of elements in a table of `capacity` slots: a load factor of 7/8.
+[[nodiscard]] constexpr size_t MaxSizeForCapacity(size_t capacity) noexcept {
+  return capacity - capacity / 8;
+}
+
+} // namespace detail::swiss
+
+namespace detail {
+
+/// Open-addressing hash table in the style of SwissTable: slots are stored flat, with a parallel array of control
+/// bytes probed a group at a time with SIMD. Shared implementation of `FlatHashMap` and `FlatHashSet`.
+///
+/// `TPolicy` provides:
+///   using key_type = ...;
+///   using slot_type = ...;
+///   static key_type const& Key(slot_type const& slot);
+///
+/// The capacity is zero or a power of two of at least `Group::kWidth`. The control array holds `capacity + kWidth`
+/// bytes, the last `kWidth` mirroring the first ones, so that a group can be loaded at any slot without wrapping.
+template<class TPolicy, class THash, class TEqual, class TAllocator>
+class FlatHashTable {
+public:
+  using key_type = typename TPolicy::key_type;
+  using value_type = typename TPolicy::slot_type;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = THash;
+  using key_equal = TEqual;
+  using allocator_type = TAllocator;
+  using reference = value_type&;
+  using const_reference = value_type const&;
+
+  /// Heterogeneous lookup is enabled when both `THash` and `TEqual` are transparent.
+  template<class K>
+  using key_arg = typename KeyArg<is_transparent_v<THash> && is_transparent_v<TEqual>>::template type<K, key_type>;
+
+  template<bool IsConst>
+  class Iterator final {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename TPolicy::slot_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<IsConst, value_type const&, value_type&>;
+    using pointer = std::conditional_t<IsConst, value_type const*, value_type*>;
+
+    Iterator() = default;
+    Iterator(swiss::ctrl_t const* ctrl, swiss::ctrl_t const* ctrl_end, value_type* slot) noexcept :
+      ctrl_(ctrl),
+      ctrl_end_(ctrl_end),
+      slot_(slot)
+    {
+    }
+    // Iterator -> ConstIterator
+    template<bool C = IsConst, std::enable_if_t<C, int> = 0>
+    Iterator(Iterator<false> const& rhs) noexcept :
+      ctrl_(rhs.ctrl_),
+      ctrl_end_(rhs.ctrl_end_),
+      slot_(rhs.slot_)
+    {
+    }
+
+    reference operator*() const noexcept { return *slot_; }
+    pointer operator->() const noexcept { return slot_; }
+
+    Iterator& operator++() noexcept {
+      ++ctrl_;
+      ++slot_;
+      SkipEmptyOrDeleted();
+      return *this;
+    }
+    Iterator operator++(int) noexcept {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    friend bool operator==(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.ctrl_ == rhs.ctrl_; }
+    friend bool operator!=(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.ctrl_ != rhs.ctrl_; }
+
+  private:
+    friend class FlatHashTable;
+    friend class Iterator<true>;
+
+    void SkipEmptyOrDeleted() noexcept {
+      while (ctrl_ != ctrl_end_ && !swiss::IsFull(*ctrl_)) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+
+    swiss::ctrl_t const* ctrl_ = nullptr;
+    swiss::ctrl_t const* ctrl_end_ = nullptr;
+    value_type* slot_ = nullptr;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashTable() = default;
+  explicit FlatHashTable(size_type bucket_count, hasher const& hash = hasher(), key_equal const& equal = key_equal(), allocator_type const& allocator = allocator_type()) :
+    hash_(hash),
+    equal_(equal),
+    allocator_(allocator)
+  {
+    reserve(bucket_count);
+  }
+  FlatHashTable(FlatHashTable const& rhs) :
+    hash_(rhs.hash_),
+    equal_(rhs.equal_),
+    allocator_(rhs.allocator_)
+  {
+    try {
+      copy_from(rhs);
+    }
+    catch (...) {
+      destroy();
+      throw;
+    }
+  }
+  FlatHashTable(FlatHashTable&& rhs) noexcept :
+    hash_(std::move(rhs.hash_)),
+    equal_(std::move(rhs.equal_)),
+    allocator_(std::move(rhs.allocator_))
+  {
+    steal_from(rhs);
+  }
+  ~FlatHashTable() {
+    destroy();
+  }
+
+  /// Copy-and-swap: leaves `*this` unchanged if a copy throws.
+  FlatHashTable& operator=(FlatHashTable const& rhs) {
+    if (this != &rhs) {
+      FlatHashTable copy(rhs);
+      swap(copy);
+    }
+    return *this;
+  }
+  FlatHashTable& operator=(FlatHashTable&& rhs) noexcept {
+    if (this != &rhs) {
+      destroy();
+      hash_ = std::move(rhs.hash_);
+      equal_ = std::move(rhs.equal_);
+      allocator_ = std::move(rhs.allocator_);
+      steal_from(rhs);
+    }
+    return *this;
+  }
+
+  iterator begin() noexcept {
+    iterator it(ctrl_, ctrl_ + capacity_, slots_);
+    it.SkipEmptyOrDeleted();
+    return it;
+  }
+  const_iterator begin() const noexcept { return const_cast<FlatHashTable*>(this)->begin(); }
+  iterator end() noexcept { return iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_); }
+  const_iterator end() const noexcept { return const_cast<FlatHashTable*>(this)->end(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] size_type capacity() const noexcept { return capacity_; }
+  [[nodiscard]] float load_factor() const noexcept { return capacity_ == 0 ? 0.0f : float(size_) / float(capacity_); }
+
+  [[nodiscard]] hasher hash_function() const { return hash_.get(); }
+  [[nodiscard]] key_equal key_eq() const { return equal_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  void clear() noexcept {
+    if (capacity_ == 0) {
+      return;
+    }
+    for (size_t i = 0; i != capacity_; ++i) {
+      if (swiss::IsFull(ctrl_[i])) {
+        slots_[i].~value_type();
+      }
+    }
+    reset_ctrl();
+    size_ = 0;
+  }
+
+  /// Makes room for `count` elements in total, rehashing at most once.
+  void reserve(size_type count) {
+    if (count <= size_ + growth_left_) {
+      return;
+    }
+    rehash_to(swiss::CapacityForSize(count));
+  }
+
+  /// Rehashes to the smallest capacity holding `max(count, size())` elements; also drops tombstones.
+  void rehash(size_type count) {
+    size_type const new_capacity = swiss::CapacityForSize(std::max(count, size_));
+    if (new_capacity == 0) {
+      destroy();
+      return;
+    }
+    rehash_to(new_capacity);
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] iterator find(key_arg<K> const& key) {
+    if (size_ == 0) {
+      return end();
+    }
+    size_t const index = find_index(key, hash_(key));
+    return index == capacity_ ? end() : iterator_at(index);
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator find(key_arg<K> const& key) const {
+    return const_cast<FlatHashTable*>(this)->template find<K>(key);
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    return find<K>(key) != end();
+  }
+  template<class K = key_type>
+  [[nodiscard]] size_type count(key_arg<K> const& key) const {
+    return contains<K>(key) ? 1 : 0;
+  }
+
+  /// Erasing leaves a tombstone and never moves other elements: iterators to them stay valid.
+  iterator erase(const_iterator position) {
+    size_t const index = static_cast<size_t>(position.ctrl_ - ctrl_);
+    slots_[index].~value_type();
+    release_slot(index);
+
+    iterator next = iterator_at(index);
+    return ++next;
+  }
+  iterator erase(iterator position) {
+    return erase(const_iterator(position));
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    while (first != last) {
+      first = erase(first);
+    }
+    return iterator_at(static_cast<size_t>(last.ctrl_ - ctrl_));
+  }
+  template<class K = key_type>
+  size_type erase(key_arg<K> const& key) {
+    auto it = find<K>(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  void swap(FlatHashTable& rhs) noexcept {
+    using std::swap;
+    swap(ctrl_, rhs.ctrl_);
+    swap(slots_, rhs.slots_);
+    swap(capacity_, rhs.capacity_);
+    swap(size_, rhs.size_);
+    swap(growth_left_, rhs.growth_left_);
+    swap(hash_, rhs.hash_);
+    swap(equal_, rhs.equal_);
+    swap(allocator_, rhs.allocator_);
+  }
+
+protected:
+  /// Looks `key` up and, if absent, claims a slot for it; `construct` is then called with the slot's address
+  /// and must construct the element there.
+  template<class K, class TConstruct>
+  std::pair<iterator, bool> find_or_insert(K const& key, TConstruct&& construct) {
+    uint64_t const hash = hash_(key);
+    if (size_ != 0) {
+      size_t const index = find_index(key, hash);
+      if (index != capacity_) {
+        return { iterator_at(index), false };
+      }
+    }
+
+    size_t const index = prepare_insert(hash);
+    try {
+      construct(slots_ + index);
+    }
+    catch (...) {
+      release_slot(index);
+      throw;
+    }
+    return { iterator_at(index), true };
+  }
+
+  [[nodiscard]] iterator iterator_at(size_t index) noexcept {
+    return iterator(ctrl_ + index, ctrl_ + capacity_, slots_ + index);
+  }
+
+private:
+  template<class K>
+  [[nodiscard]] size_t find_index(K const& key, uint64_t hash) const {
+    size_t const mask = capacity_ - 1;
+    size_t pos = swiss::H1(hash) & mask;
+    size_t step = 0;
+    while (true) {
+      swiss::Group const group(ctrl_ + pos);
+      for (uint32_t i : group.Match(swiss::H2(hash))) {
+        size_t const index = (pos + i) & mask;
+        if (equal_(TPolicy::Key(slots_[index]), key)) [[likely]] {
+          return index;
+        }
+      }
+      if (group.MaskEmpty()) [[likely]] {
+        return capacity_;
+      }
+      step += swiss::Group::kWidth;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  /// First empty or deleted slot on the probe sequence of `hash`; the table must not be full.
+  [[nodiscard]] size_t find_first_non_full(uint64_t hash) const noexcept {
+    size_t const mask = capacity_ - 1;
+    size_t pos = swiss::H1(hash) & mask;
+    size_t step = 0;
+    while (true) {
+      swiss::Group const group(ctrl_ + pos);
+      if (auto empty_or_deleted = group.MaskEmptyOrDeleted()) {
+        return (pos + empty_or_deleted.LowestBitSet()) & mask;
+      }
+      step += swiss::Group::kWidth;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  size_t prepare_insert(uint64_t hash) {
+    size_t index = capacity_ == 0 ? 0 : find_first_non_full(hash);
+    if (growth_left_ == 0 && (capacity_ == 0 || ctrl_[index] != swiss::kDeleted)) {
+      // Reclaim tombstones in place if they make up a large part of the table; grow otherwise.
+      if (capacity_ != 0 && size_ * 32 <= capacity_ * 25) {
+        rehash_to(capacity_);
+      }
+      else {
+        rehash_to(capacity_ == 0 ? swiss::Group::kWidth : capacity_ * 2);
+      }
+      index = find_first_non_full(hash);
+    }
+
+    if (ctrl_[index] == swiss::kEmpty) {
+      --growth_left_;
+    }
+    set_ctrl(index, swiss::H2(hash));
+    ++size_;
+    return index;
+  }
+
+  /// Marks the full slot at `index`, whose element is already destroyed, as free. The slot becomes empty again if no
+  /// probe sequence can have passed it while looking for an empty slot, i.e. if every group-wide window covering it
+  /// has an empty slot; otherwise it becomes a tombstone, which keeps such probes going.
+  void release_slot(size_t index) noexcept {
+    size_t const index_before = (index - swiss::Group::kWidth) & (capacity_ - 1);
+    auto const empty_after = swiss::Group(ctrl_ + index).MaskEmpty();
+    auto const empty_before = swiss::Group(ctrl_ + index_before).MaskEmpty();
+    bool const was_never_full = empty_after && empty_before &&
+      empty_after.TrailingZeros() + empty_before.LeadingZeros() < swiss::Group::kWidth;
+
+    if (was_never_full) {
+      set_ctrl(index, swiss::kEmpty);
+      ++growth_left_;
+    }
+    else {
+      set_ctrl(index, swiss::kDeleted);
+    }
+    --size_;
+  }
+
+  void set_ctrl(size_t index, swiss::ctrl_t value) noexcept {
+    ctrl_[index] = value;
+    if (index < swiss::Group::kWidth) {
+      ctrl_[capacity_ + index] = value;
+    }
+  }
+
+  void reset_ctrl() noexcept {
+    memset(ctrl_, static_cast<uint8_t>(swiss::kEmpty), capacity_ + swiss::Group::kWidth);
+    growth_left_ = swiss::MaxSizeForCapacity(capacity_);
+  }
+
+  [[nodiscard]] static size_t ctrl_bytes(size_t capacity) noexcept {
+    size_t const bytes = capacity + swiss::Group::kWidth;
+    return (bytes + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+  }
+  [[nodiscard]] static size_t allocation_size(size_t capacity) noexcept {
+    return ctrl_bytes(capacity) + sizeof(value_type) * capacity;
+  }
+  [[nodiscard]] static constexpr size_t allocation_alignment() noexcept {
+    return std::max(alignof(value_type), swiss::Group::kWidth);
+  }
+
+  void rehash_to(size_t new_capacity) {
+    auto old_ctrl = ctrl_;
+    auto old_slots = slots_;
+    auto old_capacity = capacity_;
+
+    auto block = static_cast<std::byte*>(allocator_.allocate(allocation_size(new_capacity), allocation_alignment()));
+    ctrl_ = reinterpret_cast<swiss::ctrl_t*>(block);
+    slots_ = reinterpret_cast<value_type*>(block + ctrl_bytes(new_capacity));
+    capacity_ = new_capacity;
+    reset_ctrl();
+
+    for (size_t i = 0; i != old_capacity; ++i) {
+      if (swiss::IsFull(old_ctrl[i])) {
+        uint64_t const hash = hash_(TPolicy::Key(old_slots[i]));
+        size_t const index = find_first_non_full(hash);
+        set_ctrl(index, swiss::H2(hash));
+        relocate_strategy<value_type>::non_overlapping(old_slots + i, old_slots + i + 1, slots_ + index);
+      }
+    }
+    growth_left_ -= size_;
+
+    if (old_capacity != 0) {
+      allocator_.deallocate(old_ctrl, allocation_size(old_capacity), allocation_alignment());
+    }
+  }
+
+  void copy_from(FlatHashTable const& rhs) {
+    reserve(rhs.size_);
+    for (auto const& value : rhs) {
+      uint64_t const hash = hash_(TPolicy::Key(value));
+      size_t const index = prepare_insert(hash);
+      try {
+        new(slots_ + index) value_type(value);
+      }
+      catch (...) {
+        release_slot(index);
+        throw;
+      }
+    }
+  }
+
+  void steal_from(FlatHashTable& rhs) noexcept {
+    ctrl_ = std::exchange(rhs.ctrl_, nullptr);
+    slots_ = std::exchange(rhs.slots_, nullptr);
+    capacity_ = std::exchange(rhs.capacity_, 0);
+    size_ = std::exchange(rhs.size_, 0);
+    growth_left_ = std::exchange(rhs.growth_left_, 0);
+  }
+
+  void destroy() noexcept {
+    if (capacity_ == 0) {
+      return;
+    }
+    clear();
+    allocator_.deallocate(ctrl_, allocation_size(capacity_), allocation_alignment());
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0;
+    growth_left_ = 0;
+  }
+
+  swiss::ctrl_t* ctrl_ = nullptr;
+  value_type* slots_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t growth_left_ = 0;
+
+  MBASE_NO_UNIQUE_ADDRESS KeyHasher<hasher, key_type> hash_ {};
+  MBASE_NO_UNIQUE_ADDRESS key_equal equal_ {};
+  MBASE_NO_UNIQUE_ADDRESS allocator_type allocator_ {};
+};
+
+} // namespace detail
+
+} // namespace mbase
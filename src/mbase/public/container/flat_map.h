@@ -0,0 +1,417 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+#include "mbase/public/algorithm/branchless_lower_bound.h"
+
+namespace mbase {
+
+/// Ordered map backed by two sorted `SmallVector`s, one of keys and one of values.
+/// Lookups are a branchless binary search over the contiguous keys; inserting or erasing a single element is linear.
+/// Use `insert(first, last)`, `insert_sorted` or `merge` to add many elements with a single sort and merge pass.
+/// Iterators dereference to `std::pair<key_type const&, mapped_type&>` proxies; `keys()`/`values()` view the storage
+/// directly. Any insertion or erasure invalidates iterators.
+template<
+  class TKey,
+  class TValue,
+  size_t InitialCapacity = 8,
+  class TCompare = std::less<>,
+  class TAllocator = AlignedAllocator
+>
+class FlatMap final {
+public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using value_type = std::pair<TKey, TValue>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using key_compare = TCompare;
+  using allocator_type = TAllocator;
+  using key_container_type = SmallVector<TKey, InitialCapacity, std::max(alignof(TKey), sizeof(void*)), TAllocator>;
+  using mapped_container_type = SmallVector<TValue, InitialCapacity, std::max(alignof(TValue), sizeof(void*)), TAllocator>;
+
+  template<class K>
+  using key_arg = typename detail::KeyArg<is_transparent_v<TCompare>>::template type<K, key_type>;
+
+  template<bool IsConst>
+  class Iterator final {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::pair<TKey, TValue>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::pair<TKey const&, std::conditional_t<IsConst, TValue const&, TValue&>>;
+
+    struct pointer final {
+      reference ref;
+      reference const* operator->() const noexcept { return &ref; }
+    };
+
+    Iterator() = default;
+    Iterator(TKey const* key, std::conditional_t<IsConst, TValue const*, TValue*> value) noexcept : key_(key), value_(value) {}
+    // Iterator -> ConstIterator
+    template<bool C = IsConst, std::enable_if_t<C, int> = 0>
+    Iterator(Iterator<false> const& rhs) noexcept : key_(rhs.key_), value_(rhs.value_) {}
+
+    reference operator*() const noexcept { return { *key_, *value_ }; }
+    pointer operator->() const noexcept { return { **this }; }
+    reference operator[](difference_type n) const noexcept { return { key_[n], value_[n] }; }
+
+    TKey const& key() const noexcept { return *key_; }
+    auto& value() const noexcept { return *value_; }
+
+    Iterator& operator++() noexcept { ++key_; ++value_; return *this; }
+    Iterator& operator--() noexcept { --key_; --value_; return *this; }
+    Iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+    Iterator operator--(int) noexcept { auto tmp = *this; --*this; return tmp; }
+    Iterator& operator+=(difference_type n) noexcept { key_ += n; value_ += n; return *this; }
+    Iterator& operator-=(difference_type n) noexcept { key_ -= n; value_ -= n; return *this; }
+    friend Iterator operator+(Iterator it, difference_type n) noexcept { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) noexcept { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.key_ - rhs.key_; }
+
+    friend bool operator==(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.key_ == rhs.key_; }
+    friend auto operator<=>(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.key_ <=> rhs.key_; }
+
+  private:
+    friend class FlatMap;
+    friend class Iterator<true>;
+
+    TKey const* key_ = nullptr;
+    std::conditional_t<IsConst, TValue const*, TValue*> value_ = nullptr;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  FlatMap() = default;
+  explicit FlatMap(TCompare const& comp, TAllocator const& allocator = TAllocator()) :
+    keys_(allocator),
+    values_(allocator),
+    comp_(comp)
+  {
+  }
+  explicit FlatMap(TAllocator const& allocator) :
+    keys_(allocator),
+    values_(allocator)
+  {
+  }
+  template<class TInputIterator>
+  FlatMap(TInputIterator first, TInputIterator last, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    FlatMap(comp, allocator)
+  {
+    insert(first, last);
+  }
+  FlatMap(std::initializer_list<value_type> list, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    FlatMap(list.begin(), list.end(), comp, allocator)
+  {
+  }
+
+  iterator begin() noexcept { return { keys_.data(), values_.data() }; }
+  const_iterator begin() const noexcept { return { keys_.data(), values_.data() }; }
+  iterator end() noexcept { return begin() + size(); }
+  const_iterator end() const noexcept { return begin() + size(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  [[nodiscard]] bool empty() const noexcept { return keys_.empty(); }
+  [[nodiscard]] size_type size() const noexcept { return keys_.size(); }
+  [[nodiscard]] size_type capacity() const noexcept { return keys_.capacity(); }
+
+  [[nodiscard]] key_compare key_comp() const { return comp_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return keys_.get_allocator(); }
+
+  /// Sorted keys, parallel to `values()`.
+  [[nodiscard]] ArrayProxy<TKey const> keys() const noexcept { return { keys_.data(), keys_.size() }; }
+  [[nodiscard]] ArrayProxy<TValue> values() noexcept { return { values_.data(), values_.size() }; }
+  [[nodiscard]] ArrayProxy<TValue const> values() const noexcept { return { values_.data(), values_.size() }; }
+
+  void clear() {
+    keys_.clear();
+    values_.clear();
+  }
+  void reserve(size_type new_capacity) {
+    keys_.reserve(new_capacity);
+    values_.reserve(new_capacity);
+  }
+  void shrink_to_fit() {
+    keys_.shrink_to_fit();
+    values_.shrink_to_fit();
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] iterator lower_bound(key_arg<K> const& key) {
+    return begin() + key_index(key);
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator lower_bound(key_arg<K> const& key) const {
+    return begin() + key_index(key);
+  }
+  template<class K = key_type>
+  [[nodiscard]] iterator upper_bound(key_arg<K> const& key) {
+    return begin() + (branchless_upper_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin());
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator upper_bound(key_arg<K> const& key) const {
+    return begin() + (branchless_upper_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin());
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] iterator find(key_arg<K> const& key) {
+    size_t const index = key_index(key);
+    return index != size() && !comp_(key, keys_[index]) ? begin() + index : end();
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator find(key_arg<K> const& key) const {
+    return const_cast<FlatMap*>(this)->template find<K>(key);
+  }
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    return find<K>(key) != end();
+  }
+  template<class K = key_type>
+  [[nodiscard]] size_type count(key_arg<K> const& key) const {
+    return contains<K>(key) ? 1 : 0;
+  }
+
+  template<class K = key_type>
+  [[nodiscard]] mapped_type& at(key_arg<K> const& key) {
+    auto it = find<K>(key);
+    if (it == end()) {
+      throw std::out_of_range("FlatMap::at");
+    }
+    return it.value();
+  }
+  template<class K = key_type>
+  [[nodiscard]] mapped_type const& at(key_arg<K> const& key) const {
+    return const_cast<FlatMap*>(this)->template at<K>(key);
+  }
+
+  template<class K = key_type>
+  mapped_type& operator[](key_arg<K> const& key) {
+    return try_emplace<K>(key).first.value();
+  }
+  mapped_type& operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first.value();
+  }
+
+  template<class K = key_type, class ... Args>
+  std::pair<iterator, bool> try_emplace(key_arg<K> const& key, Args&& ... args) {
+    return try_emplace_impl(key, std::forward<Args>(args)...);
+  }
+  template<class ... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&& ... args) {
+    return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template<class K = key_type, class V>
+  std::pair<iterator, bool> insert_or_assign(key_arg<K> const& key, V&& value) {
+    auto result = try_emplace<K>(key, std::forward<V>(value));
+    if (!result.second) {
+      result.first.value() = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return try_emplace_impl(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return try_emplace_impl(std::move(value.first), std::move(value.second));
+  }
+  template<class ... Args>
+  std::pair<iterator, bool> emplace(Args&& ... args) {
+    value_type value(std::forward<Args>(args)...);
+    return insert(std::move(value));
+  }
+
+  /// Inserts a range of key/value pairs (in any order) with one sort and one merge pass.
+  /// As with single insertion, keys already present, or repeated in the range, keep their first value.
+  template<class TInputIterator>
+  void insert(TInputIterator first, TInputIterator last) {
+    SmallVector<value_type, InitialCapacity> incoming;
+    for (; first != last; ++first) {
+      incoming.emplace_back(*first);
+    }
+    std::stable_sort(incoming.begin(), incoming.end(), [this](value_type const& lhs, value_type const& rhs) {
+      return comp_(lhs.first, rhs.first);
+    });
+    merge_sorted(std::make_move_iterator(incoming.begin()), std::make_move_iterator(incoming.end()));
+  }
+  void insert(std::initializer_list<value_type> list) {
+    insert(list.begin(), list.end());
+  }
+
+  /// Inserts a range of key/value pairs already sorted by key, skipping the sort of `insert(first, last)`.
+  template<class TInputIterator>
+  void insert_sorted(TInputIterator first, TInputIterator last) {
+    merge_sorted(first, last);
+  }
+
+  /// Inserts the elements of `source` whose keys are not present yet, in a single linear pass.
+  template<size_t C2, class A2>
+  void merge(FlatMap<TKey, TValue, C2, TCompare, A2> const& source) {
+    merge_sorted(source.begin(), source.end());
+  }
+
+  iterator erase(const_iterator position) {
+    auto const index = position - cbegin();
+    keys_.erase(keys_.begin() + index);
+    values_.erase(values_.begin() + index);
+    return begin() + index;
+  }
+  iterator erase(iterator position) {
+    return erase(const_iterator(position));
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    auto const index = first - cbegin();
+    auto const count = last - first;
+    keys_.erase(keys_.begin() + index, keys_.begin() + index + count);
+    values_.erase(values_.begin() + index, values_.begin() + index + count);
+    return begin() + index;
+  }
+  template<class K = key_type>
+  size_type erase(key_arg<K> const& key) {
+    auto it = find<K>(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  void swap(FlatMap& rhs) noexcept {
+    std::swap(keys_, rhs.keys_);
+    std::swap(values_, rhs.values_);
+    std::swap(comp_, rhs.comp_);
+  }
+
+private:
+  template<class K>
+  [[nodiscard]] size_t key_index(K const& key) const {
+    return static_cast<size_t>(branchless_lower_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin());
+  }
+
+  template<class K, class ... Args>
+  std::pair<iterator, bool> try_emplace_impl(K&& key, Args&& ... args) {
+    size_t const index = key_index(key);
+    if (index != size() && !comp_(key, keys_[index])) {
+      return { begin() + index, false };
+    }
+    values_.emplace(values_.begin() + index, std::forward<Args>(args)...);
+    try {
+      keys_.emplace(keys_.begin() + index, std::forward<K>(key));
+    }
+    catch (...) {
+      values_.erase(values_.begin() + index);
+      throw;
+    }
+    return { begin() + index, true };
+  }
+
+  /// Merges a key-sorted range of pairs into the map; existing keys and the first of repeated keys win.
+  /// Strong exception guarantee: new elements are appended first, so a throw only has to truncate them again.
+  template<class TInputIterator>
+  void merge_sorted(TInputIterator first, TInputIterator last) {
+    size_t const old_size = size();
+    try {
+      size_t i = 0;
+      for (; first != last; ++first) {
+        decltype(auto) incoming = *first;
+        using incoming_type = decltype(incoming);
+        auto const& key = std::get<0>(incoming);
+        while (i != old_size && comp_(keys_[i], key)) {
+          ++i;
+        }
+        bool const present = i != old_size && !comp_(key, keys_[i]);
+        bool const repeated = keys_.size() != old_size && !comp_(keys_.back(), key);
+        if (present || repeated) {
+          continue;
+        }
+        // `std::get` on the forwarded pair copies from lvalues and moves from rvalues, and keeps reference members
+        // (e.g. of `FlatMap` iterators) as they are.
+        keys_.emplace_back(std::get<0>(std::forward<incoming_type>(incoming)));
+        try {
+          values_.emplace_back(std::get<1>(std::forward<incoming_type>(incoming)));
+        }
+        catch (...) {
+          keys_.pop_back();
+          throw;
+        }
+      }
+      // Appended elements are sorted among themselves; merge them in unless they all sort after the old ones.
+      if (old_size != 0 && size() != old_size && comp_(keys_[old_size], keys_[old_size - 1])) {
+        merge_runs(old_size);
+      }
+    }
+    catch (...) {
+      keys_.erase(keys_.begin() + old_size, keys_.end());
+      values_.erase(values_.begin() + old_size, values_.end());
+      throw;
+    }
+  }
+
+  /// Merges the sorted runs `[0, middle)` and `[middle, size())`, which share no keys. The members are only replaced
+  /// once nothing can throw any more: elements are moved if both types move without throwing, copied otherwise.
+  void merge_runs(size_t middle) {
+    size_t const count = size();
+    SmallVector<size_t, 1> order;
+    order.resize_default_init(count);
+    size_t lhs = 0;
+    size_t rhs = middle;
+    for (size_t out = 0; out != count; ++out) {
+      bool const take_rhs = rhs != count && (lhs == middle || comp_(keys_[rhs], keys_[lhs]));
+      order[out] = take_rhs ? rhs++ : lhs++;
+    }
+
+    constexpr bool kMove = std::is_nothrow_move_constructible_v<TKey> && std::is_nothrow_move_constructible_v<TValue>;
+    key_container_type keys(keys_.get_allocator());
+    mapped_container_type values(values_.get_allocator());
+    keys.reserve(count);
+    values.reserve(count);
+    for (size_t index : order) {
+      if constexpr (kMove) {
+        keys.emplace_back(std::move(keys_[index]));
+        values.emplace_back(std::move(values_[index]));
+      }
+      else {
+        keys.emplace_back(keys_[index]);
+        values.emplace_back(values_[index]);
+      }
+    }
+    std::swap(keys_, keys);
+    std::swap(values_, values);
+  }
+
+  key_container_type keys_;
+  mapped_container_type values_;
+  MBASE_NO_UNIQUE_ADDRESS TCompare comp_ {};
+};
+
+template<class TKey, class TValue, size_t C1, size_t C2, class TCompare, class A1, class A2>
+bool operator==(FlatMap<TKey, TValue, C1, TCompare, A1> const& lhs, FlatMap<TKey, TValue, C2, TCompare, A2> const& rhs) {
+  return std::ranges::equal(lhs.keys(), rhs.keys()) && std::ranges::equal(lhs.values(), rhs.values());
+}
+
+} // namespace mbase
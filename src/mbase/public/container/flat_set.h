@@ -0,0 +1,240 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+#include "mbase/public/algorithm/branchless_lower_bound.h"
+
+namespace mbase {
+
+/// Ordered set backed by a sorted `SmallVector`; the set counterpart of `FlatMap`.
+/// Use `insert(first, last)`, `insert_sorted` or `merge` to add many elements with a single sort and merge pass.
+/// Any insertion or erasure invalidates iterators.
+template<
+  class TKey,
+  size_t InitialCapacity = 8,
+  class TCompare = std::less<>,
+  class TAllocator = AlignedAllocator
+>
+class FlatSet final {
+public:
+  using key_type = TKey;
+  using value_type = TKey;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using key_compare = TCompare;
+  using value_compare = TCompare;
+  using allocator_type = TAllocator;
+  using container_type = SmallVector<TKey, InitialCapacity, std::max(alignof(TKey), sizeof(void*)), TAllocator>;
+  using iterator = TKey const*;
+  using const_iterator = TKey const*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  template<class K>
+  using key_arg = typename detail::KeyArg<is_transparent_v<TCompare>>::template type<K, key_type>;
+
+  FlatSet() = default;
+  explicit FlatSet(TCompare const& comp, TAllocator const& allocator = TAllocator()) :
+    keys_(allocator),
+    comp_(comp)
+  {
+  }
+  explicit FlatSet(TAllocator const& allocator) :
+    keys_(allocator)
+  {
+  }
+  template<class TInputIterator>
+  FlatSet(TInputIterator first, TInputIterator last, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    FlatSet(comp, allocator)
+  {
+    insert(first, last);
+  }
+  FlatSet(std::initializer_list<value_type> list, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    FlatSet(list.begin(), list.end(), comp, allocator)
+  {
+  }
+
+  const_iterator begin() const noexcept { return keys_.data(); }
+  const_iterator end() const noexcept { return keys_.data() + keys_.size(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  [[nodiscard]] bool empty() const noexcept { return keys_.empty(); }
+  [[nodiscard]] size_type size() const noexcept { return keys_.size(); }
+  [[nodiscard]] size_type capacity() const noexcept { return keys_.capacity(); }
+
+  [[nodiscard]] key_compare key_comp() const { return comp_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return keys_.get_allocator(); }
+
+  /// Sorted elements.
+  [[nodiscard]] ArrayProxy<TKey const> keys() const noexcept { return { keys_.data(), keys_.size() }; }
+
+  void clear() { keys_.clear(); }
+  void reserve(size_type new_capacity) { keys_.reserve(new_capacity); }
+  void shrink_to_fit() { keys_.shrink_to_fit(); }
+
+  template<class K = key_type>
+  [[nodiscard]] const_iterator lower_bound(key_arg<K> const& key) const {
+    return branchless_lower_bound(begin(), end(), key, comp_);
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator upper_bound(key_arg<K> const& key) const {
+    return branchless_upper_bound(begin(), end(), key, comp_);
+  }
+  template<class K = key_type>
+  [[nodiscard]] const_iterator find(key_arg<K> const& key) const {
+    auto it = lower_bound<K>(key);
+    return it != end() && !comp_(key, *it) ? it : end();
+  }
+  template<class K = key_type>
+  [[nodiscard]] bool contains(key_arg<K> const& key) const {
+    return find<K>(key) != end();
+  }
+  template<class K = key_type>
+  [[nodiscard]] size_type count(key_arg<K> const& key) const {
+    return contains<K>(key) ? 1 : 0;
+  }
+
+  std::pair<iterator, bool> insert(value_type const& value) {
+    return emplace_impl(value);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return emplace_impl(std::move(value));
+  }
+  template<class ... Args>
+  std::pair<iterator, bool> emplace(Args&& ... args) {
+    return emplace_impl(value_type(std::forward<Args>(args)...));
+  }
+
+  /// Inserts a range of elements (in any order) with one sort, one dedup and one merge pass.
+  template<class TInputIterator>
+  void insert(TInputIterator first, TInputIterator last) {
+    SmallVector<value_type, InitialCapacity> incoming(first, last);
+    std::sort(incoming.begin(), incoming.end(), comp_);
+    merge_sorted(std::make_move_iterator(incoming.begin()), std::make_move_iterator(incoming.end()));
+  }
+  void insert(std::initializer_list<value_type> list) {
+    insert(list.begin(), list.end());
+  }
+
+  /// Inserts a range of elements already sorted, skipping the sort of `insert(first, last)`.
+  template<class TInputIterator>
+  void insert_sorted(TInputIterator first, TInputIterator last) {
+    merge_sorted(first, last);
+  }
+
+  /// Inserts the elements of `source` not present yet, in a single linear pass.
+  template<size_t C2, class A2>
+  void merge(FlatSet<TKey, C2, TCompare, A2> const& source) {
+    merge_sorted(source.begin(), source.end());
+  }
+
+  iterator erase(const_iterator position) {
+    auto const index = position - begin();
+    keys_.erase(keys_.begin() + index);
+    return begin() + index;
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    auto const index = first - begin();
+    keys_.erase(keys_.begin() + index, keys_.begin() + (last - begin()));
+    return begin() + index;
+  }
+  template<class K = key_type>
+  size_type erase(key_arg<K> const& key) {
+    auto it = find<K>(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  void swap(FlatSet& rhs) noexcept {
+    std::swap(keys_, rhs.keys_);
+    std::swap(comp_, rhs.comp_);
+  }
+
+private:
+  template<class K>
+  std::pair<iterator, bool> emplace_impl(K&& key) {
+    auto const index = lower_bound(key) - begin();
+    if (index != difference_type(size()) && !comp_(key, keys_[index])) {
+      return { begin() + index, false };
+    }
+    keys_.emplace(keys_.begin() + index, std::forward<K>(key));
+    return { begin() + index, true };
+  }
+
+  /// Merges a sorted range into the set; repeated elements are dropped.
+  template<class TInputIterator>
+  void merge_sorted(TInputIterator first, TInputIterator last) {
+    if (first == last) {
+      return;
+    }
+
+    // Fast path: the whole range sorts after the current elements.
+    if (empty() || comp_(keys_.back(), *first)) {
+      for (; first != last; ++first) {
+        if (keys_.empty() || comp_(keys_.back(), *first)) {
+          keys_.emplace_back(*first);
+        }
+      }
+      return;
+    }
+
+    container_type keys(keys_.get_allocator());
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<TInputIterator>::iterator_category>) {
+      keys.reserve(size() + static_cast<size_t>(std::distance(first, last)));
+    }
+
+    auto push = [&](auto&& key) {
+      if (keys.empty() || comp_(keys.back(), key)) {
+        keys.emplace_back(std::forward<decltype(key)>(key));
+      }
+    };
+
+    size_t i = 0;
+    while (i != size() && first != last) {
+      if (comp_(*first, keys_[i])) {
+        push(*first);
+        ++first;
+      }
+      else {
+        push(std::move_if_noexcept(keys_[i]));
+        ++i;
+      }
+    }
+    for (; i != size(); ++i) {
+      push(std::move_if_noexcept(keys_[i]));
+    }
+    for (; first != last; ++first) {
+      push(*first);
+    }
+
+    keys_ = std::move(keys);
+  }
+
+  container_type keys_;
+  MBASE_NO_UNIQUE_ADDRESS TCompare comp_ {};
+};
+
+template<class TKey, size_t C1, size_t C2, class TCompare, class A1, class A2>
+bool operator==(FlatSet<TKey, C1, TCompare, A1> const& lhs, FlatSet<TKey, C2, TCompare, A2> const& rhs) {
+  return std::ranges::equal(lhs, rhs);
+}
+
+} // namespace mbase
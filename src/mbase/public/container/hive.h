@@ -0,0 +1,473 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/assert.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+/// Unordered container with O(1) insert and erase and stable element addresses, for object pools with heavy churn.
+/// Elements live in blocks of growing capacity. Erasing leaves a hole instead of moving anything:
+/// - Iteration skips holes with a jump-counting skip field: the first and last slot of each run of holes store its
+///   length, so `++` and `--` jump over a whole run in O(1).
+/// - Each block keeps a free list of its runs of holes; insertion reuses the first slot of a run before appending.
+/// - Blocks that become empty are kept for reuse until `trim_capacity`.
+/// Iterators and pointers stay valid until their own element is erased.
+template<class T, class TAllocator = AlignedAllocator>
+class Hive final {
+  static constexpr uint16_t kNone = 0xFFFF;
+  static constexpr size_t kMinBlockCapacity = 8;
+  static constexpr size_t kMaxBlockCapacity = 8192;
+
+  /// Free-list node, stored in the first slot of a run of holes.
+  struct FreeRun final {
+    uint16_t prev;
+    uint16_t next;
+  };
+
+  union Slot {
+    Slot() {}
+    ~Slot() {}
+
+    T value;
+    FreeRun run;
+  };
+
+  struct Block final {
+    Slot* slots;
+    /// `capacity + 1` entries; 0 for live and never-used slots.
+    uint16_t* skip;
+    size_t capacity;
+    /// Slots `[0, end)` have been used; the rest are free for appending.
+    size_t end;
+    size_t size;
+    Block* prev;
+    Block* next;
+    Block* prev_with_holes;
+    Block* next_with_holes;
+    uint16_t free_head;
+  };
+
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = T const&;
+  using pointer = T*;
+  using const_pointer = T const*;
+  using allocator_type = TAllocator;
+
+  template<bool IsConst>
+  class Iterator final {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, T const*, T*>;
+    using reference = std::conditional_t<IsConst, T const&, T&>;
+
+    Iterator() = default;
+    template<bool OtherIsConst, std::enable_if_t<IsConst && !OtherIsConst, int> = 0>
+    Iterator(Iterator<OtherIsConst> const& rhs) : block_(rhs.block_), index_(rhs.index_) {}
+
+    reference operator*() const noexcept { return block_->slots[index_].value; }
+    pointer operator->() const noexcept { return &block_->slots[index_].value; }
+
+    Iterator& operator++() noexcept {
+      ++index_;
+      if (index_ < block_->end) {
+        index_ += block_->skip[index_];
+      }
+      if (index_ == block_->end && block_->next != nullptr) {
+        block_ = block_->next;
+        index_ = block_->skip[0];
+      }
+      return *this;
+    }
+    Iterator operator++(int) noexcept { Iterator tmp = *this; ++*this; return tmp; }
+    Iterator& operator--() noexcept {
+      for (;;) {
+        if (index_ == 0) {
+          block_ = block_->prev;
+          index_ = block_->end;
+        }
+        --index_;
+        uint16_t const skip = block_->skip[index_];
+        if (skip == 0) {
+          return *this;
+        }
+        // `index_` ends a run of holes; continue from the slot before its start.
+        index_ = index_ + 1 - skip;
+      }
+    }
+    Iterator operator--(int) noexcept { Iterator tmp = *this; --*this; return tmp; }
+
+    friend bool operator==(Iterator const& lhs, Iterator const& rhs) noexcept {
+      return lhs.block_ == rhs.block_ && lhs.index_ == rhs.index_;
+    }
+
+  private:
+    friend class Hive;
+    template<bool> friend class Iterator;
+
+    Iterator(Block* block, size_t index) : block_(block), index_(index) {}
+
+    Block* block_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  Hive() = default;
+  explicit Hive(allocator_type const& allocator) : allocator_(allocator) {}
+  Hive(Hive const& rhs) :
+    allocator_(rhs.allocator_)
+  {
+    reserve(rhs.size_);
+    for (T const& value : rhs) {
+      emplace(value);
+    }
+  }
+  Hive(Hive&& rhs) noexcept :
+    head_(std::exchange(rhs.head_, nullptr)),
+    tail_(std::exchange(rhs.tail_, nullptr)),
+    with_holes_(std::exchange(rhs.with_holes_, nullptr)),
+    reserved_(std::exchange(rhs.reserved_, nullptr)),
+    size_(std::exchange(rhs.size_, 0)),
+    capacity_(std::exchange(rhs.capacity_, 0)),
+    allocator_(rhs.allocator_)
+  {
+  }
+  ~Hive() {
+    clear();
+    trim_capacity();
+  }
+
+  Hive& operator=(Hive const& rhs) {
+    if (this != &rhs) {
+      Hive tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+  Hive& operator=(Hive&& rhs) noexcept {
+    if (this != &rhs) {
+      Hive tmp(std::move(rhs));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  iterator begin() noexcept { return head_ ? iterator(head_, head_->skip[0]) : iterator(); }
+  const_iterator begin() const noexcept { return const_cast<Hive*>(this)->begin(); }
+  iterator end() noexcept { return tail_ ? iterator(tail_, tail_->end) : iterator(); }
+  const_iterator end() const noexcept { return const_cast<Hive*>(this)->end(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  /// Slots in all blocks, including reserved ones.
+  [[nodiscard]] size_type capacity() const noexcept { return capacity_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  /// Reuses a hole if there is one, otherwise appends to the last block or adds a block.
+  template<class ... Args>
+  iterator emplace(Args&& ... args) {
+    if (with_holes_ != nullptr) {
+      return emplace_into_hole(std::forward<Args>(args)...);
+    }
+    if (tail_ == nullptr || tail_->end == tail_->capacity) {
+      push_block(pop_reserved_or_allocate());
+    }
+    Block* block = tail_;
+    std::construct_at(&block->slots[block->end].value, std::forward<Args>(args)...);
+    ++block->size;
+    ++size_;
+    return iterator(block, block->end++);
+  }
+  iterator insert(T const& value) {
+    return emplace(value);
+  }
+  iterator insert(T&& value) {
+    return emplace(std::move(value));
+  }
+
+  /// Returns the iterator following `position`.
+  iterator erase(const_iterator position) {
+    Block* block = position.block_;
+    size_t const index = position.index_;
+    MBASE_ASSERT(block != nullptr && index < block->end && block->skip[index] == 0);
+
+    iterator next(block, index);
+    ++next;
+
+    std::destroy_at(&block->slots[index].value);
+    --size_;
+    if (--block->size == 0) {
+      recycle_block(block);
+      return next.block_ == block ? end() : next;
+    }
+    add_hole(block, index);
+    return next;
+  }
+  /// Erases the element at `element`, which must point into this hive.
+  void erase(const_pointer element) {
+    erase(get_iterator(element));
+  }
+
+  /// Iterator to the element at `element`. O(number of blocks).
+  [[nodiscard]] iterator get_iterator(const_pointer element) noexcept {
+    for (Block* block = head_; block != nullptr; block = block->next) {
+      Slot const* slot = reinterpret_cast<Slot const*>(element);
+      if (block->slots <= slot && slot < block->slots + block->end) {
+        return iterator(block, size_t(slot - block->slots));
+      }
+    }
+    MBASE_ASSERT_MSG(false, "Element does not belong to this Hive!");
+    return end();
+  }
+  [[nodiscard]] const_iterator get_iterator(const_pointer element) const noexcept {
+    return const_cast<Hive*>(this)->get_iterator(element);
+  }
+
+  /// Allocates reserved blocks until `new_capacity` elements fit.
+  void reserve(size_type new_capacity) {
+    while (capacity_ < new_capacity) {
+      Block* block = allocate_block(NextBlockCapacity(new_capacity - capacity_));
+      block->next = reserved_;
+      reserved_ = block;
+    }
+  }
+  /// Frees reserved blocks.
+  void trim_capacity() noexcept {
+    while (reserved_ != nullptr) {
+      Block* block = std::exchange(reserved_, reserved_->next);
+      deallocate_block(block);
+    }
+  }
+
+  /// Destroys all elements; blocks are kept in reserve.
+  void clear() noexcept {
+    while (head_ != nullptr) {
+      Block* block = head_;
+      if constexpr (!std::is_trivially_destructible_v<T>) {
+        for (iterator it(block, block->skip[0]); it.block_ == block && it.index_ != block->end; ++it) {
+          std::destroy_at(&*it);
+        }
+      }
+      size_ -= block->size;
+      block->size = 0;
+      recycle_block(block);
+    }
+  }
+
+  void swap(Hive& rhs) noexcept {
+    std::swap(head_, rhs.head_);
+    std::swap(tail_, rhs.tail_);
+    std::swap(with_holes_, rhs.with_holes_);
+    std::swap(reserved_, rhs.reserved_);
+    std::swap(size_, rhs.size_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(allocator_, rhs.allocator_);
+  }
+
+private:
+  static constexpr size_t kBlockAlignment = std::max({ alignof(Block), alignof(Slot), sizeof(void*) });
+
+  [[nodiscard]] static constexpr size_t AlignUp(size_t value) noexcept {
+    return (value + kBlockAlignment - 1) & ~(kBlockAlignment - 1);
+  }
+  [[nodiscard]] static constexpr size_t SkipOffset() noexcept {
+    return AlignUp(sizeof(Block));
+  }
+  [[nodiscard]] static constexpr size_t SlotsOffset(size_t capacity) noexcept {
+    return SkipOffset() + AlignUp(sizeof(uint16_t) * (capacity + 1));
+  }
+  [[nodiscard]] static constexpr size_t BlockBytes(size_t capacity) noexcept {
+    return SlotsOffset(capacity) + sizeof(Slot) * capacity;
+  }
+
+  /// Grows geometrically with the total capacity, within `[kMinBlockCapacity, kMaxBlockCapacity]`.
+  [[nodiscard]] size_t NextBlockCapacity(size_t wanted = 0) const noexcept {
+    return std::clamp(std::max(capacity_, wanted), kMinBlockCapacity, kMaxBlockCapacity);
+  }
+
+  [[nodiscard]] Block* allocate_block(size_t capacity) {
+    auto memory = static_cast<std::byte*>(allocator_.allocate(BlockBytes(capacity), kBlockAlignment));
+    Block* block = std::construct_at(reinterpret_cast<Block*>(memory));
+    block->skip = reinterpret_cast<uint16_t*>(memory + SkipOffset());
+    block->slots = reinterpret_cast<Slot*>(memory + SlotsOffset(capacity));
+    block->capacity = capacity;
+    capacity_ += capacity;
+    return block;
+  }
+  void deallocate_block(Block* block) noexcept {
+    capacity_ -= block->capacity;
+    allocator_.deallocate(block, BlockBytes(block->capacity), kBlockAlignment);
+  }
+
+  [[nodiscard]] Block* pop_reserved_or_allocate() {
+    if (reserved_ != nullptr) {
+      return std::exchange(reserved_, reserved_->next);
+    }
+    return allocate_block(NextBlockCapacity());
+  }
+
+  /// Appends an empty block to the iteration order.
+  void push_block(Block* block) noexcept {
+    std::fill_n(block->skip, block->capacity + 1, uint16_t(0));
+    block->end = 0;
+    block->size = 0;
+    block->free_head = kNone;
+    block->prev_with_holes = nullptr;
+    block->next_with_holes = nullptr;
+    block->next = nullptr;
+    block->prev = tail_;
+    if (tail_ != nullptr) {
+      tail_->next = block;
+    }
+    else {
+      head_ = block;
+    }
+    tail_ = block;
+  }
+
+  /// Moves an empty block from the iteration order to the reserve.
+  void recycle_block(Block* block) noexcept {
+    if (block->free_head != kNone) {
+      unlink_with_holes(block);
+    }
+    (block->prev ? block->prev->next : head_) = block->next;
+    (block->next ? block->next->prev : tail_) = block->prev;
+    block->next = reserved_;
+    reserved_ = block;
+  }
+
+  void link_with_holes(Block* block) noexcept {
+    block->prev_with_holes = nullptr;
+    block->next_with_holes = with_holes_;
+    if (with_holes_ != nullptr) {
+      with_holes_->prev_with_holes = block;
+    }
+    with_holes_ = block;
+  }
+  void unlink_with_holes(Block* block) noexcept {
+    (block->prev_with_holes ? block->prev_with_holes->next_with_holes : with_holes_) = block->next_with_holes;
+    if (block->next_with_holes != nullptr) {
+      block->next_with_holes->prev_with_holes = block->prev_with_holes;
+    }
+  }
+
+  /// Points the neighbours of the free run node `run` at `index`.
+  static void RelinkRun(Block* block, FreeRun const& run, uint16_t index) noexcept {
+    (run.prev != kNone ? block->slots[run.prev].run.next : block->free_head) = index;
+    if (run.next != kNone) {
+      block->slots[run.next].run.prev = index;
+    }
+  }
+  static void UnlinkRun(Block* block, FreeRun const& run) noexcept {
+    (run.prev != kNone ? block->slots[run.prev].run.next : block->free_head) = run.next;
+    if (run.next != kNone) {
+      block->slots[run.next].run.prev = run.prev;
+    }
+  }
+
+  template<class ... Args>
+  iterator emplace_into_hole(Args&& ... args) {
+    Block* block = with_holes_;
+    uint16_t const index = block->free_head;
+    FreeRun const run = block->slots[index].run;
+    uint16_t const length = block->skip[index];
+
+    try {
+      std::construct_at(&block->slots[index].value, std::forward<Args>(args)...);
+    }
+    catch (...) {
+      block->slots[index].run = run;
+      throw;
+    }
+
+    block->skip[index] = 0;
+    if (length == 1) {
+      UnlinkRun(block, run);
+      if (block->free_head == kNone) {
+        unlink_with_holes(block);
+      }
+    }
+    else {
+      // The run now starts one slot later.
+      uint16_t const start = uint16_t(index + 1);
+      block->skip[start] = uint16_t(length - 1);
+      block->skip[index + length - 1] = uint16_t(length - 1);
+      block->slots[start].run = run;
+      RelinkRun(block, run, start);
+    }
+    ++block->size;
+    ++size_;
+    return iterator(block, index);
+  }
+
+  /// Marks slot `index` as a hole, merging it with adjacent runs of holes.
+  void add_hole(Block* block, size_t index) noexcept {
+    uint16_t* skip = block->skip;
+    size_t const left = index > 0 ? skip[index - 1] : 0;
+    size_t const right = index + 1 < block->end ? skip[index + 1] : 0;
+
+    if (left == 0 && right == 0) {
+      skip[index] = 1;
+      bool const had_holes = block->free_head != kNone;
+      block->slots[index].run = FreeRun { kNone, block->free_head };
+      if (had_holes) {
+        block->slots[block->free_head].run.prev = uint16_t(index);
+      }
+      block->free_head = uint16_t(index);
+      if (!had_holes) {
+        link_with_holes(block);
+      }
+    }
+    else if (right == 0) {
+      // Extend the run on the left; its node stays at its start.
+      size_t const start = index - left;
+      skip[start] = skip[index] = uint16_t(left + 1);
+    }
+    else if (left == 0) {
+      // Prepend to the run on the right; its node moves to `index`.
+      FreeRun const run = block->slots[index + 1].run;
+      skip[index] = skip[index + right] = uint16_t(right + 1);
+      block->slots[index].run = run;
+      RelinkRun(block, run, uint16_t(index));
+    }
+    else {
+      // Join both runs; the right one's node goes away.
+      size_t const start = index - left;
+      UnlinkRun(block, block->slots[index + 1].run);
+      skip[start] = skip[index + right] = uint16_t(left + right + 1);
+    }
+  }
+
+  Block* head_ = nullptr;
+  Block* tail_ = nullptr;
+  /// Blocks whose free list is not empty.
+  Block* with_holes_ = nullptr;
+  /// Empty blocks, singly linked through `next`.
+  Block* reserved_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS allocator_type allocator_ {};
+};
+
+} // namespace mbase
@@ -0,0 +1,433 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/platform.h"
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/hash.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+
+// conditional platform headers -------------------------
+#if MBASE_PLATFORM_SSE2
+# include <emmintrin.h>
+#elif MBASE_PLATFORM_NEON
+# include <arm_neon.h>
+#endif
+
+namespace mbase {
+
+namespace detail::hll {
+
+/// `dst[i] = max(dst[i], src[i])` for `count` registers, 16 per iteration on SSE2/NEON.
+inline void MaxRegisters(uint8_t* dst, uint8_t const* src, size_t count) noexcept {
+  size_t i = 0;
+#if MBASE_PLATFORM_SSE2
+  for (; i + 16 <= count; i += 16) {
+    auto d = reinterpret_cast<__m128i*>(dst + i);
+    _mm_storeu_si128(d, _mm_max_epu8(_mm_loadu_si128(d), _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i))));
+  }
+#elif MBASE_PLATFORM_NEON
+  for (; i + 16 <= count; i += 16) {
+    vst1q_u8(dst + i, vmaxq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+  }
+#endif
+  for (; i != count; ++i) {
+    dst[i] = std::max(dst[i], src[i]);
+  }
+}
+
+/// Little-endian base-128 varints for the sparse serialized form.
+class ByteWriter final {
+public:
+  explicit ByteWriter(std::byte* out) : out_(out) {}
+
+  void Byte(uint8_t value) {
+    if (out_ != nullptr) {
+      out_[size_] = std::byte(value);
+    }
+    ++size_;
+  }
+  void Varint(uint64_t value) {
+    for (; value >= 0x80; value >>= 7) {
+      Byte(uint8_t(value | 0x80));
+    }
+    Byte(uint8_t(value));
+  }
+
+  [[nodiscard]] size_t Size() const noexcept { return size_; }
+
+private:
+  std::byte* out_ = nullptr;
+  size_t size_ = 0;
+};
+
+class ByteReader final {
+public:
+  explicit ByteReader(ArrayProxy<std::byte const> bytes) : bytes_(bytes) {}
+
+  uint8_t Byte() {
+    if (position_ == bytes_.size()) {
+      throw std::invalid_argument("HyperLogLog serialized data is truncated!");
+    }
+    return uint8_t(bytes_[position_++]);
+  }
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      uint8_t const byte = Byte();
+      value |= uint64_t(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw std::invalid_argument("HyperLogLog serialized varint is too long!");
+  }
+
+  [[nodiscard]] bool AtEnd() const noexcept { return position_ == bytes_.size(); }
+
+private:
+  ArrayProxy<std::byte const> bytes_;
+  size_t position_ = 0;
+};
+
+} // namespace detail::hll
+
+/// HyperLogLog distinct-count sketch with `2^precision` 6-bit registers and a relative standard error of about
+/// `1.04 / sqrt(2^precision)`.
+/// Starts sparse: hashes are kept as (25-bit index, rank) pairs, which estimates small cardinalities almost exactly,
+/// until those take more memory than the dense registers. Estimates use Ertl's improved raw estimator, which needs no
+/// empirical bias tables.
+/// Sketches with the same precision and hasher merge losslessly, e.g. per-thread sketches into one.
+/// `THash` maps keys to 64-bit hashes (`Hash64`, i.e. `Hasher64`, by default). Const member functions may be called
+/// concurrently.
+template<class THash = Hash64, class TAllocator = AlignedAllocator>
+class HyperLogLog final {
+public:
+  using hasher = THash;
+  using allocator_type = TAllocator;
+
+  static constexpr uint32_t kMinPrecision = 4;
+  static constexpr uint32_t kMaxPrecision = 18;
+  static constexpr uint32_t kSparsePrecision = 25;
+
+  explicit HyperLogLog(uint32_t precision = 14, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) :
+    precision_(precision),
+    sparse_(allocator),
+    registers_(allocator),
+    hash_(hash)
+  {
+    if (precision < kMinPrecision || precision > kMaxPrecision) {
+      throw std::out_of_range("HyperLogLog precision out of range!");
+    }
+  }
+
+  [[nodiscard]] uint32_t precision() const noexcept { return precision_; }
+  [[nodiscard]] size_t register_count() const noexcept { return size_t(1) << precision_; }
+  [[nodiscard]] bool is_sparse() const noexcept { return registers_.empty(); }
+  [[nodiscard]] hasher hash_function() const { return hash_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return registers_.get_allocator(); }
+
+  template<class K>
+  void insert(K const& key) {
+    insert_hash(hash_(key));
+  }
+  void insert_hash(uint64_t hash) {
+    if (!is_sparse()) {
+      uint8_t& reg = registers_[size_t(hash >> (64 - precision_))];
+      reg = std::max(reg, Rank(hash, precision_));
+      return;
+    }
+    sparse_.push_back(SparseEntry(hash));
+    if (sparse_.size() - sorted_size_ >= kSparseBufferSize) {
+      FlushSparse();
+    }
+  }
+
+  /// Estimated number of distinct keys inserted.
+  [[nodiscard]] double estimate() const {
+    if (is_sparse()) {
+      if (sorted_size_ != sparse_.size()) {
+        HyperLogLog flushed(*this);
+        flushed.FlushSparse();
+        return flushed.estimate();
+      }
+      // Linear counting over the 2^25 sparse indices.
+      double const m = double(uint64_t(1) << kSparsePrecision);
+      return m * std::log(m / (m - double(sparse_.size())));
+    }
+
+    // Ertl, "New cardinality estimation algorithms for HyperLogLog sketches" (2017), improved raw estimator.
+    uint32_t const q = 64 - precision_;
+    size_t histogram[64 + 2] = {};
+    for (uint8_t reg : registers_) {
+      ++histogram[reg];
+    }
+    double const m = double(register_count());
+    if (histogram[0] == register_count()) {
+      return 0.0;
+    }
+    double z = m * Tau(1.0 - double(histogram[q + 1]) / m);
+    for (uint32_t k = q; k >= 1; --k) {
+      z = 0.5 * (z + double(histogram[k]));
+    }
+    z += m * Sigma(double(histogram[0]) / m);
+    return m * m / (2.0 * std::log(2.0) * z);
+  }
+
+  /// Adds every key of `rhs`, which must have the same precision and hasher.
+  void merge(HyperLogLog const& rhs) {
+    MBASE_ASSERT_MSG(precision_ == rhs.precision_, "HyperLogLog precisions differ!");
+    if (rhs.is_sparse()) {
+      if (is_sparse()) {
+        sparse_.insert(sparse_.end(), rhs.sparse_.begin(), rhs.sparse_.end());
+        FlushSparse();
+      }
+      else {
+        for (uint32_t entry : rhs.sparse_) {
+          ApplySparseEntry(entry);
+        }
+      }
+      return;
+    }
+    if (is_sparse()) {
+      ToDense();
+    }
+    detail::hll::MaxRegisters(registers_.data(), rhs.registers_.data(), registers_.size());
+  }
+
+  void clear() noexcept {
+    sparse_.clear();
+    sorted_size_ = 0;
+    registers_.clear();
+  }
+
+  void swap(HyperLogLog& rhs) noexcept {
+    std::swap(precision_, rhs.precision_);
+    std::swap(sparse_, rhs.sparse_);
+    std::swap(sorted_size_, rhs.sorted_size_);
+    std::swap(registers_, rhs.registers_);
+    std::swap(hash_, rhs.hash_);
+  }
+
+  /// Bytes written by `serialize`.
+  [[nodiscard]] size_t serialized_size() const {
+    return Serialize(nullptr);
+  }
+  /// Writes the sketch in a compact, byte-order independent form: sparse entries as varint deltas, dense registers
+  /// packed 4 to 3 bytes. `out` must hold at least `serialized_size()` bytes.
+  size_t serialize(ArrayProxy<std::byte> out) const {
+    MBASE_ASSERT_MSG(out.size() >= serialized_size(), "HyperLogLog serialization buffer is too small!");
+    return Serialize(out.data());
+  }
+  /// Restores a sketch written by `serialize`; throws `std::invalid_argument` on malformed data.
+  [[nodiscard]] static HyperLogLog Deserialize(ArrayProxy<std::byte const> bytes, THash const& hash = THash(), TAllocator const& allocator = TAllocator()) {
+    detail::hll::ByteReader reader(bytes);
+    uint8_t const kind = reader.Byte();
+    uint8_t const precision = reader.Byte();
+    if (precision < kMinPrecision || precision > kMaxPrecision) {
+      throw std::invalid_argument("HyperLogLog serialized precision is invalid!");
+    }
+    HyperLogLog result(precision, hash, allocator);
+    if (kind == kSparseKind) {
+      uint64_t const count = reader.Varint();
+      if (count > result.SparseLimit()) {
+        throw std::invalid_argument("HyperLogLog serialized sparse entry count is invalid!");
+      }
+      result.sparse_.reserve(size_t(count));
+      uint64_t entry = 0;
+      for (uint64_t i = 0; i != count; ++i) {
+        uint64_t const previous = entry;
+        entry += reader.Varint();
+        // Entries are sorted by index, each index at most once; a wrapped sum lands at or below `previous`.
+        if (entry > std::numeric_limits<uint32_t>::max()
+          || (i != 0 && SparseIndex(uint32_t(entry)) <= SparseIndex(uint32_t(previous)))
+          || SparseIndex(uint32_t(entry)) >> kSparsePrecision != 0
+          || (entry & kRankMask) == 0 || (entry & kRankMask) > 64 - kSparsePrecision + 1) {
+          throw std::invalid_argument("HyperLogLog serialized sparse entry is invalid!");
+        }
+        result.sparse_.push_back(uint32_t(entry));
+      }
+      result.sorted_size_ = result.sparse_.size();
+    }
+    else if (kind == kDenseKind) {
+      result.registers_.resize(result.register_count(), uint8_t(0));
+      for (size_t i = 0; i != result.registers_.size(); i += 4) {
+        uint32_t packed = reader.Byte();
+        packed |= uint32_t(reader.Byte()) << 8;
+        packed |= uint32_t(reader.Byte()) << 16;
+        for (size_t j = 0; j != 4; ++j) {
+          uint8_t const reg = uint8_t((packed >> (j * 6)) & 0x3F);
+          if (reg > 64 - precision + 1) {
+            throw std::invalid_argument("HyperLogLog serialized register is invalid!");
+          }
+          result.registers_[i + j] = reg;
+        }
+      }
+    }
+    else {
+      throw std::invalid_argument("HyperLogLog serialized kind is invalid!");
+    }
+    if (!reader.AtEnd()) {
+      throw std::invalid_argument("HyperLogLog serialized data has trailing bytes!");
+    }
+    return result;
+  }
+
+  /// Relative standard error of the estimate for `precision`.
+  [[nodiscard]] static double RelativeError(uint32_t precision) {
+    return 1.04 / std::sqrt(double(uint64_t(1) << precision));
+  }
+
+private:
+  static constexpr uint8_t kSparseKind = 1;
+  static constexpr uint8_t kDenseKind = 2;
+  static constexpr uint32_t kRankBits = 6;
+  static constexpr uint32_t kRankMask = (1u << kRankBits) - 1;
+  /// Unsorted sparse entries collected before they are sorted into the rest.
+  static constexpr size_t kSparseBufferSize = 512;
+
+  /// 1 + leading zeros of the hash bits after the first `index_bits`.
+  [[nodiscard]] static uint8_t Rank(uint64_t hash, uint32_t index_bits) noexcept {
+    // The guard bit bounds the rank at `65 - index_bits`.
+    return uint8_t(std::countl_zero((hash << index_bits) | (uint64_t(1) << (index_bits - 1))) + 1);
+  }
+  /// `index << 6 | rank` at the sparse precision; sorting entries sorts by index, then rank.
+  [[nodiscard]] static uint32_t SparseEntry(uint64_t hash) noexcept {
+    return uint32_t(hash >> (64 - kSparsePrecision)) << kRankBits | Rank(hash, kSparsePrecision);
+  }
+  [[nodiscard]] static uint32_t SparseIndex(uint32_t entry) noexcept {
+    return entry >> kRankBits;
+  }
+
+  /// Sparse entries beyond which the dense registers are smaller.
+  [[nodiscard]] size_t SparseLimit() const noexcept {
+    return register_count() / sizeof(uint32_t);
+  }
+
+  /// Sorts the unsorted tail into the sorted entries, keeping the highest rank per index.
+  void FlushSparse() {
+    std::sort(sparse_.begin() + sorted_size_, sparse_.end());
+    std::inplace_merge(sparse_.begin(), sparse_.begin() + sorted_size_, sparse_.end());
+    size_t kept = 0;
+    for (size_t i = 0; i != sparse_.size(); ++i) {
+      if (i + 1 != sparse_.size() && SparseIndex(sparse_[i]) == SparseIndex(sparse_[i + 1])) {
+        continue;
+      }
+      sparse_[kept++] = sparse_[i];
+    }
+    sparse_.resize(kept);
+    sorted_size_ = kept;
+    if (sorted_size_ > SparseLimit()) {
+      ToDense();
+    }
+  }
+
+  void ApplySparseEntry(uint32_t entry) noexcept {
+    uint32_t const sparse_index = SparseIndex(entry);
+    uint32_t const extra_bits = kSparsePrecision - precision_;
+    uint32_t const extra = sparse_index & ((1u << extra_bits) - 1);
+    // The hash bits between the dense and the sparse index decide the rank unless they are all zero.
+    uint8_t const rank = extra != 0
+      ? uint8_t(std::countl_zero(extra) - (32 - extra_bits) + 1)
+      : uint8_t(extra_bits + (entry & kRankMask));
+    uint8_t& reg = registers_[sparse_index >> extra_bits];
+    reg = std::max(reg, rank);
+  }
+
+  void ToDense() {
+    registers_.resize(register_count(), uint8_t(0));
+    for (uint32_t entry : sparse_) {
+      ApplySparseEntry(entry);
+    }
+    sparse_.clear();
+    sparse_.shrink_to_fit();
+    sorted_size_ = 0;
+  }
+
+  size_t Serialize(std::byte* out) const {
+    detail::hll::ByteWriter writer(out);
+    if (is_sparse()) {
+      if (sorted_size_ != sparse_.size()) {
+        HyperLogLog flushed(*this);
+        flushed.FlushSparse();
+        return flushed.Serialize(out);
+      }
+      writer.Byte(kSparseKind);
+      writer.Byte(uint8_t(precision_));
+      writer.Varint(sparse_.size());
+      uint32_t previous = 0;
+      for (uint32_t entry : sparse_) {
+        writer.Varint(entry - previous);
+        previous = entry;
+      }
+    }
+    else {
+      writer.Byte(kDenseKind);
+      writer.Byte(uint8_t(precision_));
+      for (size_t i = 0; i != registers_.size(); i += 4) {
+        uint32_t const packed = uint32_t(registers_[i]) | uint32_t(registers_[i + 1]) << 6
+          | uint32_t(registers_[i + 2]) << 12 | uint32_t(registers_[i + 3]) << 18;
+        writer.Byte(uint8_t(packed));
+        writer.Byte(uint8_t(packed >> 8));
+        writer.Byte(uint8_t(packed >> 16));
+      }
+    }
+    return writer.Size();
+  }
+
+  [[nodiscard]] static double Sigma(double x) noexcept {
+    if (x == 1.0) {
+      return std::numeric_limits<double>::infinity();
+    }
+    double y = 1.0;
+    double z = x;
+    for (;;) {
+      x *= x;
+      double const previous = z;
+      z += x * y;
+      y += y;
+      if (z == previous) {
+        return z;
+      }
+    }
+  }
+  [[nodiscard]] static double Tau(double x) noexcept {
+    if (x == 0.0 || x == 1.0) {
+      return 0.0;
+    }
+    double y = 1.0;
+    double z = 1.0 - x;
+    for (;;) {
+      x = std::sqrt(x);
+      double const previous = z;
+      y *= 0.5;
+      z -= (1.0 - x) * (1.0 - x) * y;
+      if (z == previous) {
+        return z / 3.0;
+      }
+    }
+  }
+
+  uint32_t precision_ = 14;
+  /// Sparse entries: `sorted_size_` sorted ones with unique indices, then unsorted ones. Empty once dense.
+  SmallVector<uint32_t, 1, alignof(uint32_t), TAllocator> sparse_;
+  size_t sorted_size_ = 0;
+  /// Dense registers; empty while sparse.
+  SmallVector<uint8_t, 16, 16, TAllocator> registers_;
+  MBASE_NO_UNIQUE_ADDRESS THash hash_ {};
+};
+
+} // namespace mbase
@@ -0,0 +1,342 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_safety.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+/// Priority queue over a d-ary heap (`Arity` children per node) that hands out `TypesafeHandle`s to its elements, so
+/// that queued elements can be updated or erased in O(log n) instead of being pushed again and filtered out on pop.
+/// Like `std::priority_queue`, `top()` is the greatest element under `TCompare`; use `std::greater<>` for a min-heap.
+/// A wider heap is shallower and compares siblings that share a cache line: cheaper pushes and updates towards the
+/// top, slightly more comparisons per pop.
+/// Handles pack a slot index and a generation as in `SlotMap`, so handles to popped or erased elements are detected.
+/// `THandle::Invalid()` is never handed out.
+template<
+  class TValue,
+  class THandle,
+  class TCompare = std::less<>,
+  size_t Arity = 4,
+  size_t IndexBits = sizeof(typename THandle::StorageType) * 8 / 2,
+  size_t InitialCapacity = 8,
+  class TAllocator = AlignedAllocator
+>
+class IndexedHeap final {
+public:
+  using value_type = TValue;
+  using handle_type = THandle;
+  using value_compare = TCompare;
+  using size_type = size_t;
+  using allocator_type = TAllocator;
+
+private:
+  using StorageType = typename THandle::StorageType;
+
+  static_assert(Arity >= 2);
+  static_assert(std::is_nothrow_move_constructible_v<TValue> && std::is_nothrow_move_assignable_v<TValue>);
+  static_assert(std::is_unsigned_v<StorageType>);
+  static_assert(0 < IndexBits && IndexBits < sizeof(StorageType) * 8);
+
+  static constexpr size_t kGenerationBits = sizeof(StorageType) * 8 - IndexBits;
+  static constexpr StorageType kIndexMask = StorageType(~StorageType(0)) >> kGenerationBits;
+  static constexpr StorageType kGenerationMask = StorageType(~StorageType(0)) >> IndexBits;
+  static constexpr StorageType kInvalidValue = THandle::Invalid().Get();
+  static constexpr StorageType kNoFreeSlot = std::numeric_limits<StorageType>::max();
+
+  /// A heap entry and the slot tracking its position.
+  struct Node final {
+    TValue value;
+    StorageType slot;
+  };
+  /// Live: `position` is the node's heap index. Free: `position` holds the next free slot.
+  struct Slot final {
+    StorageType position;
+    StorageType generation;
+  };
+
+  template<class T>
+  using Vector = SmallVector<T, InitialCapacity, std::max(alignof(T), sizeof(void*)), TAllocator>;
+
+public:
+  IndexedHeap() = default;
+  explicit IndexedHeap(TCompare const& comp, allocator_type const& allocator = allocator_type()) :
+    nodes_(allocator),
+    slots_(allocator),
+    comp_(comp)
+  {
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return nodes_.empty(); }
+  [[nodiscard]] size_type size() const noexcept { return nodes_.size(); }
+  [[nodiscard]] static constexpr size_type max_size() noexcept { return size_type(kIndexMask) + 1; }
+  [[nodiscard]] value_compare value_comp() const { return comp_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return nodes_.get_allocator(); }
+
+  void reserve(size_type new_capacity) {
+    nodes_.reserve(new_capacity);
+    slots_.reserve(new_capacity);
+  }
+
+  /// Destroys all elements and invalidates all outstanding handles; slots are kept for reuse.
+  void clear() {
+    for (Node const& node : nodes_) {
+      release_slot(node.slot);
+    }
+    nodes_.clear();
+  }
+
+  [[nodiscard]] TValue const& top() const noexcept {
+    MBASE_ASSERT(!empty());
+    return nodes_.front().value;
+  }
+  [[nodiscard]] THandle top_handle() const noexcept {
+    MBASE_ASSERT(!empty());
+    return handle_of(nodes_.front().slot);
+  }
+
+  template<class ... Args>
+  THandle emplace(Args&& ... args) {
+    StorageType const slot_index = acquire_slot();
+    try {
+      nodes_.push_back(Node { TValue(std::forward<Args>(args)...), slot_index });
+    }
+    catch (...) {
+      free_slot(slot_index);
+      throw;
+    }
+    sift_up(nodes_.size() - 1);
+    return handle_of(slot_index);
+  }
+  THandle push(TValue const& value) {
+    return emplace(value);
+  }
+  THandle push(TValue&& value) {
+    return emplace(std::move(value));
+  }
+
+  /// Pushes `values`, writing the handle of `values[i]` to `handles[i]`. Large batches are heapified bottom-up in
+  /// linear time instead of being sifted up one by one.
+  void push_bulk(ArrayProxy<TValue const> values, ArrayProxy<THandle> handles) {
+    MBASE_ASSERT(values.size() == handles.size());
+    size_t const old_size = nodes_.size();
+    reserve(old_size + values.size());
+    try {
+      for (size_t i = 0; i != values.size(); ++i) {
+        StorageType const slot_index = acquire_slot();
+        try {
+          nodes_.push_back(Node { values[i], slot_index });
+        }
+        catch (...) {
+          free_slot(slot_index);
+          throw;
+        }
+        slots_[slot_index].position = StorageType(nodes_.size() - 1);
+        handles[i] = handle_of(slot_index);
+      }
+    }
+    catch (...) {
+      while (nodes_.size() != old_size) {
+        release_slot(nodes_.back().slot);
+        nodes_.pop_back();
+      }
+      throw;
+    }
+    // Sifting each up costs O(k log n); heapifying everything costs O(n).
+    if (values.size() > old_size / 4) {
+      if (nodes_.size() > 1) {
+        for (size_t i = (nodes_.size() - 2) / Arity + 1; i-- != 0;) {
+          sift_down(i);
+        }
+      }
+    }
+    else {
+      for (size_t i = old_size; i != nodes_.size(); ++i) {
+        sift_up(i);
+      }
+    }
+  }
+
+  void pop() noexcept {
+    MBASE_ASSERT(!empty());
+    erase_at(0);
+  }
+  /// Removes and returns the top element.
+  TValue pop_value() noexcept {
+    MBASE_ASSERT(!empty());
+    TValue value = std::move(nodes_.front().value);
+    erase_at(0);
+    return value;
+  }
+
+  /// Returns `false` if `handle` is stale or invalid.
+  bool erase(THandle const& handle) noexcept {
+    if (!is_live(handle)) {
+      return false;
+    }
+    erase_at(slots_[handle.Get() & kIndexMask].position);
+    return true;
+  }
+
+  /// Replaces the element and restores heap order; returns `false` if `handle` is stale or invalid.
+  /// Covers decrease-key and increase-key.
+  template<class V>
+  bool update(THandle const& handle, V&& value) {
+    if (!is_live(handle)) {
+      return false;
+    }
+    size_t const position = slots_[handle.Get() & kIndexMask].position;
+    nodes_[position].value = std::forward<V>(value);
+    restore_at(position);
+    return true;
+  }
+
+  [[nodiscard]] bool contains(THandle const& handle) const noexcept {
+    return is_live(handle);
+  }
+  /// Returns `nullptr` if `handle` is stale or invalid. Modify elements only through `update`.
+  [[nodiscard]] TValue const* get(THandle const& handle) const noexcept {
+    return is_live(handle) ? &nodes_[slots_[handle.Get() & kIndexMask].position].value : nullptr;
+  }
+  [[nodiscard]] TValue const& at(THandle const& handle) const {
+    TValue const* value = get(handle);
+    if (value == nullptr) {
+      throw std::out_of_range("IndexedHeap::at");
+    }
+    return *value;
+  }
+
+private:
+  [[nodiscard]] static constexpr StorageType Pack(StorageType slot_index, StorageType generation) noexcept {
+    return StorageType(generation << IndexBits) | slot_index;
+  }
+  /// Next generation of the slot at `slot_index`, skipping the one that would pack into `THandle::Invalid()`.
+  [[nodiscard]] static constexpr StorageType NextGeneration(StorageType slot_index, StorageType generation) noexcept {
+    generation = (generation + 1) & kGenerationMask;
+    if (Pack(slot_index, generation) == kInvalidValue) {
+      generation = (generation + 1) & kGenerationMask;
+    }
+    return generation;
+  }
+
+  [[nodiscard]] THandle handle_of(StorageType slot_index) const noexcept {
+    return THandle(Pack(slot_index, slots_[slot_index].generation));
+  }
+  [[nodiscard]] bool is_live(THandle const& handle) const noexcept {
+    StorageType const slot_index = handle.Get() & kIndexMask;
+    StorageType const generation = handle.Get() >> IndexBits;
+    return handle.IsValid() && slot_index < slots_.size() && slots_[slot_index].generation == generation;
+  }
+
+  StorageType acquire_slot() {
+    if (free_head_ != kNoFreeSlot) {
+      StorageType const slot_index = free_head_;
+      free_head_ = slots_[slot_index].position;
+      return slot_index;
+    }
+    if (slots_.size() == max_size()) {
+      throw std::length_error("IndexedHeap: out of slot indices");
+    }
+    StorageType const slot_index = StorageType(slots_.size());
+    StorageType const generation = Pack(slot_index, 0) == kInvalidValue ? 1 : 0;
+    slots_.push_back(Slot { 0, generation });
+    return slot_index;
+  }
+  /// Returns a slot to the free list without touching its generation; for slots that never handed out a handle.
+  void free_slot(StorageType slot_index) noexcept {
+    slots_[slot_index].position = free_head_;
+    free_head_ = slot_index;
+  }
+  /// Invalidates handles to the slot and returns it to the free list.
+  void release_slot(StorageType slot_index) noexcept {
+    Slot& slot = slots_[slot_index];
+    slot.generation = NextGeneration(slot_index, slot.generation);
+    free_slot(slot_index);
+  }
+
+  /// Moves `node` to `position` and records it in its slot.
+  void place(size_t position, Node&& node) noexcept {
+    slots_[node.slot].position = StorageType(position);
+    nodes_[position] = std::move(node);
+  }
+
+  /// Moves the node at `position` towards the root past lesser parents, shifting them down into the hole.
+  void sift_up(size_t position) noexcept {
+    Node node = std::move(nodes_[position]);
+    while (position != 0) {
+      size_t const parent = (position - 1) / Arity;
+      if (!comp_(nodes_[parent].value, node.value)) {
+        break;
+      }
+      place(position, std::move(nodes_[parent]));
+      position = parent;
+    }
+    place(position, std::move(node));
+  }
+  /// Moves the node at `position` towards the leaves past greater children, shifting them up into the hole.
+  void sift_down(size_t position) noexcept {
+    size_t const size = nodes_.size();
+    Node node = std::move(nodes_[position]);
+    for (;;) {
+      size_t const first_child = position * Arity + 1;
+      if (first_child >= size) {
+        break;
+      }
+      size_t const last_child = std::min(first_child + Arity, size);
+      size_t best = first_child;
+      for (size_t child = first_child + 1; child < last_child; ++child) {
+        best = comp_(nodes_[best].value, nodes_[child].value) ? child : best;
+      }
+      if (!comp_(node.value, nodes_[best].value)) {
+        break;
+      }
+      place(position, std::move(nodes_[best]));
+      position = best;
+    }
+    place(position, std::move(node));
+  }
+  void restore_at(size_t position) noexcept {
+    if (position != 0 && comp_(nodes_[(position - 1) / Arity].value, nodes_[position].value)) {
+      sift_up(position);
+    }
+    else {
+      sift_down(position);
+    }
+  }
+
+  /// Fills the hole at `position` with the last node and restores heap order around it.
+  void erase_at(size_t position) noexcept {
+    release_slot(nodes_[position].slot);
+    size_t const last = nodes_.size() - 1;
+    if (position != last) {
+      place(position, std::move(nodes_[last]));
+      nodes_.pop_back();
+      restore_at(position);
+    }
+    else {
+      nodes_.pop_back();
+    }
+  }
+
+  Vector<Node> nodes_;
+  Vector<Slot> slots_;
+  StorageType free_head_ = kNoFreeSlot;
+  MBASE_NO_UNIQUE_ADDRESS TCompare comp_ {};
+};
+
+} // namespace mbase
@@ -0,0 +1,245 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_safety.h"
+
+namespace mbase {
+
+/// Container handing out `TypesafeHandle`s to its elements.
+/// A handle packs a slot index (the low `IndexBits` bits) and the slot's generation (the remaining bits). Resolving a
+/// handle is an array lookup plus a generation check, so handles to erased elements are detected instead of aliasing
+/// whatever reuses their slot (until the generation wraps around).
+/// Values are kept dense, in no particular order, for iteration; erasing moves the last value into the hole.
+/// Freed slots are recycled through a free list threaded through the slots themselves.
+/// `THandle::Invalid()` is never handed out.
+template<
+  class TValue,
+  class THandle,
+  size_t IndexBits = sizeof(typename THandle::StorageType) * 8 / 2,
+  size_t InitialCapacity = 8,
+  class TAllocator = AlignedAllocator
+>
+class SlotMap final {
+public:
+  using value_type = TValue;
+  using handle_type = THandle;
+  using size_type = size_t;
+  using allocator_type = TAllocator;
+  using iterator = TValue*;
+  using const_iterator = TValue const*;
+
+private:
+  using StorageType = typename THandle::StorageType;
+
+  static_assert(std::is_unsigned_v<StorageType>);
+  static_assert(0 < IndexBits && IndexBits < sizeof(StorageType) * 8);
+
+  static constexpr size_t kGenerationBits = sizeof(StorageType) * 8 - IndexBits;
+  static constexpr StorageType kIndexMask = StorageType(~StorageType(0)) >> kGenerationBits;
+  static constexpr StorageType kGenerationMask = StorageType(~StorageType(0)) >> IndexBits;
+  static constexpr StorageType kInvalidValue = THandle::Invalid().Get();
+  static constexpr StorageType kNoFreeSlot = std::numeric_limits<StorageType>::max();
+
+  /// Live: `dense_index` locates the value. Free: `dense_index` holds the next free slot.
+  struct Slot final {
+    StorageType dense_index;
+    StorageType generation;
+  };
+
+  template<class T>
+  using Vector = SmallVector<T, InitialCapacity, std::max(alignof(T), sizeof(void*)), TAllocator>;
+
+public:
+  SlotMap() = default;
+  explicit SlotMap(allocator_type const& allocator) :
+    values_(allocator),
+    dense_to_slot_(allocator),
+    slots_(allocator)
+  {
+  }
+
+  iterator begin() noexcept { return values_.data(); }
+  const_iterator begin() const noexcept { return values_.data(); }
+  iterator end() noexcept { return values_.data() + values_.size(); }
+  const_iterator end() const noexcept { return values_.data() + values_.size(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  [[nodiscard]] bool empty() const noexcept { return values_.empty(); }
+  [[nodiscard]] size_type size() const noexcept { return values_.size(); }
+  [[nodiscard]] size_type capacity() const noexcept { return values_.capacity(); }
+  [[nodiscard]] static constexpr size_type max_size() noexcept { return size_type(kIndexMask) + 1; }
+
+  /// Dense values, parallel to the handles returned by `handle_at`.
+  [[nodiscard]] ArrayProxy<TValue> values() noexcept { return { values_.data(), values_.size() }; }
+  [[nodiscard]] ArrayProxy<TValue const> values() const noexcept { return { values_.data(), values_.size() }; }
+
+  /// Handle of the value at `dense_index` in iteration order.
+  [[nodiscard]] THandle handle_at(size_type dense_index) const noexcept {
+    StorageType const slot_index = dense_to_slot_[dense_index];
+    return THandle(Pack(slot_index, slots_[slot_index].generation));
+  }
+
+  void reserve(size_type new_capacity) {
+    values_.reserve(new_capacity);
+    dense_to_slot_.reserve(new_capacity);
+    slots_.reserve(new_capacity);
+  }
+
+  /// Destroys all values and invalidates all outstanding handles; slots are kept for reuse.
+  void clear() {
+    for (StorageType slot_index : dense_to_slot_) {
+      release_slot(slot_index);
+    }
+    values_.clear();
+    dense_to_slot_.clear();
+  }
+
+  template<class ... Args>
+  THandle emplace(Args&& ... args) {
+    // Grown first, so that the `push_back` below cannot throw after the value is constructed.
+    dense_to_slot_.reserve(dense_to_slot_.size() + 1);
+    StorageType const slot_index = acquire_slot();
+    try {
+      values_.emplace_back(std::forward<Args>(args)...);
+    }
+    catch (...) {
+      free_slot(slot_index);
+      throw;
+    }
+    dense_to_slot_.push_back(slot_index);
+
+    Slot& slot = slots_[slot_index];
+    slot.dense_index = StorageType(values_.size() - 1);
+    return THandle(Pack(slot_index, slot.generation));
+  }
+  THandle insert(TValue const& value) {
+    return emplace(value);
+  }
+  THandle insert(TValue&& value) {
+    return emplace(std::move(value));
+  }
+
+  /// Returns `false` if `handle` is stale or invalid.
+  bool erase(THandle const& handle) {
+    StorageType const slot_index = handle.Get() & kIndexMask;
+    if (!is_live(handle)) {
+      return false;
+    }
+
+    StorageType const dense_index = slots_[slot_index].dense_index;
+    StorageType const last_dense_index = StorageType(values_.size() - 1);
+    if (dense_index != last_dense_index) {
+      values_[dense_index] = std::move(values_.back());
+      dense_to_slot_[dense_index] = dense_to_slot_.back();
+      slots_[dense_to_slot_[dense_index]].dense_index = dense_index;
+    }
+    values_.pop_back();
+    dense_to_slot_.pop_back();
+
+    release_slot(slot_index);
+    return true;
+  }
+
+  [[nodiscard]] bool contains(THandle const& handle) const noexcept {
+    return is_live(handle);
+  }
+
+  /// Returns `nullptr` if `handle` is stale or invalid.
+  [[nodiscard]] TValue* get(THandle const& handle) noexcept {
+    return is_live(handle) ? &values_[slots_[handle.Get() & kIndexMask].dense_index] : nullptr;
+  }
+  [[nodiscard]] TValue const* get(THandle const& handle) const noexcept {
+    return const_cast<SlotMap*>(this)->get(handle);
+  }
+
+  [[nodiscard]] TValue& at(THandle const& handle) {
+    TValue* value = get(handle);
+    if (value == nullptr) {
+      throw std::out_of_range("SlotMap::at");
+    }
+    return *value;
+  }
+  [[nodiscard]] TValue const& at(THandle const& handle) const {
+    return const_cast<SlotMap*>(this)->at(handle);
+  }
+
+  /// `handle` must be live.
+  [[nodiscard]] TValue& operator[](THandle const& handle) noexcept {
+    MBASE_ASSERT(is_live(handle));
+    return values_[slots_[handle.Get() & kIndexMask].dense_index];
+  }
+  [[nodiscard]] TValue const& operator[](THandle const& handle) const noexcept {
+    return const_cast<SlotMap*>(this)->operator[](handle);
+  }
+
+private:
+  [[nodiscard]] static constexpr StorageType Pack(StorageType slot_index, StorageType generation) noexcept {
+    return StorageType(generation << IndexBits) | slot_index;
+  }
+
+  /// Next generation of the slot at `slot_index`, skipping the one that would pack into `THandle::Invalid()`.
+  [[nodiscard]] static constexpr StorageType NextGeneration(StorageType slot_index, StorageType generation) noexcept {
+    generation = (generation + 1) & kGenerationMask;
+    if (Pack(slot_index, generation) == kInvalidValue) {
+      generation = (generation + 1) & kGenerationMask;
+    }
+    return generation;
+  }
+
+  [[nodiscard]] bool is_live(THandle const& handle) const noexcept {
+    StorageType const slot_index = handle.Get() & kIndexMask;
+    StorageType const generation = handle.Get() >> IndexBits;
+    return handle.IsValid() && slot_index < slots_.size() && slots_[slot_index].generation == generation;
+  }
+
+  StorageType acquire_slot() {
+    if (free_head_ != kNoFreeSlot) {
+      StorageType const slot_index = free_head_;
+      free_head_ = slots_[slot_index].dense_index;
+      return slot_index;
+    }
+
+    if (slots_.size() == max_size()) {
+      throw std::length_error("SlotMap: out of slot indices");
+    }
+    StorageType const slot_index = StorageType(slots_.size());
+    StorageType const generation = Pack(slot_index, 0) == kInvalidValue ? 1 : 0;
+    slots_.push_back(Slot { 0, generation });
+    return slot_index;
+  }
+
+  /// Returns a slot to the free list without touching its generation; for slots that never handed out a handle.
+  void free_slot(StorageType slot_index) noexcept {
+    slots_[slot_index].dense_index = free_head_;
+    free_head_ = slot_index;
+  }
+
+  /// Invalidates handles to the slot and returns it to the free list.
+  void release_slot(StorageType slot_index) noexcept {
+    Slot& slot = slots_[slot_index];
+    slot.generation = NextGeneration(slot_index, slot.generation);
+    free_slot(slot_index);
+  }
+
+  Vector<TValue> values_;
+  Vector<StorageType> dense_to_slot_;
+  Vector<Slot> slots_;
+  StorageType free_head_ = kNoFreeSlot;
+};
+
+} // namespace mbase
@@ -0,0 +1,238 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstring>
+
+#include <compare>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+// external headers -------------------------------------
+#include <fmt/format.h>
+
+// public project headers -------------------------------
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+
+namespace mbase {
+
+/// String with small size optimization, stored in a `SmallVector`: strings of up to `InlineCapacity` characters
+/// never touch the heap.
+/// Always null-terminated, so `c_str()` is free. Converts implicitly to `std::string_view`.
+/// `append_format` formats in place through `fmt::format_to`.
+template<size_t InlineCapacity, class TAllocator = AlignedAllocator>
+class SmallString final {
+  // One extra character for the terminator.
+  using Storage = SmallVector<char, InlineCapacity + 1, alignof(void*), TAllocator>;
+
+public:
+  using value_type = char;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = char&;
+  using const_reference = char const&;
+  using iterator = char*;
+  using const_iterator = char const*;
+  using allocator_type = TAllocator;
+
+  static constexpr size_type npos = std::string_view::npos;
+
+  SmallString() {
+    chars_.push_back('\0');
+  }
+  explicit SmallString(allocator_type const& allocator) :
+    chars_(allocator)
+  {
+    chars_.push_back('\0');
+  }
+  explicit SmallString(std::string_view s, allocator_type const& allocator = allocator_type()) :
+    chars_(allocator)
+  {
+    assign(s);
+  }
+  SmallString(char const* s, allocator_type const& allocator = allocator_type()) :
+    SmallString(std::string_view(s), allocator)
+  {
+  }
+  SmallString(size_type n, char c, allocator_type const& allocator = allocator_type()) :
+    chars_(allocator)
+  {
+    chars_.resize(n, c);
+    chars_.push_back('\0');
+  }
+  SmallString(SmallString const& rhs) = default;
+  SmallString(SmallString&& rhs) noexcept :
+    chars_(std::move(rhs.chars_))
+  {
+    rhs.clear();
+  }
+  ~SmallString() = default;
+
+  SmallString& operator=(SmallString const& rhs) = default;
+  SmallString& operator=(SmallString&& rhs) noexcept {
+    if (this != &rhs) {
+      chars_ = std::move(rhs.chars_);
+      rhs.clear();
+    }
+    return *this;
+  }
+  SmallString& operator=(std::string_view s) {
+    return assign(s);
+  }
+  SmallString& operator=(char const* s) {
+    return assign(std::string_view(s));
+  }
+
+  iterator begin() noexcept { return chars_.data(); }
+  const_iterator begin() const noexcept { return chars_.data(); }
+  iterator end() noexcept { return chars_.data() + size(); }
+  const_iterator end() const noexcept { return chars_.data() + size(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+  [[nodiscard]] size_type size() const noexcept { return chars_.size() - 1; }
+  [[nodiscard]] size_type length() const noexcept { return size(); }
+  [[nodiscard]] size_type max_size() const noexcept { return chars_.max_size() - 1; }
+  [[nodiscard]] size_type capacity() const noexcept { return chars_.capacity() - 1; }
+  [[nodiscard]] bool is_inline() const noexcept { return capacity() <= InlineCapacity; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return chars_.get_allocator(); }
+
+  char* data() noexcept { return chars_.data(); }
+  char const* data() const noexcept { return chars_.data(); }
+  char const* c_str() const noexcept { return chars_.data(); }
+
+  [[nodiscard]] std::string_view view() const noexcept { return { chars_.data(), size() }; }
+  operator std::string_view() const noexcept { return view(); }
+
+  reference operator[](size_type i) noexcept { return chars_[i]; }
+  const_reference operator[](size_type i) const noexcept { return chars_[i]; }
+  reference front() noexcept { return chars_.front(); }
+  const_reference front() const noexcept { return chars_.front(); }
+  reference back() noexcept { return chars_[size() - 1]; }
+  const_reference back() const noexcept { return chars_[size() - 1]; }
+
+  void clear() noexcept {
+    chars_.clear();
+    chars_.push_back('\0');
+  }
+  void reserve(size_type new_capacity) {
+    chars_.reserve(new_capacity + 1);
+  }
+  void shrink_to_fit() {
+    chars_.shrink_to_fit();
+  }
+  /// New characters are set to `c`.
+  void resize(size_type new_size, char c = '\0') {
+    chars_.pop_back();
+    chars_.resize(new_size, c);
+    chars_.push_back('\0');
+  }
+
+  void push_back(char c) {
+    chars_.back() = c;
+    chars_.push_back('\0');
+  }
+  void pop_back() noexcept {
+    chars_.pop_back();
+    chars_.back() = '\0';
+  }
+
+  SmallString& assign(std::string_view s) {
+    if (s.data() != data()) {
+      // `s` may view this string; shrinking never reallocates.
+      if (size() > s.size()) {
+        memmove(data(), s.data(), s.size());
+        resize(s.size());
+      }
+      else {
+        clear();
+        append(s);
+      }
+    }
+    else {
+      resize(s.size());
+    }
+    return *this;
+  }
+
+  /// `s` may view this string.
+  SmallString& append(std::string_view s) {
+    size_type const old_size = size();
+    if (s.size() >= max_size() - old_size) {
+      throw std::length_error("SmallString size exceeds max_size!");
+    }
+    if (s.data() >= data() && s.data() < data() + chars_.size()) {
+      size_t const offset = static_cast<size_t>(s.data() - data());
+      reserve(old_size + s.size());
+      s = std::string_view(data() + offset, s.size());
+    }
+    else {
+      reserve(old_size + s.size());
+    }
+    chars_.resize_default_init(old_size + s.size() + 1);
+    if (!s.empty()) {
+      memcpy(data() + old_size, s.data(), s.size());
+    }
+    chars_.back() = '\0';
+    return *this;
+  }
+  SmallString& append(size_type n, char c) {
+    size_type const old_size = size();
+    resize(old_size + n, c);
+    return *this;
+  }
+  SmallString& operator+=(std::string_view s) { return append(s); }
+  SmallString& operator+=(char c) { push_back(c); return *this; }
+
+  /// Appends the formatted output, growing storage only if the result does not fit.
+  template<class ... Args>
+  SmallString& append_format(fmt::format_string<Args...> format, Args&& ... args) {
+    fmt::format_to(std::back_inserter(*this), format, std::forward<Args>(args)...);
+    return *this;
+  }
+
+  [[nodiscard]] std::string_view substr(size_type pos, size_type count = npos) const {
+    return view().substr(pos, count);
+  }
+  [[nodiscard]] size_type find(std::string_view s, size_type pos = 0) const noexcept { return view().find(s, pos); }
+  [[nodiscard]] size_type find(char c, size_type pos = 0) const noexcept { return view().find(c, pos); }
+  [[nodiscard]] bool starts_with(std::string_view s) const noexcept { return view().starts_with(s); }
+  [[nodiscard]] bool ends_with(std::string_view s) const noexcept { return view().ends_with(s); }
+
+  friend bool operator==(SmallString const& lhs, std::string_view rhs) noexcept { return lhs.view() == rhs; }
+  friend std::strong_ordering operator<=>(SmallString const& lhs, std::string_view rhs) noexcept { return lhs.view() <=> rhs; }
+  template<size_t N2, class A2>
+  friend bool operator==(SmallString const& lhs, SmallString<N2, A2> const& rhs) noexcept { return lhs.view() == rhs.view(); }
+  template<size_t N2, class A2>
+  friend std::strong_ordering operator<=>(SmallString const& lhs, SmallString<N2, A2> const& rhs) noexcept { return lhs.view() <=> rhs.view(); }
+
+private:
+  Storage chars_;
+};
+
+/// Formats into a `SmallString`; allocation-free when the result fits `InlineCapacity`.
+template<size_t InlineCapacity, class ... Args>
+[[nodiscard]] SmallString<InlineCapacity> FormatSmall(fmt::format_string<Args...> format, Args&& ... args) {
+  SmallString<InlineCapacity> result;
+  result.append_format(format, std::forward<Args>(args)...);
+  return result;
+}
+
+} // namespace mbase
+
+// Lets `fmt::format_to(std::back_inserter(small_string), ...)` write through `resize` and `data` instead of
+// one `push_back` per character.
+template<size_t InlineCapacity, class TAllocator>
+struct fmt::is_contiguous<mbase::SmallString<InlineCapacity, TAllocator>> : std::true_type {};
+
+template<size_t InlineCapacity, class TAllocator>
+struct fmt::formatter<mbase::SmallString<InlineCapacity, TAllocator>> : fmt::formatter<std::string_view> {
+  auto format(mbase::SmallString<InlineCapacity, TAllocator> const& value, fmt::format_context& ctx) const {
+    return fmt::formatter<std::string_view>::format(value.view(), ctx);
+  }
+};
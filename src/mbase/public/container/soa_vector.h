@@ -0,0 +1,379 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+/// Vector of records stored as a struct of arrays: each field `Fields[I]` lives in its own contiguous column, so a loop
+/// over one field streams through that field only.
+/// All columns share a single allocation from `TAllocator`; each column starts on a `ColumnAlignment` boundary.
+/// Columns are reachable as `ArrayProxy`s through `column<I>()`; iterators and `operator[]` yield
+/// `std::tuple<Fields&...>` for zip-style access.
+/// Fields must be nothrow move constructible, so that growing can relocate the columns one after the other without
+/// having to undo half a relocation.
+template<class TAllocator, size_t ColumnAlignment, class ... Fields>
+class BasicSoaVector final {
+  static_assert(sizeof...(Fields) > 0);
+  static_assert((!std::is_reference_v<Fields> && ...));
+  static_assert((std::is_nothrow_move_constructible_v<Fields> && ...), "SoaVector fields must be nothrow move constructible!");
+  static_assert(std::has_single_bit(ColumnAlignment));
+
+public:
+  using value_type = std::tuple<Fields...>;
+  using reference = std::tuple<Fields&...>;
+  using const_reference = std::tuple<Fields const&...>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using allocator_type = TAllocator;
+
+  static constexpr size_t kFieldCount = sizeof...(Fields);
+
+  template<size_t I>
+  using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+  template<bool IsConst>
+  class Iterator final {
+    using Owner = std::conditional_t<IsConst, BasicSoaVector const, BasicSoaVector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::tuple<Fields...>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<IsConst, std::tuple<Fields const&...>, std::tuple<Fields&...>>;
+    using pointer = void;
+
+    Iterator() = default;
+    Iterator(Owner* owner, size_t index) noexcept : owner_(owner), index_(index) {}
+    // Iterator -> ConstIterator
+    template<bool C = IsConst, std::enable_if_t<C, int> = 0>
+    Iterator(Iterator<false> const& rhs) noexcept : owner_(rhs.owner_), index_(rhs.index_) {}
+
+    reference operator*() const noexcept { return (*owner_)[index_]; }
+    reference operator[](difference_type n) const noexcept { return (*owner_)[index_ + n]; }
+
+    /// Position of the record, for indexing columns directly.
+    size_t index() const noexcept { return index_; }
+
+    Iterator& operator++() noexcept { ++index_; return *this; }
+    Iterator& operator--() noexcept { --index_; return *this; }
+    Iterator operator++(int) noexcept { auto tmp = *this; ++index_; return tmp; }
+    Iterator operator--(int) noexcept { auto tmp = *this; --index_; return tmp; }
+    Iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+    Iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+    friend Iterator operator+(Iterator it, difference_type n) noexcept { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) noexcept { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(Iterator const& lhs, Iterator const& rhs) noexcept {
+      return difference_type(lhs.index_) - difference_type(rhs.index_);
+    }
+
+    friend bool operator==(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.index_ == rhs.index_; }
+    friend auto operator<=>(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.index_ <=> rhs.index_; }
+
+  private:
+    friend class Iterator<true>;
+
+    Owner* owner_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  BasicSoaVector() = default;
+  explicit BasicSoaVector(allocator_type const& allocator) : allocator_(allocator) {}
+  BasicSoaVector(BasicSoaVector const& rhs) :
+    allocator_(rhs.allocator_)
+  {
+    reserve(rhs.size_);
+    size_t copied_columns = 0;
+    try {
+      for_each_column([&]<size_t I>() {
+        std::uninitialized_copy_n(std::get<I>(rhs.columns_), rhs.size_, std::get<I>(columns_));
+        ++copied_columns;
+      });
+    }
+    catch (...) {
+      for_each_column([&]<size_t I>() {
+        if (I < copied_columns) {
+          std::destroy_n(std::get<I>(columns_), rhs.size_);
+        }
+      });
+      deallocate();
+      throw;
+    }
+    size_ = rhs.size_;
+  }
+  BasicSoaVector(BasicSoaVector&& rhs) noexcept :
+    columns_(std::exchange(rhs.columns_, {})),
+    size_(std::exchange(rhs.size_, 0)),
+    capacity_(std::exchange(rhs.capacity_, 0)),
+    allocator_(rhs.allocator_)
+  {
+  }
+  ~BasicSoaVector() {
+    clear();
+    deallocate();
+  }
+
+  BasicSoaVector& operator=(BasicSoaVector const& rhs) {
+    if (this != &rhs) {
+      BasicSoaVector tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+  BasicSoaVector& operator=(BasicSoaVector&& rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      deallocate();
+      columns_ = std::exchange(rhs.columns_, {});
+      size_ = std::exchange(rhs.size_, 0);
+      capacity_ = std::exchange(rhs.capacity_, 0);
+      allocator_ = rhs.allocator_;
+    }
+    return *this;
+  }
+
+  iterator begin() noexcept { return { this, 0 }; }
+  const_iterator begin() const noexcept { return { this, 0 }; }
+  iterator end() noexcept { return { this, size_ }; }
+  const_iterator end() const noexcept { return { this, size_ }; }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] size_type capacity() const noexcept { return capacity_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  reference operator[](size_type i) noexcept {
+    return std::apply([i](Fields* ... columns) { return reference(columns[i]...); }, columns_);
+  }
+  const_reference operator[](size_type i) const noexcept {
+    return std::apply([i](Fields* ... columns) { return const_reference(columns[i]...); }, columns_);
+  }
+  reference front() noexcept { return (*this)[0]; }
+  const_reference front() const noexcept { return (*this)[0]; }
+  reference back() noexcept { return (*this)[size_ - 1]; }
+  const_reference back() const noexcept { return (*this)[size_ - 1]; }
+
+  /// Column of field `I`, aligned to `ColumnAlignment`.
+  template<size_t I>
+  [[nodiscard]] field_type<I>* data() noexcept { return std::get<I>(columns_); }
+  template<size_t I>
+  [[nodiscard]] field_type<I> const* data() const noexcept { return std::get<I>(columns_); }
+
+  template<size_t I>
+  [[nodiscard]] ArrayProxy<field_type<I>> column() noexcept { return { data<I>(), size_ }; }
+  template<size_t I>
+  [[nodiscard]] ArrayProxy<field_type<I> const> column() const noexcept { return { data<I>(), size_ }; }
+
+  void reserve(size_type new_capacity) {
+    if (new_capacity > capacity_) {
+      reallocate(new_capacity);
+    }
+  }
+  void shrink_to_fit() {
+    if (size_ == 0) {
+      deallocate();
+    }
+    else if (size_ < capacity_) {
+      reallocate(size_);
+    }
+  }
+
+  void clear() noexcept {
+    for_each_column([&]<size_t I>() {
+      std::destroy_n(std::get<I>(columns_), size_);
+    });
+    size_ = 0;
+  }
+
+  /// Appends a record, constructing each field from the corresponding argument.
+  /// The arguments may refer to records of this vector: when growing, the new record is constructed in the new block
+  /// before the old one is released.
+  template<class ... Args>
+  reference emplace_back(Args&& ... args) {
+    static_assert(sizeof...(Args) == kFieldCount, "One argument per field");
+
+    if (size_ == capacity_) {
+      size_t const new_capacity = PowerOf2GrowthPolicy {}(capacity_, std::max(size_ + 1, size_t(8)));
+      std::tuple<Fields*...> const new_columns = allocate_columns(new_capacity);
+      try {
+        construct_fields<0>(new_columns, size_, std::forward<Args>(args)...);
+      }
+      catch (...) {
+        allocator_.deallocate(std::get<0>(new_columns), BlockSize(new_capacity), kBlockAlignment);
+        throw;
+      }
+      adopt_columns(new_columns, new_capacity);
+    }
+    else {
+      construct_fields<0>(columns_, size_, std::forward<Args>(args)...);
+    }
+    return (*this)[size_++];
+  }
+  void push_back(Fields const& ... fields) {
+    emplace_back(fields...);
+  }
+  void push_back(Fields&& ... fields) {
+    emplace_back(std::move(fields)...);
+  }
+  void push_back(value_type const& record) {
+    std::apply([this](Fields const& ... fields) { emplace_back(fields...); }, record);
+  }
+
+  void pop_back() noexcept {
+    --size_;
+    for_each_column([&]<size_t I>() {
+      std::destroy_at(std::get<I>(columns_) + size_);
+    });
+  }
+
+  /// Grows with value-initialized records or shrinks to `new_size`.
+  void resize(size_type new_size) {
+    if (new_size > size_) {
+      reserve(new_size);
+      for (size_t i = size_; i != new_size; ++i) {
+        construct_fields<0>(columns_, i, Fields()...);
+        ++size_;
+      }
+    }
+    else {
+      while (size_ != new_size) {
+        pop_back();
+      }
+    }
+  }
+
+  /// Erases the record at `position`, shifting the following records down.
+  iterator erase(const_iterator position) {
+    size_t const index = position.index();
+    for_each_column([&]<size_t I>() {
+      using T = field_type<I>;
+      T* column = std::get<I>(columns_);
+      std::destroy_at(column + index);
+      detail::relocate_strategy<T>::overlapping(column + index + 1, column + size_, column + index);
+    });
+    --size_;
+    return begin() + index;
+  }
+
+  /// Erases the record at `index` by moving the last record into its place. O(1), does not preserve order.
+  void erase_unordered(size_type index) {
+    if (index != size_ - 1) {
+      for_each_column([&]<size_t I>() {
+        auto column = std::get<I>(columns_);
+        column[index] = std::move(column[size_ - 1]);
+      });
+    }
+    pop_back();
+  }
+
+  void swap(BasicSoaVector& rhs) noexcept {
+    std::swap(columns_, rhs.columns_);
+    std::swap(size_, rhs.size_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(allocator_, rhs.allocator_);
+  }
+
+private:
+  static constexpr size_t kBlockAlignment = std::max({ ColumnAlignment, alignof(Fields)... });
+
+  [[nodiscard]] static constexpr size_t AlignUp(size_t value) noexcept {
+    return (value + ColumnAlignment - 1) & ~(ColumnAlignment - 1);
+  }
+
+  /// Byte size of a block holding `capacity` records, each column padded to `ColumnAlignment`.
+  [[nodiscard]] static constexpr size_t BlockSize(size_t capacity) noexcept {
+    return (AlignUp(sizeof(Fields) * capacity) + ...);
+  }
+
+  template<class TFunction>
+  static void for_each_column(TFunction&& function) {
+    [&]<size_t ... I>(std::index_sequence<I...>) {
+      (function.template operator()<I>(), ...);
+    }(std::index_sequence_for<Fields...>{});
+  }
+
+  template<size_t I, class Arg, class ... Rest>
+  static void construct_fields(std::tuple<Fields*...> const& columns, size_t index, Arg&& arg, Rest&& ... rest) {
+    field_type<I>* element = std::get<I>(columns) + index;
+    std::construct_at(element, std::forward<Arg>(arg));
+    if constexpr (sizeof...(Rest) > 0) {
+      try {
+        construct_fields<I + 1>(columns, index, std::forward<Rest>(rest)...);
+      }
+      catch (...) {
+        std::destroy_at(element);
+        throw;
+      }
+    }
+  }
+
+  void reallocate(size_t new_capacity) {
+    adopt_columns(allocate_columns(new_capacity), new_capacity);
+  }
+
+  /// Allocates a block for `capacity` records and lays the columns out in it.
+  [[nodiscard]] std::tuple<Fields*...> allocate_columns(size_t capacity) {
+    auto block = static_cast<std::byte*>(allocator_.allocate(BlockSize(capacity), kBlockAlignment));
+
+    std::tuple<Fields*...> columns;
+    size_t offset = 0;
+    for_each_column([&]<size_t I>() {
+      using T = field_type<I>;
+      std::get<I>(columns) = reinterpret_cast<T*>(block + offset);
+      offset += AlignUp(sizeof(T) * capacity);
+    });
+    return columns;
+  }
+  /// Relocates the records into `new_columns`, which hold `new_capacity` records, and releases the old block.
+  void adopt_columns(std::tuple<Fields*...> const& new_columns, size_t new_capacity) noexcept {
+    for_each_column([&]<size_t I>() {
+      using T = field_type<I>;
+      T* column = std::get<I>(columns_);
+      detail::relocate_strategy<T>::non_overlapping(column, column + size_, std::get<I>(new_columns));
+    });
+
+    deallocate();
+    columns_ = new_columns;
+    capacity_ = new_capacity;
+  }
+
+  void deallocate() noexcept {
+    if (capacity_ != 0) {
+      allocator_.deallocate(std::get<0>(columns_), BlockSize(capacity_), kBlockAlignment);
+      columns_ = {};
+      capacity_ = 0;
+    }
+  }
+
+  std::tuple<Fields*...> columns_ {};
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS allocator_type allocator_ {};
+};
+
+/// `BasicSoaVector` drawing from `AlignedAlloc`, with cache-line aligned columns.
+template<class ... Fields>
+using SoaVector = BasicSoaVector<AlignedAllocator, 64, Fields...>;
+
+} // namespace mbase
@@ -0,0 +1,310 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/container.h"
+#include "mbase/public/memory.h"
+
+namespace mbase {
+
+/// Vector made of separately allocated blocks: block `b` holds `FirstBlockSize << b` elements.
+/// Growing only adds a block, so elements are never moved and pointers/references to them stay valid until the
+/// element is removed; appending costs at most one allocation and no copies.
+/// Element `i` lives in block `bit_width(i + FirstBlockSize) - 1 - log2(FirstBlockSize)`, so indexing is a couple of
+/// bit operations and two loads.
+/// Each block is contiguous: use `segment(b)` to iterate in `ArrayProxy` chunks.
+template<class T, size_t FirstBlockSize = 16, class TAllocator = AlignedAllocator>
+class StableVector final {
+  static_assert(std::has_single_bit(FirstBlockSize));
+
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = T const&;
+  using allocator_type = TAllocator;
+
+  template<bool IsConst>
+  class Iterator final {
+    using Owner = std::conditional_t<IsConst, StableVector const, StableVector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, T const*, T*>;
+    using reference = std::conditional_t<IsConst, T const&, T&>;
+
+    Iterator() = default;
+    Iterator(Owner* owner, size_t index) : owner_(owner), index_(index) {}
+    template<bool OtherIsConst, std::enable_if_t<IsConst && !OtherIsConst, int> = 0>
+    Iterator(Iterator<OtherIsConst> const& rhs) : owner_(rhs.owner_), index_(rhs.index_) {}
+
+    reference operator*() const noexcept { return (*owner_)[index_]; }
+    pointer operator->() const noexcept { return &(*owner_)[index_]; }
+    reference operator[](difference_type n) const noexcept { return (*owner_)[index_ + n]; }
+
+    Iterator& operator++() noexcept { ++index_; return *this; }
+    Iterator operator++(int) noexcept { Iterator tmp = *this; ++index_; return tmp; }
+    Iterator& operator--() noexcept { --index_; return *this; }
+    Iterator operator--(int) noexcept { Iterator tmp = *this; --index_; return tmp; }
+    Iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+    Iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+
+    friend Iterator operator+(Iterator it, difference_type n) noexcept { return it += n; }
+    friend Iterator operator+(difference_type n, Iterator it) noexcept { return it += n; }
+    friend Iterator operator-(Iterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(Iterator const& lhs, Iterator const& rhs) noexcept {
+      return difference_type(lhs.index_) - difference_type(rhs.index_);
+    }
+
+    friend bool operator==(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.index_ == rhs.index_; }
+    friend auto operator<=>(Iterator const& lhs, Iterator const& rhs) noexcept { return lhs.index_ <=> rhs.index_; }
+
+  private:
+    template<bool> friend class Iterator;
+
+    Owner* owner_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  StableVector() = default;
+  explicit StableVector(allocator_type const& allocator) :
+    blocks_(allocator),
+    allocator_(allocator)
+  {
+  }
+  StableVector(StableVector const& rhs) :
+    blocks_(rhs.allocator_),
+    allocator_(rhs.allocator_)
+  {
+    reserve(rhs.size_);
+    for (size_t b = 0; b != rhs.segment_count(); ++b) {
+      for (T const& value : rhs.segment(b)) {
+        emplace_back(value);
+      }
+    }
+  }
+  StableVector(StableVector&& rhs) noexcept :
+    blocks_(std::move(rhs.blocks_)),
+    size_(std::exchange(rhs.size_, 0)),
+    capacity_(std::exchange(rhs.capacity_, 0)),
+    allocator_(rhs.allocator_)
+  {
+    rhs.blocks_.clear();
+  }
+  ~StableVector() {
+    clear();
+    deallocate_blocks(0);
+  }
+
+  StableVector& operator=(StableVector const& rhs) {
+    if (this != &rhs) {
+      StableVector tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+  StableVector& operator=(StableVector&& rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      deallocate_blocks(0);
+      blocks_ = std::move(rhs.blocks_);
+      rhs.blocks_.clear();
+      size_ = std::exchange(rhs.size_, 0);
+      capacity_ = std::exchange(rhs.capacity_, 0);
+      allocator_ = rhs.allocator_;
+    }
+    return *this;
+  }
+
+  iterator begin() noexcept { return { this, 0 }; }
+  const_iterator begin() const noexcept { return { this, 0 }; }
+  iterator end() noexcept { return { this, size_ }; }
+  const_iterator end() const noexcept { return { this, size_ }; }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] size_type capacity() const noexcept { return capacity_; }
+  [[nodiscard]] static constexpr size_type max_size() noexcept { return (~size_t(0) >> 1) / sizeof(T); }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  reference operator[](size_type i) noexcept {
+    auto const [block, offset] = Locate(i);
+    return blocks_[block][offset];
+  }
+  const_reference operator[](size_type i) const noexcept {
+    auto const [block, offset] = Locate(i);
+    return blocks_[block][offset];
+  }
+  reference at(size_type i) {
+    if (i >= size_) {
+      throw std::out_of_range("StableVector index out of range!");
+    }
+    return (*this)[i];
+  }
+  const_reference at(size_type i) const {
+    if (i >= size_) {
+      throw std::out_of_range("StableVector index out of range!");
+    }
+    return (*this)[i];
+  }
+  reference front() noexcept { return (*this)[0]; }
+  const_reference front() const noexcept { return (*this)[0]; }
+  reference back() noexcept { return (*this)[size_ - 1]; }
+  const_reference back() const noexcept { return (*this)[size_ - 1]; }
+
+  /// Number of blocks holding at least one element.
+  [[nodiscard]] size_type segment_count() const noexcept {
+    return size_ == 0 ? 0 : Locate(size_ - 1).block + 1;
+  }
+  /// The elements of block `block`, which are contiguous.
+  [[nodiscard]] ArrayProxy<T> segment(size_type block) noexcept {
+    return { blocks_[block], SegmentSize(block) };
+  }
+  [[nodiscard]] ArrayProxy<T const> segment(size_type block) const noexcept {
+    return { blocks_[block], SegmentSize(block) };
+  }
+
+  /// Allocates blocks until `new_capacity` elements fit. Never moves elements.
+  void reserve(size_type new_capacity) {
+    if (new_capacity > max_size()) {
+      throw std::length_error("StableVector capacity exceeds max_size!");
+    }
+    while (capacity_ < new_capacity) {
+      add_block();
+    }
+  }
+  /// Frees the blocks past the last element.
+  void shrink_to_fit() {
+    deallocate_blocks(segment_count());
+  }
+
+  /// Destroys all elements; blocks are kept for reuse.
+  void clear() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_t b = 0, n = segment_count(); b != n; ++b) {
+        std::destroy(segment(b).begin(), segment(b).end());
+      }
+    }
+    size_ = 0;
+  }
+
+  template<class ... Args>
+  reference emplace_back(Args&& ... args) {
+    if (size_ == capacity_) {
+      reserve(size_ + 1);
+    }
+    auto const [block, offset] = Locate(size_);
+    T* element = std::construct_at(blocks_[block] + offset, std::forward<Args>(args)...);
+    ++size_;
+    return *element;
+  }
+  void push_back(T const& value) {
+    emplace_back(value);
+  }
+  void push_back(T&& value) {
+    emplace_back(std::move(value));
+  }
+  void pop_back() noexcept {
+    MBASE_ASSERT(size_ != 0);
+    --size_;
+    std::destroy_at(&(*this)[size_]);
+  }
+
+  void resize(size_type new_size) {
+    resize_impl(new_size, [this] { emplace_back(); });
+  }
+  void resize(size_type new_size, T const& value) {
+    resize_impl(new_size, [&] { emplace_back(value); });
+  }
+
+  void swap(StableVector& rhs) noexcept {
+    std::swap(blocks_, rhs.blocks_);
+    std::swap(size_, rhs.size_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(allocator_, rhs.allocator_);
+  }
+
+private:
+  static constexpr size_t kFirstBlockBits = std::countr_zero(FirstBlockSize);
+  static constexpr size_t kBlockAlignment = std::max(alignof(T), sizeof(void*));
+
+  struct Location final {
+    size_t block;
+    size_t offset;
+  };
+
+  [[nodiscard]] static constexpr size_t BlockSize(size_t block) noexcept {
+    return FirstBlockSize << block;
+  }
+
+  [[nodiscard]] static constexpr Location Locate(size_t index) noexcept {
+    size_t const biased = index + FirstBlockSize;
+    size_t const msb = std::bit_width(biased) - 1;
+    return { msb - kFirstBlockBits, biased - (size_t(1) << msb) };
+  }
+
+  /// Number of elements in block `block`.
+  [[nodiscard]] size_t SegmentSize(size_t block) const noexcept {
+    size_t const first = BlockSize(block) - FirstBlockSize;
+    return std::min(size_, first + BlockSize(block)) - first;
+  }
+
+  template<class TEmplace>
+  void resize_impl(size_type new_size, TEmplace&& emplace) {
+    if (new_size < size_) {
+      while (size_ > new_size) {
+        pop_back();
+      }
+    }
+    else {
+      reserve(new_size);
+      while (size_ < new_size) {
+        emplace();
+      }
+    }
+  }
+
+  void add_block() {
+    size_t const block_size = BlockSize(blocks_.size());
+    blocks_.reserve(blocks_.size() + 1);
+    blocks_.push_back(static_cast<T*>(allocator_.allocate(sizeof(T) * block_size, kBlockAlignment)));
+    capacity_ += block_size;
+  }
+
+  /// Frees blocks `first_block` and up, which must not hold elements.
+  void deallocate_blocks(size_t first_block) noexcept {
+    while (blocks_.size() > first_block) {
+      size_t const block_size = BlockSize(blocks_.size() - 1);
+      allocator_.deallocate(blocks_.back(), sizeof(T) * block_size, kBlockAlignment);
+      blocks_.pop_back();
+      capacity_ -= block_size;
+    }
+  }
+
+  SmallVector<T*, 8, alignof(T*), TAllocator> blocks_;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS allocator_type allocator_ {};
+};
+
+} // namespace mbase
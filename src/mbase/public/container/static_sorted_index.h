@@ -0,0 +1,274 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// public project headers -------------------------------
+#include "mbase/public/array_proxy.h"
+#include "mbase/public/assert.h"
+#include "mbase/public/call.h"
+#include "mbase/public/memory.h"
+#include "mbase/public/type_util.h"
+
+namespace mbase {
+
+/// Read-only search index over a sorted array, stored in Eytzinger (BFS) order: the children of element `k` are `2k`
+/// and `2k + 1`, so the first levels of every search share a few hot cache lines, and the `64 / sizeof(T)`
+/// descendants four levels below a node share one line, which is prefetched while the levels in between are walked.
+/// The search loop has no data-dependent branches.
+/// Results are reported as ranks, i.e. indices into the sorted source array, which can index parallel value arrays.
+/// The `*_batch` functions advance a group of searches in lockstep so that their cache misses overlap.
+template<class T, class TCompare = std::less<>, class TAllocator = AlignedAllocator>
+class StaticSortedIndex final {
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using key_compare = TCompare;
+  using allocator_type = TAllocator;
+
+  StaticSortedIndex() = default;
+  /// `sorted` must be sorted by `comp`; it is copied and need not outlive the index.
+  explicit StaticSortedIndex(ArrayProxy<T const> sorted, TCompare const& comp = TCompare(), TAllocator const& allocator = TAllocator()) :
+    comp_(comp),
+    allocator_(allocator)
+  {
+    MBASE_ASSERT_MSG(std::is_sorted(sorted.begin(), sorted.end(), comp_), "StaticSortedIndex input is not sorted!");
+    if (sorted.size() >= UINT32_MAX) {
+      throw std::length_error("StaticSortedIndex size exceeds 32-bit ranks!");
+    }
+    allocate(sorted.size());
+    size_t rank = 0;
+    try {
+      Build(sorted, 1, rank);
+    }
+    catch (...) {
+      // Constructed in order of rank, not of position.
+      DestroyFirst(1, rank, sorted.size());
+      size_ = sorted.size();
+      deallocate();
+      throw;
+    }
+    size_ = sorted.size();
+    levels_ = std::bit_width(size_ + 1) - 1;
+  }
+  StaticSortedIndex(StaticSortedIndex const& rhs) :
+    comp_(rhs.comp_),
+    allocator_(rhs.allocator_)
+  {
+    if (rhs.keys_ == nullptr) {
+      return;
+    }
+    allocate(rhs.size_);
+    size_t k = 1;
+    try {
+      for (; k <= rhs.size_; ++k) {
+        std::construct_at(keys_ + k, rhs.keys_[k]);
+      }
+    }
+    catch (...) {
+      std::destroy(keys_ + 1, keys_ + k);
+      size_ = rhs.size_;
+      deallocate();
+      throw;
+    }
+    std::copy_n(rhs.ranks_, rhs.size_ + 1, ranks_);
+    size_ = rhs.size_;
+    levels_ = rhs.levels_;
+  }
+  StaticSortedIndex(StaticSortedIndex&& rhs) noexcept :
+    keys_(std::exchange(rhs.keys_, nullptr)),
+    ranks_(std::exchange(rhs.ranks_, nullptr)),
+    size_(std::exchange(rhs.size_, 0)),
+    levels_(std::exchange(rhs.levels_, 0)),
+    comp_(rhs.comp_),
+    allocator_(rhs.allocator_)
+  {
+  }
+  ~StaticSortedIndex() {
+    if (keys_ != nullptr) {
+      std::destroy_n(keys_ + 1, size_);
+      deallocate();
+    }
+  }
+
+  StaticSortedIndex& operator=(StaticSortedIndex const& rhs) {
+    if (this != &rhs) {
+      StaticSortedIndex tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+  StaticSortedIndex& operator=(StaticSortedIndex&& rhs) noexcept {
+    if (this != &rhs) {
+      StaticSortedIndex tmp(std::move(rhs));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_type size() const noexcept { return size_; }
+  [[nodiscard]] key_compare key_comp() const { return comp_; }
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+  /// Number of elements ordered before `key`: the index `std::lower_bound` would return in the sorted source.
+  template<class K>
+  [[nodiscard]] size_type rank(K const& key) const {
+    return RankOf(search(key));
+  }
+  /// First element not ordered before `key`, or `nullptr`.
+  template<class K>
+  [[nodiscard]] T const* lower_bound(K const& key) const {
+    size_t const k = search(key);
+    return k != 0 ? keys_ + k : nullptr;
+  }
+  template<class K>
+  [[nodiscard]] bool contains(K const& key) const {
+    size_t const k = search(key);
+    return k != 0 && !comp_(key, keys_[k]);
+  }
+
+  /// `ranks[i] = rank(keys[i])`.
+  template<class K>
+  void rank_batch(ArrayProxy<K const> keys, ArrayProxy<size_t> ranks) const {
+    MBASE_ASSERT(keys.size() == ranks.size());
+    search_batch(keys, [&](size_t i, size_t k) {
+      ranks[i] = RankOf(k);
+    });
+  }
+  /// `found[i] = contains(keys[i])`.
+  template<class K>
+  void contains_batch(ArrayProxy<K const> keys, ArrayProxy<bool> found) const {
+    MBASE_ASSERT(keys.size() == found.size());
+    search_batch(keys, [&](size_t i, size_t k) {
+      found[i] = k != 0 && !comp_(keys[i], keys_[k]);
+    });
+  }
+
+  void swap(StaticSortedIndex& rhs) noexcept {
+    std::swap(keys_, rhs.keys_);
+    std::swap(ranks_, rhs.ranks_);
+    std::swap(size_, rhs.size_);
+    std::swap(levels_, rhs.levels_);
+    std::swap(comp_, rhs.comp_);
+    std::swap(allocator_, rhs.allocator_);
+  }
+
+private:
+  static constexpr size_t kCacheLineSize = 64;
+  /// Elements per cache line: the descendants `log2(kLineElements)` levels below a node are contiguous.
+  static constexpr size_t kLineElements = std::max<size_t>(1, kCacheLineSize / sizeof(T));
+  static constexpr size_t kAlignment = std::max(kCacheLineSize, alignof(T));
+  static constexpr size_t kBatchSize = 16;
+
+  /// Fills the subtree rooted at `k` from `sorted`, in order.
+  void Build(ArrayProxy<T const> sorted, size_t k, size_t& rank) {
+    if (k > sorted.size()) {
+      return;
+    }
+    Build(sorted, 2 * k, rank);
+    std::construct_at(keys_ + k, sorted[rank]);
+    ranks_[k] = uint32_t(rank);
+    ++rank;
+    Build(sorted, 2 * k + 1, rank);
+  }
+
+  /// Destroys the first `count` elements of the subtree rooted at `k`, in order.
+  void DestroyFirst(size_t k, size_t& count, size_t size) noexcept {
+    if (k > size || count == 0) {
+      return;
+    }
+    DestroyFirst(2 * k, count, size);
+    if (count != 0) {
+      std::destroy_at(keys_ + k);
+      --count;
+      DestroyFirst(2 * k + 1, count, size);
+    }
+  }
+
+  [[nodiscard]] size_t RankOf(size_t k) const noexcept {
+    return k != 0 ? ranks_[k] : size_;
+  }
+
+  void prefetch_descendants(size_t k) const noexcept {
+    // Only an address: the line may lie past the end of the array.
+    MBASE_PREFETCH(reinterpret_cast<void const*>(reinterpret_cast<uintptr_t>(keys_) + k * kLineElements * sizeof(T)));
+  }
+
+  /// Eytzinger index of the first element not ordered before `key`, or 0.
+  template<class K>
+  [[nodiscard]] size_t search(K const& key) const {
+    size_t k = 1;
+    // Every node on the first `levels_` levels exists, so these steps need no bounds check.
+    for (size_t level = 0; level != levels_; ++level) {
+      prefetch_descendants(k);
+      k = 2 * k + size_t(comp_(keys_[k], key));
+    }
+    if (k <= size_) {
+      k = 2 * k + size_t(comp_(keys_[k], key));
+    }
+    // Undo the right turns taken after the last left turn; the node where we turned left is the answer.
+    return k >> (std::countr_one(k) + 1);
+  }
+
+  /// Runs `search` for every key in groups of `kBatchSize`, one level at a time for the whole group, and reports
+  /// `on_result(i, k)` for each.
+  template<class K, class TOnResult>
+  void search_batch(ArrayProxy<K const> keys, TOnResult&& on_result) const {
+    size_t k[kBatchSize];
+    for (size_t first = 0; first < keys.size(); first += kBatchSize) {
+      size_t const count = std::min(kBatchSize, keys.size() - first);
+      std::fill_n(k, count, size_t(1));
+      for (size_t level = 0; level != levels_; ++level) {
+        for (size_t j = 0; j != count; ++j) {
+          prefetch_descendants(k[j]);
+          k[j] = 2 * k[j] + size_t(comp_(keys_[k[j]], keys[first + j]));
+        }
+      }
+      for (size_t j = 0; j != count; ++j) {
+        if (k[j] <= size_) {
+          k[j] = 2 * k[j] + size_t(comp_(keys_[k[j]], keys[first + j]));
+        }
+        on_result(first + j, k[j] >> (std::countr_one(k[j]) + 1));
+      }
+    }
+  }
+
+  void allocate(size_t size) {
+    keys_ = static_cast<T*>(allocator_.allocate(sizeof(T) * (size + 1), kAlignment));
+    try {
+      ranks_ = static_cast<uint32_t*>(allocator_.allocate(sizeof(uint32_t) * (size + 1), alignof(uint32_t)));
+    }
+    catch (...) {
+      allocator_.deallocate(keys_, sizeof(T) * (size + 1), kAlignment);
+      keys_ = nullptr;
+      throw;
+    }
+  }
+  void deallocate() noexcept {
+    allocator_.deallocate(keys_, sizeof(T) * (size_ + 1), kAlignment);
+    allocator_.deallocate(ranks_, sizeof(uint32_t) * (size_ + 1), alignof(uint32_t));
+    keys_ = nullptr;
+    ranks_ = nullptr;
+  }
+
+  /// 1-based: `keys_[0]` is unused, so that the children of `k` are `2k` and `2k + 1`.
+  T* keys_ = nullptr;
+  /// Rank of `keys_[k]` in the sorted source.
+  uint32_t* ranks_ = nullptr;
+  size_t size_ = 0;
+  /// Number of complete levels.
+  size_t levels_ = 0;
+  MBASE_NO_UNIQUE_ADDRESS TCompare comp_ {};
+  MBASE_NO_UNIQUE_ADDRESS TAllocator allocator_ {};
+};
+
+} // namespace mbase
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mbase {
+
+namespace detail {
+
+/// How the type-erased call forwards an argument declared as `T`: by value if that is cheap, so that small arguments
+/// travel in registers instead of being spilled to the stack to be passed by reference; by reference otherwise.
+template<class T>
+using function_forward_t = std::conditional_t<
+  std::is_scalar_v<T> || (std::is_trivially_copyable_v<T> && std::is_object_v<T> && sizeof(T) <= 2 * sizeof(void*)),
+  T,
+  T&&
+>;
+
+} // namespace detail
+
+template<class Signature, size_t Capacity = 3 * sizeof(void*), size_t Alignment = alignof(void*)>
+class InplaceFunction;
+
+/// Move-only `std::function` replacement that stores the callable in a `Capacity`-byte inline buffer and never
+/// allocates: a callable that does not fit is a compile error, not a heap allocation.
+/// Takes `Capacity + 2 * sizeof(void*)` bytes. Calls go through a single function pointer, with small trivially
+/// copyable arguments passed by value; callables that are trivially copyable and destructible (e.g. lambdas capturing
+/// pointers and references) are moved by copying the buffer, without a call.
+/// As with `std::function`, `operator()` is `const` but invokes the callable as non-const. Unlike it, calling an empty
+/// `InplaceFunction` is undefined, as calling a null function pointer is.
+/// Depends on no other mbase header, so that `log.h` can use it.
+template<class R, class ... Args, size_t Capacity, size_t Alignment>
+class InplaceFunction<R(Args...), Capacity, Alignment> final {
+public:
+  using result_type = R;
+
+  static constexpr size_t kCapacity = Capacity;
+  static constexpr size_t kAlignment = Alignment;
+
+  /// Whether a callable of type `F` can be stored.
+  template<class F>
+  static constexpr bool kFits =
+    sizeof(F) <= Capacity && alignof(F) <= Alignment && Alignment % alignof(F) == 0 && std::is_nothrow_move_constructible_v<F>;
+
+  InplaceFunction() noexcept = default;
+  InplaceFunction(std::nullptr_t) noexcept {}
+  template<class F>
+    requires (!std::is_same_v<std::remove_cvref_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+  InplaceFunction(F&& function) {
+    using T = std::decay_t<F>;
+    static_assert(sizeof(T) <= Capacity, "Callable does not fit in InplaceFunction: capture less or raise Capacity!");
+    static_assert(alignof(T) <= Alignment && Alignment % alignof(T) == 0, "Callable is overaligned for InplaceFunction!");
+    static_assert(std::is_nothrow_move_constructible_v<T>, "InplaceFunction callables must be nothrow move constructible!");
+
+    if constexpr (std::is_pointer_v<T> || std::is_member_pointer_v<T>) {
+      if (function == nullptr) {
+        return;
+      }
+    }
+    ::new(static_cast<void*>(storage_)) T(std::forward<F>(function));
+    invoke_ = &Invoke<T>;
+    if constexpr (!(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>)) {
+      manage_ = &Manage<T>;
+    }
+  }
+  InplaceFunction(InplaceFunction&& rhs) noexcept {
+    move_from(rhs);
+  }
+  ~InplaceFunction() {
+    reset();
+  }
+
+  InplaceFunction& operator=(InplaceFunction&& rhs) noexcept {
+    if (this != &rhs) {
+      reset();
+      move_from(rhs);
+    }
+    return *this;
+  }
+  InplaceFunction& operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+  template<class F>
+    requires (!std::is_same_v<std::remove_cvref_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+  InplaceFunction& operator=(F&& function) {
+    return *this = InplaceFunction(std::forward<F>(function));
+  }
+
+  InplaceFunction(InplaceFunction const&) = delete;
+  InplaceFunction& operator=(InplaceFunction const&) = delete;
+
+  [[nodiscard]] explicit operator bool() const noexcept { return invoke_ != nullptr; }
+  friend bool operator==(InplaceFunction const& lhs, std::nullptr_t) noexcept { return !lhs; }
+
+  R operator()(Args... args) const {
+    return invoke_(storage_, std::forward<Args>(args)...);
+  }
+
+  void swap(InplaceFunction& rhs) noexcept {
+    InplaceFunction tmp(std::move(rhs));
+    rhs = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+private:
+  enum class Operation {
+    /// Move-constructs the callable at `source` into `target`, then destroys it at `source`.
+    kRelocate,
+    /// Destroys the callable at `target`.
+    kDestroy,
+  };
+
+  using InvokeFunction = R (*)(void* storage, detail::function_forward_t<Args> ... args);
+  using ManageFunction = void (*)(Operation operation, void* target, void* source) noexcept;
+
+  template<class T>
+  static R Invoke(void* storage, detail::function_forward_t<Args> ... args) {
+    return std::invoke_r<R>(*std::launder(static_cast<T*>(storage)), std::forward<Args>(args)...);
+  }
+  template<class T>
+  static void Manage(Operation operation, void* target, void* source) noexcept {
+    if (operation == Operation::kRelocate) {
+      T* const object = std::launder(static_cast<T*>(source));
+      ::new(target) T(std::move(*object));
+      object->~T();
+    }
+    else {
+      std::launder(static_cast<T*>(target))->~T();
+    }
+  }
+
+  void reset() noexcept {
+    if (manage_ != nullptr) {
+      manage_(Operation::kDestroy, storage_, nullptr);
+    }
+    invoke_ = nullptr;
+    manage_ = nullptr;
+  }
+  /// Takes over the callable of `rhs`, leaving it empty. `*this` must be empty.
+  void move_from(InplaceFunction& rhs) noexcept {
+    if (rhs.manage_ != nullptr) {
+      rhs.manage_(Operation::kRelocate, storage_, rhs.storage_);
+    }
+    else if (rhs.invoke_ != nullptr) {
+      memcpy(storage_, rhs.storage_, Capacity);
+    }
+    invoke_ = std::exchange(rhs.invoke_, nullptr);
+    manage_ = std::exchange(rhs.manage_, nullptr);
+  }
+
+  InvokeFunction invoke_ = nullptr;
+  ManageFunction manage_ = nullptr;
+  alignas(Alignment) mutable std::byte storage_[Capacity];
+};
+
+template<class Signature>
+class FunctionRef;
+
+/// Non-owning reference to a callable, for callback parameters that are only called during the call they are passed
+/// to. Two pointers, trivially copyable, never allocates. Arguments are forwarded as by `InplaceFunction`.
+/// The referenced callable must outlive the `FunctionRef`: binding a temporary lambda is fine for a parameter, but not
+/// for a `FunctionRef` variable.
+template<class R, class ... Args>
+class FunctionRef<R(Args...)> final {
+public:
+  using result_type = R;
+
+  template<class F>
+    requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && !std::is_function_v<std::remove_reference_t<F>> && std::is_invocable_r_v<R, F&, Args...>)
+  FunctionRef(F&& function) noexcept :
+    invoke_(&InvokeObject<std::remove_reference_t<F>>)
+  {
+    target_.object = const_cast<void*>(static_cast<void const*>(std::addressof(function)));
+  }
+  /// Functions are referenced through their address, which must not be null; no object needs to outlive the
+  /// `FunctionRef`.
+  template<class F>
+    requires (std::is_function_v<F> && std::is_invocable_r_v<R, F&, Args...>)
+  FunctionRef(F* function) noexcept :
+    invoke_(&InvokeFunction<F>)
+  {
+    target_.function = reinterpret_cast<void (*)()>(function);
+  }
+
+  FunctionRef(FunctionRef const&) noexcept = default;
+  FunctionRef& operator=(FunctionRef const&) noexcept = default;
+
+  R operator()(Args... args) const {
+    return invoke_(target_, std::forward<Args>(args)...);
+  }
+
+private:
+  union Target {
+    void* object;
+    void (*function)();
+  };
+
+  template<class T>
+  static R InvokeObject(Target target, detail::function_forward_t<Args> ... args) {
+    return std::invoke_r<R>(*static_cast<T*>(target.object), std::forward<Args>(args)...);
+  }
+  template<class F>
+  static R InvokeFunction(Target target, detail::function_forward_t<Args> ... args) {
+    return std::invoke_r<R>(reinterpret_cast<F*>(target.function), std::forward<Args>(args)...);
+  }
+
+  Target target_;
+  R (*invoke_)(Target target, detail::function_forward_t<Args> ... args);
+};
+
+} // namespace mbase
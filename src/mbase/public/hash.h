@@ -6,6 +6,7 @@
 
 #include <type_traits>
 #include <string>
+#include <string_view>
 
 // public project headers -------------------------------
 #include "mbase/public/platform.h"
@@ -149,6 +150,36 @@ using HasherSizeT = HasherN<detail::integer_traits<size_t>::stdint_type>;
 
 using Hasher = Hasher64;
 
+/// `std::hash`-like functor computing `Hasher64` values; the default hasher of mbase hash containers.
+/// Transparent for string-like keys only: anything convertible to `std::string_view` hashes like that view, so
+/// `std::string` keys can be looked up with `std::string_view` or `char const*`. Other values hash as their bytes, so
+/// containers convert other lookup keys to their key type first (see `detail::KeyHasher`): an `int` and the equal
+/// `uint64_t` hash differently.
+struct Hash64 final {
+  using is_transparent = void;
+  template<class K>
+  static constexpr bool kIsTransparentFor = std::is_convertible_v<K const&, std::string_view>;
+
+  template<class T>
+  uint64_t operator()(T const& value) const {
+    if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+      std::string_view const view(value);
+      return Hasher64::ComputeArray(view.data(), view.size());
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+      // -0.0 == 0.0, so both must hash alike.
+      return Hasher64::Compute(value == T(0) ? T(0) : value);
+    }
+    else if constexpr (detail::is_arithmetic_or_enum_v<T> || detail::TypeHasData<T>::value) {
+      return Hasher64::Compute(value);
+    }
+    else {
+      static_assert(std::has_unique_object_representations_v<T>, "Provide a hasher for T");
+      return Hasher64::ComputePod(value);
+    }
+  }
+};
+
 namespace detail {
 
 inline void hash_combine_impl(size_t& seed, size_t value)
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <chrono>
-#include <functional>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
@@ -9,6 +9,8 @@
 
 #include "source_location/source_location.hpp"
 
+#include "mbase/public/function.h"
+
 #ifdef _MSC_VER
 # pragma warning(push)
 // Defensive: silence C4459 if a fmt version we pin starts shadowing names internally.
@@ -56,7 +58,9 @@ public:
     kCritical
   };
 
-  using LogCallback = std::function<void(Level, std::chrono::system_clock::time_point, std::string_view)>;
+  /// Callables capturing up to `kLogCallbackCapacity` bytes; capture a pointer to larger state.
+  static constexpr size_t kLogCallbackCapacity = 4 * sizeof(void*);
+  using LogCallback = InplaceFunction<void(Level, std::chrono::system_clock::time_point, std::string_view), kLogCallbackCapacity>;
 
   static void Initialize();
   static void Shutdown();
@@ -67,39 +71,45 @@ public:
   /// takes an already-formatted payload.
   static void LogImpl(MBASE_LOG_TAG_ARGUMENT, Level level, std::string_view payload);
 
+  /// Payloads up to this many characters are formatted on the stack, without heap allocation.
+  static constexpr size_t kInlinePayloadCapacity = 256;
+  using PayloadBuffer = fmt::basic_memory_buffer<char, kInlinePayloadCapacity>;
+
   template<typename... Args>
   static void Log(MBASE_LOG_TAG_ARGUMENT, Level level, fmt::format_string<Args...> fmt, Args &&...args) {
-    LogImpl(tag, level, fmt::format(fmt, std::forward<Args>(args)...));
+    PayloadBuffer payload;
+    fmt::format_to(std::back_inserter(payload), fmt, std::forward<Args>(args)...);
+    LogImpl(tag, level, std::string_view(payload.data(), payload.size()));
   }
 
   template<typename... Args>
   static void Trace(MBASE_LOG_TAG_ARGUMENT, fmt::format_string<Args...> fmt, Args &&...args) {
-    LogImpl(tag, Level::kTrace, fmt::format(fmt, std::forward<Args>(args)...));
+    Log(tag, Level::kTrace, fmt, std::forward<Args>(args)...);
   }
 
   template<typename... Args>
   static void Debug(MBASE_LOG_TAG_ARGUMENT, fmt::format_string<Args...> fmt, Args &&...args) {
-    LogImpl(tag, Level::kDebug, fmt::format(fmt, std::forward<Args>(args)...));
+    Log(tag, Level::kDebug, fmt, std::forward<Args>(args)...);
   }
 
   template<typename... Args>
   static void Info(MBASE_LOG_TAG_ARGUMENT, fmt::format_string<Args...> fmt, Args &&...args) {
-    LogImpl(tag, Level::kInfo, fmt::format(fmt, std::forward<Args>(args)...));
+    Log(tag, Level::kInfo, fmt, std::forward<Args>(args)...);
   }
 
   template<typename... Args>
   static void Warn(MBASE_LOG_TAG_ARGUMENT, fmt::format_string<Args...> fmt, Args &&...args) {
-    LogImpl(tag, Level::kWarn, fmt::format(fmt, std::forward<Args>(args)...));
+    Log(tag, Level::kWarn, fmt, std::forward<Args>(args)...);
   }
 
   template<typename... Args>
   static void Error(MBASE_LOG_TAG_ARGUMENT, fmt::format_string<Args...> fmt, Args &&...args) {
-    LogImpl(tag, Level::kError, fmt::format(fmt, std::forward<Args>(args)...));
+    Log(tag, Level::kError, fmt, std::forward<Args>(args)...);
   }
 
   template<typename... Args>
   static void Critical(MBASE_LOG_TAG_ARGUMENT, fmt::format_string<Args...> fmt, Args &&...args) {
-    LogImpl(tag, Level::kCritical, fmt::format(fmt, std::forward<Args>(args)...));
+    Log(tag, Level::kCritical, fmt, std::forward<Args>(args)...);
   }
 
   /// mbase-owned dispatch sink interface. Callers can register a `LogCallback`
@@ -112,7 +122,7 @@ public:
     IDistSink(IDistSink&&) = delete;
     IDistSink& operator=(IDistSink&&) = delete;
 
-    virtual void AddCallback(std::string const& name, LogCallback const& value) = 0;
+    virtual void AddCallback(std::string const& name, LogCallback value) = 0;
     virtual void RemoveCallback(std::string const& name) = 0;
 
   protected:
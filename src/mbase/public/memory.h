@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 #include <memory>
+#include <memory_resource>
 
 namespace mbase {
 
@@ -12,4 +16,45 @@ template<class T, class TDeleter, class ... Args>
 [[nodiscard]] void* AlignedAlloc(uint64_t size, uint64_t alignment);
 void AlignedFree(void* block);
 
+// Allocators used by mbase containers for their heap storage.
+// An allocator provides:
+//   void* allocate(size_t size, size_t alignment);
+//   void deallocate(void* block, size_t size, size_t alignment);
+//   bool operator==(allocator const&) const; // `true` if either can free blocks allocated by the other.
+// Stateless allocators occupy no space in the containers that hold them, and are assumed to always compare equal.
+
+/// Stateless allocator forwarding to `AlignedAlloc`/`AlignedFree`. Default for mbase containers.
+struct AlignedAllocator final {
+  [[nodiscard]] void* allocate(size_t size, size_t alignment) {
+    return AlignedAlloc(size, alignment);
+  }
+  void deallocate(void* block, [[maybe_unused]] size_t size, [[maybe_unused]] size_t alignment) {
+    AlignedFree(block);
+  }
+
+  bool operator==(AlignedAllocator const&) const noexcept { return true; }
+};
+
+/// Allocator drawing from a `std::pmr::memory_resource`, e.g. a `std::pmr::monotonic_buffer_resource` used as a
+/// per-frame arena. The resource must outlive every container using it.
+class PmrAllocator final {
+public:
+  PmrAllocator() noexcept : resource_(std::pmr::get_default_resource()) {}
+  PmrAllocator(std::pmr::memory_resource* resource) noexcept : resource_(resource) {}
+
+  [[nodiscard]] void* allocate(size_t size, size_t alignment) {
+    return resource_->allocate(size, alignment);
+  }
+  void deallocate(void* block, size_t size, size_t alignment) {
+    resource_->deallocate(block, size, alignment);
+  }
+
+  [[nodiscard]] std::pmr::memory_resource* resource() const noexcept { return resource_; }
+
+  bool operator==(PmrAllocator const& rhs) const noexcept { return resource_->is_equal(*rhs.resource_); }
+
+private:
+  std::pmr::memory_resource* resource_;
+};
+
 } // namespace mbase
@@ -76,6 +76,22 @@
 #define MBASE_PLATFORM_X86 (MBASE_PLATFORM_X86_32 || MBASE_PLATFORM_X86_64)
 #define MBASE_PLATFORM_AARCH (MBASE_PLATFORM_AARCH32 || MBASE_PLATFORM_AARCH64)
 
+// ------------------------------------------------------
+// SIMD instruction set availability (compile-time)
+//
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define MBASE_PLATFORM_SSE2 1
+#else
+# define MBASE_PLATFORM_SSE2 0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+# define MBASE_PLATFORM_NEON 1
+#else
+# define MBASE_PLATFORM_NEON 0
+#endif
+
 // ------------------------------------------------------
 // Endianess detection macros
 // Taken from: https://stackoverflow.com/a/79281141/4093267 by sleeptightAnsiC
@@ -2,11 +2,12 @@
 
 // c++ headers ------------------------------------------
 #include <chrono>
-#include <string>
+#include <string_view>
 
 // public project headers -------------------------------
 #include "mbase/public/access.h"
 #include "mbase/public/pp.h"
+#include "mbase/public/container/small_string.h"
 
 #define MBASE_SCOPED_TIMER(label) mbase::ScopedTimer MBASE_PP_CONCAT(mbase_scoped_timer_, __COUNTER__)(label);
 
@@ -16,8 +17,8 @@ class ScopedTimer final {
 public:
   using Clock = std::chrono::high_resolution_clock;
 
-  explicit ScopedTimer(std::string label) :
-    label_(std::move(label))
+  explicit ScopedTimer(std::string_view label) :
+    label_(label)
   {
     this->MarkStart();
   }
@@ -29,7 +30,7 @@ private:
   void MarkEnd();
   void Report() const;
 
-  std::string label_;
+  SmallString<64> label_;
 
   Clock::time_point start_;
   Clock::time_point end_;
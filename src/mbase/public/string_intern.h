@@ -0,0 +1,97 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <compare>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+// public project headers -------------------------------
+#include "mbase/public/access.h"
+
+namespace mbase {
+
+/// Thread-safe pool mapping strings to compact, stable 32-bit IDs.
+/// Interned characters live in arena chunks until the pool is destroyed, so views and `c_str` pointers stay valid.
+/// - `View(id)` is lock-free: an index into a segmented table that never moves.
+/// - `Find(string)` is lock-free: a probe of an open-addressing table of `Hasher64` tags and IDs, published atomically.
+/// - `Intern(string)` takes the `Find` path first and only locks to insert a new string.
+/// ID 0 is the empty string.
+class StringInternPool final {
+public:
+  StringInternPool();
+  ~StringInternPool();
+  MBASE_DISALLOW_COPY_MOVE(StringInternPool);
+
+  /// The process-wide pool used by `InternedString`.
+  static StringInternPool& Global();
+
+  /// ID of `s`, interning it first if needed.
+  [[nodiscard]] uint32_t Intern(std::string_view s);
+  /// ID of `s` if it has been interned.
+  [[nodiscard]] std::optional<uint32_t> Find(std::string_view s) const;
+
+  /// `id` must have been returned by this pool. The view is null-terminated.
+  [[nodiscard]] std::string_view View(uint32_t id) const;
+
+  [[nodiscard]] size_t Size() const;
+
+private:
+  struct State;
+  std::unique_ptr<State> state_;
+};
+
+/// Handle to a string interned in `StringInternPool::Global()`.
+/// Equality and hashing work on the ID, in O(1); ordering is by ID, not lexicographic.
+class InternedString final {
+public:
+  constexpr InternedString() = default;
+  explicit InternedString(std::string_view s) : id_(StringInternPool::Global().Intern(s)) {}
+
+  /// `id` must have been returned by the global pool.
+  static constexpr InternedString FromId(uint32_t id) { return InternedString(id, 0); }
+
+  /// Looks `s` up without interning it.
+  static std::optional<InternedString> Find(std::string_view s) {
+    auto id = StringInternPool::Global().Find(s);
+    return id ? std::optional<InternedString>(FromId(*id)) : std::nullopt;
+  }
+
+  [[nodiscard]] constexpr uint32_t Id() const { return id_; }
+  [[nodiscard]] constexpr bool IsEmpty() const { return id_ == 0; }
+
+  [[nodiscard]] std::string_view View() const { return StringInternPool::Global().View(id_); }
+  [[nodiscard]] char const* CStr() const { return View().data(); }
+  explicit operator std::string_view() const { return View(); }
+
+  constexpr bool operator==(InternedString const& rhs) const = default;
+  constexpr std::strong_ordering operator<=>(InternedString const& rhs) const = default;
+
+  struct Hasher final {
+    size_t operator()(InternedString const& v) const {
+      return std::hash<uint32_t>{}(v.id_);
+    }
+  };
+
+private:
+  constexpr InternedString(uint32_t id, int) : id_(id) {}
+
+  uint32_t id_ = 0;
+};
+
+} // namespace mbase
+
+namespace std {
+
+template<>
+struct hash<mbase::InternedString> {
+  size_t operator()(mbase::InternedString const& v) const {
+    return mbase::InternedString::Hasher{}(v);
+  }
+};
+
+} // namespace std
@@ -17,7 +17,7 @@ class TypesafeHandle {
 public:
   using StorageType = TStorage;
 
-  static TypesafeHandle Invalid() { return TypesafeHandle(InvalidValue); }
+  static constexpr TypesafeHandle Invalid() { return TypesafeHandle(InvalidValue); }
 
   constexpr TypesafeHandle() = default;
   ~TypesafeHandle() = default;
@@ -22,6 +22,15 @@
 # endif
 #endif
 
+// See: https://en.cppreference.com/w/cpp/language/attributes/no_unique_address
+#ifndef MBASE_NO_UNIQUE_ADDRESS
+# ifdef _MSC_VER
+#  define MBASE_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+# else
+#  define MBASE_NO_UNIQUE_ADDRESS [[no_unique_address]]
+# endif
+#endif
+
 # define MBASE_STATIC_ASSERT_NO_PADDING(type, last_member) \
   static_assert(offsetof(type, last_member) == sizeof(type) - sizeof(type::last_member))
 
@@ -32,4 +41,58 @@ constexpr typename std::underlying_type<T>::type UnderlyingCast(T value) {
   return static_cast<typename std::underlying_type<T>::type>(value);
 }
 
+/// `true` if `T` declares `is_transparent`, enabling heterogeneous lookup in associative containers.
+template<class T, class U = void>
+inline constexpr bool is_transparent_v = false;
+template<class T>
+inline constexpr bool is_transparent_v<T, std::void_t<typename T::is_transparent>> = true;
+
+/// `true` if the transparent functor `T` handles lookup keys of type `K` consistently with the container's own keys.
+/// `T` may restrict this to some `K` with a `template<class K> static constexpr bool kIsTransparentFor` member.
+template<class T, class K, class U = void>
+inline constexpr bool is_transparent_for_v = is_transparent_v<T>;
+template<class T, class K>
+inline constexpr bool is_transparent_for_v<T, K, std::void_t<decltype(T::template kIsTransparentFor<K>)>> =
+  is_transparent_v<T> && T::template kIsTransparentFor<K>;
+
+namespace detail {
+
+/// Lookup key type of associative containers: `K` with transparent functors, `TKey` otherwise.
+template<bool Transparent>
+struct KeyArg final {
+  template<class K, class TKey>
+  using type = TKey;
+};
+template<>
+struct KeyArg<true> final {
+  template<class K, class TKey>
+  using type = K;
+};
+
+/// The hasher of a hash container keyed by `TKey`: hashes lookup keys `THash` is not transparent for (see
+/// `is_transparent_for_v`) as the `TKey` they convert to, so that they find the key they compare equal to.
+template<class THash, class TKey>
+class KeyHasher final {
+public:
+  KeyHasher() = default;
+  explicit KeyHasher(THash const& hash) : hash_(hash) {}
+
+  [[nodiscard]] THash const& get() const noexcept { return hash_; }
+
+  template<class K>
+  [[nodiscard]] auto operator()(K const& key) const {
+    if constexpr (std::is_same_v<K, TKey> || is_transparent_for_v<THash, K>) {
+      return hash_(key);
+    }
+    else {
+      return hash_(static_cast<TKey>(key));
+    }
+  }
+
+private:
+  MBASE_NO_UNIQUE_ADDRESS THash hash_ {};
+};
+
+} // namespace detail
+
 } // namespace mbase
@@ -0,0 +1,83 @@
+// `HyperLogLog` serialization: sparse and dense sketches survive a round trip, including sparse entries at adjacent
+// indices, whose deltas are smaller than a rank field.
+
+// c++ headers ------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+// public project headers -------------------------------
+#include "mbase/public/container/hyper_log_log.h"
+
+#include "test.h"
+
+namespace {
+
+using Sketch = mbase::HyperLogLog<>;
+
+[[nodiscard]] std::vector<std::byte> Serialize(Sketch const& sketch) {
+  std::vector<std::byte> bytes(sketch.serialized_size());
+  MBASE_TEST_CHECK(sketch.serialize(bytes) == bytes.size());
+  return bytes;
+}
+
+[[nodiscard]] std::vector<std::byte> Bytes(std::initializer_list<int> values) {
+  std::vector<std::byte> bytes;
+  for (int value : values) {
+    bytes.push_back(std::byte(value));
+  }
+  return bytes;
+}
+
+void TestAdjacentSparseIndices() {
+  // Sparse kind, precision 14, 2 entries: index 5 rank 10 (5 << 6 | 10 = 330, varint 0xCA 0x02), then index 6 rank 1
+  // (6 << 6 | 1 = 385, a delta of 55).
+  std::vector<std::byte> const bytes = Bytes({ 1, 14, 2, 0xCA, 0x02, 55 });
+  Sketch const sketch = Sketch::Deserialize(bytes);
+  MBASE_TEST_CHECK(sketch.is_sparse());
+  MBASE_TEST_CHECK(sketch.estimate() > 1.5 && sketch.estimate() < 2.5);
+  MBASE_TEST_CHECK(Serialize(sketch) == bytes);
+}
+
+void TestMalformedSparseEntries() {
+  auto const rejects = [](std::initializer_list<int> values) {
+    try {
+      static_cast<void>(Sketch::Deserialize(Bytes(values)));
+    }
+    catch (std::invalid_argument const&) {
+      return true;
+    }
+    return false;
+  };
+  // The same index twice, then an index lower than the previous one (the delta wraps around 2^64).
+  MBASE_TEST_CHECK(rejects({ 1, 14, 2, 0xCA, 0x02, 1 }));
+  MBASE_TEST_CHECK(rejects({ 1, 14, 2, 0xCA, 0x02, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 }));
+  // A zero rank.
+  MBASE_TEST_CHECK(rejects({ 1, 14, 1, 0xC0, 0x02 }));
+}
+
+void TestRoundTrip(uint64_t key_count) {
+  Sketch sketch;
+  for (uint64_t key = 0; key != key_count; ++key) {
+    sketch.insert(key);
+  }
+  std::vector<std::byte> const bytes = Serialize(sketch);
+  Sketch const restored = Sketch::Deserialize(bytes);
+  MBASE_TEST_CHECK(restored.is_sparse() == sketch.is_sparse());
+  MBASE_TEST_CHECK(restored.estimate() == sketch.estimate());
+  MBASE_TEST_CHECK(Serialize(restored) == bytes);
+}
+
+} // namespace
+
+int main() {
+  TestAdjacentSparseIndices();
+  TestMalformedSparseEntries();
+  TestRoundTrip(0);
+  TestRoundTrip(1000);
+  TestRoundTrip(100000);
+  return mbase::test::g_failure_count;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// c++ headers ------------------------------------------
+#include <cstdio>
+
+namespace mbase::test {
+
+/// Number of failed `MBASE_TEST_CHECK`s; `main` returns it.
+inline int g_failure_count = 0;
+
+} // namespace mbase::test
+
+/// Reports `condition` with its location if it does not hold, and carries on.
+#define MBASE_TEST_CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      ++::mbase::test::g_failure_count; \
+    } \
+  } while (false)